@@ -5,9 +5,16 @@ ASSEMBLY := engine
 EXTENSION := .so
 COMPILER_FLAGS := -g -fdeclspec -fPIC
 INCLUDE_FLAGS := -Iengine/src -I$(VULKAN_SDK)/include
-LINKER_FLAGS := -g -shared -lvulkan -lxcb -lX11 -lX11-xcb -lxkbcommon -L$(VULKAN_SDK)/lib -L/usr/X11R6/lib
+LINKER_FLAGS := -g -shared -lvulkan -lxcb -lX11 -lX11-xcb -lxkbcommon -lpthread -lm -L$(VULKAN_SDK)/lib -L/usr/X11R6/lib
 DEFINES := -D_DEBUG -DKEXPORT
 
+# Builds with a sanitizer, e.g. `make -f Makefile.engine.linux.mak
+# SANITIZE=thread` to run the tests under ThreadSanitizer
+ifdef SANITIZE
+COMPILER_FLAGS += -fsanitize=$(SANITIZE)
+LINKER_FLAGS += -fsanitize=$(SANITIZE)
+endif
+
 # Make does not offer a recursive wildcard function, so here's one:
 #rwildcard=$(wildcard $1$2) $(foreach d,$(wildcard $1*),$(call rwildcard,$d/,$2))
 
@@ -0,0 +1,49 @@
+BUILD_DIR := bin
+OBJ_DIR := obj
+
+ASSEMBLY := tests
+EXTENSION := 
+COMPILER_FLAGS := -g -fdeclspec -fPIC
+INCLUDE_FLAGS := -Iengine/src -Itests/src
+LINKER_FLAGS := -L./$(BUILD_DIR)/ -lengine -lpthread -Wl,-rpath,.
+DEFINES := -D_DEBUG -DKIMPORT
+
+# e.g. `make -f Makefile.tests.linux.mak SANITIZE=thread`, with the engine
+# built the same way
+ifdef SANITIZE
+COMPILER_FLAGS += -fsanitize=$(SANITIZE)
+LINKER_FLAGS += -fsanitize=$(SANITIZE)
+endif
+
+# Make does not offer a recursive wildcard function, so here's one:
+#rwildcard=$(wildcard $1$2) $(foreach d,$(wildcard $1*),$(call rwildcard,$d/,$2))
+
+SRC_FILES := $(shell find $(ASSEMBLY) -name *.c)		# .c files
+DIRECTORIES := $(shell find $(ASSEMBLY) -type d)		# directories with .h files
+OBJ_FILES := $(SRC_FILES:%=$(OBJ_DIR)/%.o)		# compiled .o objects
+
+all: scaffold compile link
+
+.PHONY: scaffold
+scaffold: # create build directory
+	@echo Scaffolding folder structure...
+	@mkdir -p $(addprefix $(OBJ_DIR)/,$(DIRECTORIES))
+	@echo Done.
+
+.PHONY: link
+link: scaffold $(OBJ_FILES) # link
+	@echo Linking $(ASSEMBLY)...
+	clang $(OBJ_FILES) -o $(BUILD_DIR)/$(ASSEMBLY)$(EXTENSION) $(LINKER_FLAGS)
+
+.PHONY: compile
+compile: #compile .c files
+	@echo Compiling...
+
+.PHONY: clean
+clean: # clean build directory
+	rm -rf $(BUILD_DIR)\$(ASSEMBLY)
+	rm -rf $(OBJ_DIR)\$(ASSEMBLY)
+
+$(OBJ_DIR)/%.c.o: %.c # compile .c to .o object
+	@echo   $<...
+	@clang $< $(COMPILER_FLAGS) -c -o $@ $(DEFINES) $(INCLUDE_FLAGS)
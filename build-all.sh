@@ -27,4 +27,11 @@ then
 echo "Error:"$ERRORLEVEL && exit
 fi
 
+make -f Makefile.tests.linux.mak all
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
 echo "All assemblies built successfully."
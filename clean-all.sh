@@ -22,3 +22,14 @@ make -f Makefile.testbed.linux.mak clean
 ERRORLEVEL=$?
 if [ $ERRORLEVEL -ne 0 ]
 then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+make -f Makefile.tests.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
+echo "All assemblies cleaned successfully."
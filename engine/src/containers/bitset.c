@@ -0,0 +1,178 @@
+#include "bitset.h"
+
+#include "core/kmemory.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BITSET_SSE2 1
+#else
+#define BITSET_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static u32 popcount64(u64 word) { return (u32)__popcnt64(word); }
+
+static u32 count_trailing_zeros64(u64 word) {
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return index;
+}
+#else
+static u32 popcount64(u64 word) { return __builtin_popcountll(word); }
+
+static u32 count_trailing_zeros64(u64 word) { return __builtin_ctzll(word); }
+#endif
+
+#if BITSET_SSE2
+// Applies `op` to two words at a time, leaving `i` at the first word left over
+#define BITSET_SSE2_LOOP(out, a, b, word_count, op)                            \
+    for (; i + 2 <= word_count; i += 2) {                                      \
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));                \
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));                \
+        _mm_storeu_si128((__m128i *)(out + i), op);                            \
+    }
+#else
+#define BITSET_SSE2_LOOP(out, a, b, word_count, op)
+#endif
+
+void _bitset_and(u64 *out, const u64 *a, const u64 *b, u32 word_count) {
+    u32 i = 0;
+    BITSET_SSE2_LOOP(out, a, b, word_count, _mm_and_si128(va, vb))
+    for (; i < word_count; ++i) {
+        out[i] = a[i] & b[i];
+    }
+}
+
+void _bitset_or(u64 *out, const u64 *a, const u64 *b, u32 word_count) {
+    u32 i = 0;
+    BITSET_SSE2_LOOP(out, a, b, word_count, _mm_or_si128(va, vb))
+    for (; i < word_count; ++i) {
+        out[i] = a[i] | b[i];
+    }
+}
+
+void _bitset_andnot(u64 *out, const u64 *a, const u64 *b, u32 word_count) {
+    u32 i = 0;
+    // _mm_andnot_si128 negates its first operand
+    BITSET_SSE2_LOOP(out, a, b, word_count, _mm_andnot_si128(vb, va))
+    for (; i < word_count; ++i) {
+        out[i] = a[i] & ~b[i];
+    }
+}
+
+void _bitset_xor(u64 *out, const u64 *a, const u64 *b, u32 word_count) {
+    u32 i = 0;
+    BITSET_SSE2_LOOP(out, a, b, word_count, _mm_xor_si128(va, vb))
+    for (; i < word_count; ++i) {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+b8 _bitset_any(const u64 *words, u32 word_count) {
+    u64 bits = 0;
+    for (u32 i = 0; i < word_count; ++i) {
+        bits |= words[i];
+    }
+    return bits != 0;
+}
+
+#if BITSET_SSE2
+// Checks `op` for any set bit two words at a time, returning `hit` on the
+// first one and leaving `i` at the first word left over
+#define BITSET_SSE2_ANY(a, b, word_count, op, hit)                             \
+    for (; i + 2 <= word_count; i += 2) {                                      \
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));                \
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));                \
+        __m128i zero = _mm_cmpeq_epi8(op, _mm_setzero_si128());                \
+        if (_mm_movemask_epi8(zero) != 0xFFFF) {                               \
+            return hit;                                                        \
+        }                                                                      \
+    }
+#else
+#define BITSET_SSE2_ANY(a, b, word_count, op, hit)
+#endif
+
+b8 _bitset_differ(const u64 *a, const u64 *b, u32 word_count) {
+    u32 i = 0;
+    BITSET_SSE2_ANY(a, b, word_count, _mm_xor_si128(va, vb), TRUE)
+    for (; i < word_count; ++i) {
+        if (a[i] ^ b[i]) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+b8 _bitset_intersects(const u64 *a, const u64 *b, u32 word_count) {
+    u32 i = 0;
+    BITSET_SSE2_ANY(a, b, word_count, _mm_and_si128(va, vb), TRUE)
+    for (; i < word_count; ++i) {
+        if (a[i] & b[i]) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+b8 _bitset_contains(const u64 *a, const u64 *b, u32 word_count) {
+    u32 i = 0;
+    BITSET_SSE2_ANY(a, b, word_count, _mm_andnot_si128(va, vb), FALSE)
+    for (; i < word_count; ++i) {
+        if (b[i] & ~a[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+u32 _bitset_popcount(const u64 *words, u32 word_count) {
+    u32 count = 0;
+    for (u32 i = 0; i < word_count; ++i) {
+        count += popcount64(words[i]);
+    }
+    return count;
+}
+
+i32 _bitset_find_next_set(const u64 *words, u32 word_count, u32 from) {
+    u32 index = BITSET_WORD(from);
+    if (index >= word_count) {
+        return -1;
+    }
+
+    // Drop the bits below `from` in its word, then skip empty words
+    u64 word = words[index] & (~0ull << (from & 63));
+    while (!word) {
+        if (++index == word_count) {
+            return -1;
+        }
+        word = words[index];
+    }
+    return (i32)(index * 64 + count_trailing_zeros64(word));
+}
+
+b8 bitset_create(u32 bit_count, bitset *out_set) {
+    if (!out_set || !bit_count) {
+        return FALSE;
+    }
+
+    out_set->bit_count = bit_count;
+    out_set->word_count = (bit_count + 63) / 64;
+    out_set->words =
+        kallocate((u64)out_set->word_count * sizeof(u64), MEMORY_TAG_ARRAY);
+    return out_set->words != 0;
+}
+
+void bitset_destroy(bitset *set) {
+    if (!set || !set->words) {
+        return;
+    }
+
+    kfree(set->words, set->word_count * sizeof(u64), MEMORY_TAG_ARRAY);
+    kzero_memory(set, sizeof(bitset));
+}
+
+void bitset_clear_all(bitset *set) {
+    kzero_memory(set->words, set->word_count * sizeof(u64));
+}
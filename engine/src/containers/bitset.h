@@ -0,0 +1,172 @@
+#pragma once
+
+#include "defines.h"
+#include <stdalign.h>
+
+// Word-array kernels behind both bitset types. The bulk operations use SSE2
+// where available and work on two words at a time
+KAPI void _bitset_and(u64 *out, const u64 *a, const u64 *b, u32 word_count);
+KAPI void _bitset_or(u64 *out, const u64 *a, const u64 *b, u32 word_count);
+KAPI void _bitset_andnot(u64 *out, const u64 *a, const u64 *b,
+                         u32 word_count);
+KAPI void _bitset_xor(u64 *out, const u64 *a, const u64 *b, u32 word_count);
+KAPI b8 _bitset_any(const u64 *words, u32 word_count);
+KAPI b8 _bitset_differ(const u64 *a, const u64 *b, u32 word_count);
+KAPI b8 _bitset_intersects(const u64 *a, const u64 *b, u32 word_count);
+// Whether every bit set in b is also set in a
+KAPI b8 _bitset_contains(const u64 *a, const u64 *b, u32 word_count);
+KAPI u32 _bitset_popcount(const u64 *words, u32 word_count);
+KAPI i32 _bitset_find_next_set(const u64 *words, u32 word_count, u32 from);
+
+#define BITSET_WORD(bit) ((bit) >> 6)
+#define BITSET_MASK(bit) (1ull << ((bit)&63))
+
+/**
+ * A fixed set of 256 bits, 32 bytes in total, e.g. one flag per key code.
+ * A zeroed struct is an empty set.
+ *
+ * Iterate over the set bits with:
+ *     for (i32 bit = bitset256_find_next_set(&set, 0); bit >= 0;
+ *          bit = bitset256_find_next_set(&set, bit + 1)) { ... }
+ */
+typedef struct bitset256 {
+    alignas(16) u64 words[4];
+} bitset256;
+
+KINLINE void bitset256_set(bitset256 *set, u32 bit) {
+    set->words[BITSET_WORD(bit)] |= BITSET_MASK(bit);
+}
+
+KINLINE void bitset256_clear(bitset256 *set, u32 bit) {
+    set->words[BITSET_WORD(bit)] &= ~BITSET_MASK(bit);
+}
+
+KINLINE void bitset256_assign(bitset256 *set, u32 bit, b8 value) {
+    if (value) {
+        bitset256_set(set, bit);
+    } else {
+        bitset256_clear(set, bit);
+    }
+}
+
+KINLINE b8 bitset256_test(const bitset256 *set, u32 bit) {
+    return (set->words[BITSET_WORD(bit)] & BITSET_MASK(bit)) != 0;
+}
+
+// out = a & b
+KINLINE void bitset256_and(bitset256 *out, const bitset256 *a,
+                           const bitset256 *b) {
+    _bitset_and(out->words, a->words, b->words, 4);
+}
+
+// out = a | b
+KINLINE void bitset256_or(bitset256 *out, const bitset256 *a,
+                          const bitset256 *b) {
+    _bitset_or(out->words, a->words, b->words, 4);
+}
+
+// out = a & ~b
+KINLINE void bitset256_andnot(bitset256 *out, const bitset256 *a,
+                              const bitset256 *b) {
+    _bitset_andnot(out->words, a->words, b->words, 4);
+}
+
+// out = a ^ b
+KINLINE void bitset256_xor(bitset256 *out, const bitset256 *a,
+                           const bitset256 *b) {
+    _bitset_xor(out->words, a->words, b->words, 4);
+}
+
+KINLINE b8 bitset256_any(const bitset256 *set) {
+    return _bitset_any(set->words, 4);
+}
+
+KINLINE b8 bitset256_differ(const bitset256 *a, const bitset256 *b) {
+    return _bitset_differ(a->words, b->words, 4);
+}
+
+KINLINE b8 bitset256_intersects(const bitset256 *a, const bitset256 *b) {
+    return _bitset_intersects(a->words, b->words, 4);
+}
+
+// Whether every bit set in b is also set in a
+KINLINE b8 bitset256_contains(const bitset256 *a, const bitset256 *b) {
+    return _bitset_contains(a->words, b->words, 4);
+}
+
+KINLINE u32 bitset256_popcount(const bitset256 *set) {
+    return _bitset_popcount(set->words, 4);
+}
+
+/**
+ * @returns The first set bit at or after `from`, or -1 if there is none
+ */
+KINLINE i32 bitset256_find_next_set(const bitset256 *set, u32 from) {
+    return _bitset_find_next_set(set->words, 4, from);
+}
+
+/**
+ * A heap-allocated set with a size chosen at creation. The binary operations
+ * require both inputs and the output to have the same size.
+ */
+typedef struct bitset {
+    u32 bit_count;
+    u32 word_count;
+    u64 *words;
+} bitset;
+
+/**
+ * Creates a bitset with every bit cleared
+ * @param bit_count The number of bits in the set
+ * @param out_set A pointer to hold the created set
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 bitset_create(u32 bit_count, bitset *out_set);
+
+KAPI void bitset_destroy(bitset *set);
+
+KAPI void bitset_clear_all(bitset *set);
+
+KINLINE void bitset_set(bitset *set, u32 bit) {
+    set->words[BITSET_WORD(bit)] |= BITSET_MASK(bit);
+}
+
+KINLINE void bitset_clear(bitset *set, u32 bit) {
+    set->words[BITSET_WORD(bit)] &= ~BITSET_MASK(bit);
+}
+
+KINLINE b8 bitset_test(const bitset *set, u32 bit) {
+    return (set->words[BITSET_WORD(bit)] & BITSET_MASK(bit)) != 0;
+}
+
+KINLINE void bitset_and(bitset *out, const bitset *a, const bitset *b) {
+    _bitset_and(out->words, a->words, b->words, out->word_count);
+}
+
+KINLINE void bitset_or(bitset *out, const bitset *a, const bitset *b) {
+    _bitset_or(out->words, a->words, b->words, out->word_count);
+}
+
+KINLINE void bitset_andnot(bitset *out, const bitset *a, const bitset *b) {
+    _bitset_andnot(out->words, a->words, b->words, out->word_count);
+}
+
+KINLINE b8 bitset_any(const bitset *set) {
+    return _bitset_any(set->words, set->word_count);
+}
+
+KINLINE b8 bitset_intersects(const bitset *a, const bitset *b) {
+    return _bitset_intersects(a->words, b->words, a->word_count);
+}
+
+KINLINE b8 bitset_contains(const bitset *a, const bitset *b) {
+    return _bitset_contains(a->words, b->words, a->word_count);
+}
+
+KINLINE u32 bitset_popcount(const bitset *set) {
+    return _bitset_popcount(set->words, set->word_count);
+}
+
+KINLINE i32 bitset_find_next_set(const bitset *set, u32 from) {
+    return _bitset_find_next_set(set->words, set->word_count, from);
+}
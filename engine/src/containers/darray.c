@@ -2,20 +2,91 @@
 
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "core/virtual_arena.h"
 
-void *_darray_create(u64 length, u64 stride) {
+// A virtual array's reservation starts with its arena, followed by the header
+// and the elements
+static virtual_arena *darray_arena(u64 *header) {
+    return (virtual_arena *)header - 1;
+}
+
+// Commits enough of a virtual array's reservation for `capacity` elements
+// and records however many elements the committed pages can hold
+static b8 darray_commit(u64 *header, u64 capacity) {
+    virtual_arena *arena = darray_arena(header);
+    u64 offset = sizeof(virtual_arena) + DARRAY_FIELD_LENGTH * sizeof(u64);
+    u64 size = offset + capacity * header[DARRAY_STRIDE];
+    if (!virtual_arena_commit(arena, size)) {
+        return FALSE;
+    }
+
+    u64 committed = (arena->committed_size - offset) / header[DARRAY_STRIDE];
+    header[DARRAY_CAPACITY] = KMIN(committed, header[DARRAY_RESERVED_CAPACITY]);
+    return TRUE;
+}
+
+// Whether a heap array of this size is mapped straight from the OS, whose
+// pages come zeroed, so that kallocate hands it out without a memset
+static b8 darray_is_large(u64 length, u64 stride) {
+    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
+    return header_size + length * stride >= KMEMORY_LARGE_ALLOCATION_SIZE;
+}
+
+// Allocates a heap array. Only the header is initialized; the elements are
+// zeroed only when `zero` is set
+static u64 *darray_allocate(u64 length, u64 stride, b8 zero) {
     u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
     u64 array_size = length * stride;
-    u64 *new_array = kallocate(header_size + array_size, MEMORY_TAG_DARRAY);
-    kset_memory(new_array, 0, header_size + array_size);
+    u64 *new_array =
+        zero ? kallocate(header_size + array_size, MEMORY_TAG_DARRAY)
+             : kallocate_uninitialized(header_size + array_size,
+                                       MEMORY_TAG_DARRAY);
     new_array[DARRAY_CAPACITY] = length;
     new_array[DARRAY_LENGTH] = 0;
     new_array[DARRAY_STRIDE] = stride;
-    return (void *)(new_array + DARRAY_FIELD_LENGTH);
+    new_array[DARRAY_RESERVED_CAPACITY] = 0;
+    return new_array;
+}
+
+void *_darray_create(u64 length, u64 stride) {
+    u64 *header = darray_allocate(length, stride, TRUE);
+    return (void *)(header + DARRAY_FIELD_LENGTH);
+}
+
+void *_darray_create_virtual(u64 max_length, u64 stride) {
+    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
+    u64 reserve_size =
+        sizeof(virtual_arena) + header_size + max_length * stride;
+
+    virtual_arena arena = {0};
+    if (!max_length ||
+        !virtual_arena_create(reserve_size, MEMORY_TAG_DARRAY, &arena) ||
+        !virtual_arena_commit(&arena, sizeof(virtual_arena) + header_size)) {
+        KERROR("_darray_create_virtual - failed to reserve %llu elements.",
+               max_length);
+        if (arena.base) {
+            virtual_arena_destroy(&arena);
+        }
+        return 0;
+    }
+
+    // Committed pages start out zeroed
+    kcopy_memory(arena.base, &arena, sizeof(virtual_arena));
+    u64 *header = (u64 *)(arena.base + sizeof(virtual_arena));
+    header[DARRAY_STRIDE] = stride;
+    header[DARRAY_RESERVED_CAPACITY] = max_length;
+    darray_commit(header, 0);
+
+    return (void *)(header + DARRAY_FIELD_LENGTH);
 }
 
 void _darray_destroy(void *array) {
     u64 *header = (u64 *)array - DARRAY_FIELD_LENGTH;
+    if (header[DARRAY_RESERVED_CAPACITY]) {
+        virtual_arena_destroy(darray_arena(header));
+        return;
+    }
+
     u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
     u64 array_size = header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
     u64 total_size = header_size + array_size;
@@ -32,16 +103,62 @@ void _darray_field_set(void *array, u64 field, u64 value) {
     header[field] = value;
 }
 
-void *_darray_resize(void *array) {
+// Moves an array into a new heap block with the given capacity, which must
+// hold its length. Only the live elements are copied and only the unused tail
+// is zeroed, unless the block is large and so already zeroed
+static void *darray_move_to_heap(void *array, u64 capacity) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
-    void *temp =
-        _darray_create(DARRAY_RESIZE_FACTOR * darray_capacity(array), stride);
 
-    kcopy_memory(temp, array, length * stride);
+    b8 large = darray_is_large(capacity, stride);
+    u64 *header = darray_allocate(capacity, stride, large);
+    header[DARRAY_LENGTH] = length;
+
+    u8 *elements = (u8 *)(header + DARRAY_FIELD_LENGTH);
+    kcopy_memory(elements, array, length * stride);
+    if (!large) {
+        kzero_memory(elements + length * stride,
+                     (capacity - length) * stride);
+    }
+
     _darray_destroy(array);
+    return elements;
+}
 
-    return temp;
+// Grows an array so it can hold at least `required` elements, aiming for
+// `desired`. Virtual arrays commit up to `desired` within their reservation
+static void *darray_grow_to(void *array, u64 required, u64 desired) {
+    u64 *header = (u64 *)array - DARRAY_FIELD_LENGTH;
+    u64 reserved = header[DARRAY_RESERVED_CAPACITY];
+    if (reserved) {
+        // Grow in place by committing more of the reservation
+        if (required <= reserved &&
+            darray_commit(header, KMIN(desired, reserved))) {
+            return array;
+        }
+
+        KWARN("_darray_resize - virtual array outgrew its reservation of %llu "
+              "elements, moving it to the heap.",
+              reserved);
+    }
+
+    return darray_move_to_heap(array, desired);
+}
+
+// Grows an array so it can hold at least `required` elements, in a single
+// step of at least DARRAY_RESIZE_FACTOR so repeated growth stays amortized
+static void *darray_grow(void *array, u64 required) {
+    u64 capacity = darray_capacity(array);
+    if (required <= capacity) {
+        return array;
+    }
+
+    return darray_grow_to(array, required,
+                          KMAX(required, DARRAY_RESIZE_FACTOR * capacity));
+}
+
+void *_darray_resize(void *array) {
+    return darray_grow(array, darray_capacity(array) + 1);
 }
 
 void *_darray_push(void *array, const void *value_ptr) {
@@ -73,49 +190,115 @@ void *_darray_pop_at(void *array, u64 index, void *dest) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
     if (index >= length) {
-        KERROR(
-            "Index outside the bounds of this array! Length %i, index %index",
-            length, index);
+        KERROR("Index outside the bounds of this array! Length %llu, index "
+               "%llu",
+               length, index);
         return array;
     }
 
-    u64 addr = (u64)array;
-    kcopy_memory(dest, (void *)(addr + (index * stride)), stride);
-
-    if (index != length - 1) {
-        kcopy_memory((void *)(addr + (index * stride)),
-                     (void *)(addr + ((index + 1) * stride)),
-                     stride * (length - index));
-    }
+    kcopy_memory(dest, (u8 *)array + index * stride, stride);
+    _darray_erase_range(array, index, 1);
 
-    _darray_field_set(array, DARRAY_LENGTH, length - 1);
     return array;
 }
 
 void *_darray_insert_at(void *array, u64 index, void *value_ptr) {
+    return _darray_insert_range(array, index, value_ptr, 1);
+}
+
+void *_darray_push_n(void *array, const void *values, u64 count) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
-    if (index >= length) {
-        KERROR(
-            "Index outside of bounds of this array! Length %i, index: %index",
-            length, index);
+
+    array = darray_grow(array, length + count);
+    kcopy_memory((u8 *)array + length * stride, values, count * stride);
+    _darray_field_set(array, DARRAY_LENGTH, length + count);
+
+    return array;
+}
+
+void *_darray_insert_range(void *array, u64 index, const void *values,
+                           u64 count) {
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    if (index > length) {
+        KERROR("Index outside of bounds of this array! Length %llu, index: "
+               "%llu",
+               length, index);
         return array;
     }
 
-    if (length >= darray_capacity(array)) {
-        array = _darray_resize(array);
+    array = darray_grow(array, length + count);
+
+    // The tail and its new position overlap whenever count < length - index
+    u8 *at = (u8 *)array + index * stride;
+    kmove_memory(at + count * stride, at, (length - index) * stride);
+    kcopy_memory(at, values, count * stride);
+    _darray_field_set(array, DARRAY_LENGTH, length + count);
+
+    return array;
+}
+
+void _darray_erase_range(void *array, u64 index, u64 count) {
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    if (index > length || count > length - index) {
+        KERROR("Range outside the bounds of this array! Length %llu, index "
+               "%llu, count %llu",
+               length, index, count);
+        return;
     }
 
-    u64 addr = (u64)array;
+    u8 *at = (u8 *)array + index * stride;
+    kmove_memory(at, at + count * stride, (length - index - count) * stride);
+    _darray_field_set(array, DARRAY_LENGTH, length - count);
+}
 
+void _darray_swap_remove(void *array, u64 index, void *dest) {
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    if (index >= length) {
+        KERROR("Index outside the bounds of this array! Length %llu, index "
+               "%llu",
+               length, index);
+        return;
+    }
+
+    u8 *at = (u8 *)array + index * stride;
+    if (dest) {
+        kcopy_memory(dest, at, stride);
+    }
     if (index != length - 1) {
-        kcopy_memory((void *)(addr + (index + 1) * stride),
-                     (void *)(addr + (index * stride)),
-                     stride * (length - index));
+        kcopy_memory(at, (u8 *)array + (length - 1) * stride, stride);
     }
+    _darray_field_set(array, DARRAY_LENGTH, length - 1);
+}
 
-    kcopy_memory((void *)(addr + (index * stride)), value_ptr, stride);
+void *_darray_reserve_more(void *array, u64 additional) {
+    u64 required = darray_length(array) + additional;
+    if (required <= darray_capacity(array)) {
+        return array;
+    }
 
-    _darray_field_set(array, DARRAY_LENGTH, length + 1);
-    return array;
+    // Reserve exactly what was asked for; later pushes still grow
+    // geometrically from there
+    return darray_grow_to(array, required, required);
+}
+
+void *_darray_shrink_to_fit(void *array) {
+    u64 *header = (u64 *)array - DARRAY_FIELD_LENGTH;
+    u64 length = header[DARRAY_LENGTH];
+    u64 stride = header[DARRAY_STRIDE];
+
+    if (header[DARRAY_RESERVED_CAPACITY]) {
+        u64 offset = sizeof(virtual_arena) + DARRAY_FIELD_LENGTH * sizeof(u64);
+        virtual_arena_decommit(darray_arena(header), offset + length * stride);
+        darray_commit(header, length);
+        return array;
+    }
+
+    if (header[DARRAY_CAPACITY] == length) {
+        return array;
+    }
+    return darray_move_to_heap(array, length);
 }
@@ -2,9 +2,28 @@
 
 #include "defines.h"
 
-enum { DARRAY_CAPACITY, DARRAY_LENGTH, DARRAY_STRIDE, DARRAY_FIELD_LENGTH };
+// DARRAY_RESERVED_CAPACITY is 0 for arrays on the heap. For arrays created
+// with `darray_create_virtual` it is the most elements the array's address
+// space reservation can hold
+enum {
+    DARRAY_CAPACITY,
+    DARRAY_LENGTH,
+    DARRAY_STRIDE,
+    DARRAY_RESERVED_CAPACITY,
+    DARRAY_FIELD_LENGTH
+};
 
 KAPI void *_darray_create(u64 length, u64 stride);
+
+/**
+ * Creates an array inside its own virtual memory reservation. Growing the
+ * array commits more pages in place instead of copying it, so pointers to its
+ * elements stay valid until it exceeds `max_length`
+ * @param max_length The most elements the reservation can hold
+ * @param stride The size of one element in bytes
+ * @returns The new array, or 0/NULL if the address space could not be reserved
+ */
+KAPI void *_darray_create_virtual(u64 max_length, u64 stride);
 KAPI void _darray_destroy(void *array);
 
 KAPI u64 _darray_field_get(void *array, u64 field);
@@ -18,6 +37,59 @@ KAPI void _darray_pop(void *array, void *dest);
 KAPI void *_darray_pop_at(void *array, u64 index, void *dest);
 KAPI void *_darray_insert_at(void *array, u64 index, void *value_ptr);
 
+/**
+ * Appends `count` elements, growing the array at most once
+ * @param array The array to append to
+ * @param values A pointer to `count` contiguous elements
+ * @param count The number of elements to append
+ * @returns The array, which may have moved
+ */
+KAPI void *_darray_push_n(void *array, const void *values, u64 count);
+
+/**
+ * Inserts `count` elements before `index`, growing the array at most once.
+ * Later elements keep their order
+ * @param array The array to insert into
+ * @param index Where to insert. May be equal to the length to append
+ * @param values A pointer to `count` contiguous elements. Must not point into
+ * the array itself
+ * @param count The number of elements to insert
+ * @returns The array, which may have moved
+ */
+KAPI void *_darray_insert_range(void *array, u64 index, const void *values,
+                                u64 count);
+
+/**
+ * Removes `count` elements starting at `index`. Later elements keep their
+ * order
+ * @param array The array to remove from
+ * @param index The first element to remove
+ * @param count The number of elements to remove
+ */
+KAPI void _darray_erase_range(void *array, u64 index, u64 count);
+
+/**
+ * Removes an element in constant time by moving the last element into its
+ * place. Does not keep the order of the elements
+ * @param array The array to remove from
+ * @param index The element to remove
+ * @param dest A pointer to hold the removed element. Can be 0/NULL
+ */
+KAPI void _darray_swap_remove(void *array, u64 index, void *dest);
+
+/**
+ * Makes sure `additional` more elements can be added without growing again
+ * @returns The array, which may have moved
+ */
+KAPI void *_darray_reserve_more(void *array, u64 additional);
+
+/**
+ * Releases capacity beyond the current length. Virtual arrays decommit their
+ * unused pages and never move
+ * @returns The array, which may have moved
+ */
+KAPI void *_darray_shrink_to_fit(void *array);
+
 #define DARRAY_DEFAULT_CAPACITY 1
 #define DARRAY_RESIZE_FACTOR 2
 
@@ -26,6 +98,9 @@ KAPI void *_darray_insert_at(void *array, u64 index, void *value_ptr);
 
 #define darray_reserve(type, capacity) _darray_create(capacity, sizeof(type))
 
+#define darray_create_virtual(type, max_capacity)                              \
+    _darray_create_virtual(max_capacity, sizeof(type))
+
 #define darray_destroy(array) _darray_destroy(array)
 
 #define darray_push(array, value)                                              \
@@ -39,11 +114,28 @@ KAPI void *_darray_insert_at(void *array, u64 index, void *value_ptr);
 #define darray_insert_at(array, index, value)                                  \
     {                                                                          \
         typeof(value) temp = value;                                            \
-        array = _darray_insert_at(array, index, value_ptr)                     \
+        array = _darray_insert_at(array, index, &temp);                        \
     }
 
 #define darray_pop_at(array, index, value_ptr)                                 \
-    _darray_pop_at(array, index, value_ptr);
+    _darray_pop_at(array, index, value_ptr)
+
+#define darray_push_n(array, values_ptr, count)                                \
+    array = _darray_push_n(array, values_ptr, count)
+
+#define darray_insert_range(array, index, values_ptr, count)                   \
+    array = _darray_insert_range(array, index, values_ptr, count)
+
+#define darray_erase_range(array, index, count)                                \
+    _darray_erase_range(array, index, count)
+
+#define darray_swap_remove(array, index, value_ptr)                            \
+    _darray_swap_remove(array, index, value_ptr)
+
+#define darray_reserve_more(array, additional)                                 \
+    array = _darray_reserve_more(array, additional)
+
+#define darray_shrink_to_fit(array) array = _darray_shrink_to_fit(array)
 
 #define darray_clear(array) _darray_field_set(array, DARRAY_LENGTH, 0)
 
@@ -55,3 +147,88 @@ KAPI void *_darray_insert_at(void *array, u64 index, void *value_ptr);
 
 #define darray_length_set(array, value)                                        \
     _darray_field_set(array, DARRAY_LENGTH, value)
+
+// The header every darray carries in front of its elements, as a struct.
+// Field order matches the DARRAY_* field indices above
+typedef struct darray_header {
+    u64 capacity;
+    u64 length;
+    u64 stride;
+    u64 reserved_capacity;
+} darray_header;
+
+STATIC_ASSERT(sizeof(darray_header) == DARRAY_FIELD_LENGTH * sizeof(u64),
+              "darray_header must match the darray field layout.");
+
+KINLINE darray_header *darray_header_get(void *array) {
+    return (darray_header *)array - 1;
+}
+
+/**
+ * Defines type-specialized inline functions named `<name>_<operation>` over
+ * darrays of T. The stride is a compile-time constant and the header is read
+ * directly, so loops over these arrays can be inlined and vectorized. Arrays
+ * are plain darrays: they can be passed to the generic `darray_*` macros and
+ * the other way around.
+ *
+ * Usage, at file scope:
+ *     DARRAY_DEFINE(u32_array, u32)
+ *     u32 *values = u32_array_create(16);
+ *     values = u32_array_push(values, 7);
+ */
+#define DARRAY_DEFINE(name, T)                                                 \
+    KINLINE T *name##_create(u64 capacity) {                                   \
+        return (T *)_darray_create(capacity, sizeof(T));                       \
+    }                                                                          \
+                                                                               \
+    KINLINE void name##_destroy(T *array) { _darray_destroy(array); }         \
+                                                                               \
+    KINLINE u64 name##_length(T *array) {                                      \
+        return darray_header_get(array)->length;                               \
+    }                                                                          \
+                                                                               \
+    KINLINE u64 name##_capacity(T *array) {                                    \
+        return darray_header_get(array)->capacity;                             \
+    }                                                                          \
+                                                                               \
+    KINLINE void name##_clear(T *array) {                                      \
+        darray_header_get(array)->length = 0;                                  \
+    }                                                                          \
+                                                                               \
+    KINLINE T *name##_push(T *array, T value) {                                \
+        darray_header *header = darray_header_get(array);                      \
+        if (header->length >= header->capacity) {                              \
+            array = (T *)_darray_resize(array);                                \
+            header = darray_header_get(array);                                 \
+        }                                                                      \
+        array[header->length++] = value;                                       \
+        return array;                                                          \
+    }                                                                          \
+                                                                               \
+    KINLINE T name##_pop(T *array) {                                           \
+        darray_header *header = darray_header_get(array);                      \
+        return array[--header->length];                                        \
+    }                                                                          \
+                                                                               \
+    KINLINE T *name##_insert(T *array, u64 index, T value) {                   \
+        return (T *)_darray_insert_at(array, index, &value);                   \
+    }                                                                          \
+                                                                               \
+    KINLINE T name##_remove(T *array, u64 index) {                             \
+        T value = array[index];                                                \
+        _darray_erase_range(array, index, 1);                                  \
+        return value;                                                          \
+    }                                                                          \
+                                                                               \
+    KINLINE T *name##_resize(T *array, u64 length) {                           \
+        darray_header *header = darray_header_get(array);                      \
+        if (length > header->capacity) {                                       \
+            array = (T *)_darray_reserve_more(array, length - header->length); \
+            header = darray_header_get(array);                                 \
+        }                                                                      \
+        for (u64 i = header->length; i < length; ++i) {                        \
+            array[i] = (T){0};                                                 \
+        }                                                                      \
+        header->length = length;                                               \
+        return array;                                                          \
+    }
@@ -0,0 +1,290 @@
+#include "hashmap.h"
+
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "core/scratch_allocator.h"
+
+#define HASHMAP_MIN_CAPACITY 8
+
+// Robin Hood probing stays short up to high load, so the map only grows once
+// it is 7/8 full
+#define HASHMAP_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+static u64 hash_u64(u64 key) {
+    // splitmix64 finalizer
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    return key;
+}
+
+// Slots store 32 bits of the hash, with 0 reserved for empty slots
+static u32 slot_hash(u64 hash) {
+    u32 folded = (u32)(hash ^ (hash >> 32));
+    return folded ? folded : 1;
+}
+
+static b8 keys_equal(hashmap *map, hashmap_slot *slot, u64 key) {
+    if (map->key_type != HASHMAP_KEY_U64) {
+        return strings_equal((const char *)slot->key, (const char *)key);
+    }
+    return slot->key == key;
+}
+
+static u8 *slot_value(hashmap *map, u32 index) {
+    return map->values + (u64)index * map->value_stride;
+}
+
+static void swap_bytes(u8 *a, u8 *b, u64 size) {
+    for (u64 i = 0; i < size; ++i) {
+        u8 temp = a[i];
+        a[i] = b[i];
+        b[i] = temp;
+    }
+}
+
+static u64 allocation_size(u32 capacity, u64 value_stride) {
+    return (u64)capacity * (sizeof(hashmap_slot) + value_stride);
+}
+
+static b8 allocate_slots(hashmap *map, u32 capacity) {
+    // Slots are 16 bytes, so the values that follow them stay 16-aligned.
+    // Only the slots need clearing; values are written before being read
+    u64 size = allocation_size(capacity, map->value_stride);
+    u8 *memory = kallocate_uninitialized(size, MEMORY_TAG_DICT);
+    if (!memory) {
+        return FALSE;
+    }
+    kzero_memory(memory, (u64)capacity * sizeof(hashmap_slot));
+
+    map->capacity = capacity;
+    map->slots = (hashmap_slot *)memory;
+    map->values = memory + (u64)capacity * sizeof(hashmap_slot);
+    return TRUE;
+}
+
+static i64 find_index(hashmap *map, u32 hash, u64 key) {
+    if (!map->count) {
+        return -1;
+    }
+
+    u32 mask = map->capacity - 1;
+    u32 index = hash & mask;
+    for (u32 distance = 0;; ++distance) {
+        hashmap_slot *slot = &map->slots[index];
+        // An entry closer to its home than we are to ours means the key would
+        // have displaced it on insert, so it is not in the map
+        if (!slot->hash || slot->distance < distance) {
+            return -1;
+        }
+        if (slot->hash == hash && keys_equal(map, slot, key)) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+// Places an entry known not to be in the map. The map must have a free slot
+static void insert_entry(hashmap *map, hashmap_slot entry, u8 *value) {
+    u32 mask = map->capacity - 1;
+    u32 index = entry.hash & mask;
+    entry.distance = 0;
+
+    for (;;) {
+        hashmap_slot *slot = &map->slots[index];
+        if (!slot->hash) {
+            *slot = entry;
+            kcopy_memory(slot_value(map, index), value, map->value_stride);
+            map->count++;
+            return;
+        }
+
+        // Take from the rich: the entry further from home gets the slot and
+        // the displaced one carries on probing
+        if (slot->distance < entry.distance) {
+            hashmap_slot displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+            swap_bytes(slot_value(map, index), value, map->value_stride);
+        }
+
+        index = (index + 1) & mask;
+        entry.distance++;
+    }
+}
+
+static b8 grow(hashmap *map) {
+    u32 old_capacity = map->capacity;
+    hashmap_slot *old_slots = map->slots;
+    u8 *old_values = map->values;
+
+    if (!allocate_slots(map, old_capacity * 2)) {
+        return FALSE;
+    }
+    map->count = 0;
+
+    for (u32 i = 0; i < old_capacity; ++i) {
+        if (old_slots[i].hash) {
+            insert_entry(map, old_slots[i],
+                         old_values + (u64)i * map->value_stride);
+        }
+    }
+
+    kfree(old_slots, allocation_size(old_capacity, map->value_stride),
+          MEMORY_TAG_DICT);
+    return TRUE;
+}
+
+static b8 set_entry(hashmap *map, u32 hash, u64 key, const void *value) {
+    i64 index = find_index(map, hash, key);
+    if (index >= 0) {
+        kcopy_memory(slot_value(map, index), value, map->value_stride);
+        return TRUE;
+    }
+
+    if (map->count + 1 > HASHMAP_MAX_LOAD(map->capacity) && !grow(map)) {
+        KERROR("hashmap_set - failed to grow past %u entries.", map->count);
+        return FALSE;
+    }
+
+    // The value is carried through any Robin Hood swaps in scratch memory
+    scratch_marker marker = scratch_begin();
+    u8 *carried = scratch_allocate(map->value_stride);
+    if (!carried) {
+        scratch_end(marker);
+        KERROR("hashmap_set - failed to allocate %llu bytes of scratch.",
+               map->value_stride);
+        return FALSE;
+    }
+    kcopy_memory(carried, value, map->value_stride);
+
+    hashmap_slot entry = {0};
+    entry.hash = hash;
+    entry.key = key;
+    if (map->key_type == HASHMAP_KEY_STRING) {
+        const char *string = (const char *)key;
+        u64 size = string_length(string) + 1;
+        char *copy = kallocate_uninitialized(size, MEMORY_TAG_DICT);
+        if (!copy) {
+            scratch_end(marker);
+            KERROR("hashmap_set - failed to copy the key '%s'.", string);
+            return FALSE;
+        }
+        kcopy_memory(copy, string, size);
+        entry.key = (u64)copy;
+    }
+
+    insert_entry(map, entry, carried);
+    scratch_end(marker);
+
+    return TRUE;
+}
+
+static void free_key(hashmap *map, hashmap_slot *slot) {
+    if (map->key_type == HASHMAP_KEY_STRING) {
+        char *key = (char *)slot->key;
+        kfree(key, string_length(key) + 1, MEMORY_TAG_DICT);
+    }
+}
+
+static b8 remove_entry(hashmap *map, u32 hash, u64 key, void *out_value) {
+    i64 found = find_index(map, hash, key);
+    if (found < 0) {
+        return FALSE;
+    }
+
+    u32 index = found;
+    if (out_value) {
+        kcopy_memory(out_value, slot_value(map, index), map->value_stride);
+    }
+    free_key(map, &map->slots[index]);
+
+    // Backward-shift deletion: pull each following displaced entry one slot
+    // closer to home until an empty slot or an entry already at home
+    u32 mask = map->capacity - 1;
+    u32 next = (index + 1) & mask;
+    while (map->slots[next].hash && map->slots[next].distance > 0) {
+        map->slots[index] = map->slots[next];
+        map->slots[index].distance--;
+        kcopy_memory(slot_value(map, index), slot_value(map, next),
+                     map->value_stride);
+
+        index = next;
+        next = (next + 1) & mask;
+    }
+
+    map->slots[index].hash = 0;
+    map->slots[index].distance = 0;
+    map->count--;
+
+    return TRUE;
+}
+
+b8 hashmap_create(hashmap_key_type key_type, u64 value_stride,
+                  u32 initial_capacity, hashmap *out_map) {
+    if (!out_map || !value_stride) {
+        return FALSE;
+    }
+
+    kzero_memory(out_map, sizeof(hashmap));
+    out_map->key_type = key_type;
+    out_map->value_stride = value_stride;
+
+    u32 capacity = HASHMAP_MIN_CAPACITY;
+    while (HASHMAP_MAX_LOAD(capacity) < initial_capacity) {
+        capacity *= 2;
+    }
+
+    return allocate_slots(out_map, capacity);
+}
+
+void hashmap_destroy(hashmap *map) {
+    if (!map || !map->slots) {
+        return;
+    }
+
+    hashmap_clear(map);
+    kfree(map->slots, allocation_size(map->capacity, map->value_stride),
+          MEMORY_TAG_DICT);
+    kzero_memory(map, sizeof(hashmap));
+}
+
+b8 hashmap_set_u64(hashmap *map, u64 key, const void *value) {
+    return set_entry(map, slot_hash(hash_u64(key)), key, value);
+}
+
+void *hashmap_get_u64(hashmap *map, u64 key) {
+    i64 index = find_index(map, slot_hash(hash_u64(key)), key);
+    return index >= 0 ? slot_value(map, index) : 0;
+}
+
+b8 hashmap_remove_u64(hashmap *map, u64 key, void *out_value) {
+    return remove_entry(map, slot_hash(hash_u64(key)), key, out_value);
+}
+
+b8 hashmap_set_string(hashmap *map, const char *key, const void *value) {
+    return set_entry(map, slot_hash(string_hash(key)), (u64)key, value);
+}
+
+void *hashmap_get_string(hashmap *map, const char *key) {
+    i64 index = find_index(map, slot_hash(string_hash(key)), (u64)key);
+    return index >= 0 ? slot_value(map, index) : 0;
+}
+
+b8 hashmap_remove_string(hashmap *map, const char *key, void *out_value) {
+    return remove_entry(map, slot_hash(string_hash(key)), (u64)key, out_value);
+}
+
+void hashmap_clear(hashmap *map) {
+    for (u32 i = 0; i < map->capacity; ++i) {
+        if (map->slots[i].hash) {
+            free_key(map, &map->slots[i]);
+        }
+    }
+
+    kzero_memory(map->slots, (u64)map->capacity * sizeof(hashmap_slot));
+    map->count = 0;
+}
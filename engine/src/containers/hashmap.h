@@ -0,0 +1,85 @@
+#pragma once
+
+#include "defines.h"
+
+typedef enum hashmap_key_type {
+    HASHMAP_KEY_U64,
+    // Keys are copied into the map, so callers may pass temporary strings
+    HASHMAP_KEY_STRING,
+    // Keys are stored as given and must stay valid while they are in the map.
+    // Saves a copy per key when the strings already have a stable home
+    HASHMAP_KEY_STRING_BORROWED
+} hashmap_key_type;
+
+typedef struct hashmap_slot {
+    // The key itself, or a pointer to the map's copy of a string key
+    u64 key;
+    // Part of the key's hash, never 0. A 0 hash marks an empty slot
+    u32 hash;
+    // How far the entry sits from the slot its hash points at
+    u32 distance;
+} hashmap_slot;
+
+/**
+ * An open-addressing hash map using Robin Hood hashing: on insert, an entry
+ * that is further from its home slot takes the place of one that is closer,
+ * which keeps probe sequences short and lets lookups stop early. Removal
+ * shifts the following entries back instead of leaving tombstones. Slots and
+ * values live in two flat arrays in a single MEMORY_TAG_DICT allocation.
+ */
+typedef struct hashmap {
+    hashmap_key_type key_type;
+    u64 value_stride;
+    // Always a power of two
+    u32 capacity;
+    u32 count;
+    hashmap_slot *slots;
+    u8 *values;
+} hashmap;
+
+/**
+ * Creates a hash map
+ * @param key_type Whether the map is keyed by u64 or by string
+ * @param value_stride The size of one value in bytes
+ * @param initial_capacity The number of entries to make room for up front.
+ * Can be 0
+ * @param out_map A pointer to hold the created map
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 hashmap_create(hashmap_key_type key_type, u64 value_stride,
+                       u32 initial_capacity, hashmap *out_map);
+
+KAPI void hashmap_destroy(hashmap *map);
+
+/**
+ * Inserts a value, or overwrites the value already stored under the key
+ * @param map The map to insert into. Must be keyed by u64
+ * @param key The key
+ * @param value A pointer to the value to copy into the map
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 hashmap_set_u64(hashmap *map, u64 key, const void *value);
+
+/**
+ * Looks up a value
+ * @returns A pointer to the value stored under the key, valid until the map
+ * is next modified, or 0/NULL if the key is not present
+ */
+KAPI void *hashmap_get_u64(hashmap *map, u64 key);
+
+/**
+ * Removes a key and its value
+ * @param out_value A pointer to hold the removed value. Can be 0/NULL
+ * @returns TRUE if the key was present; otherwise FALSE
+ */
+KAPI b8 hashmap_remove_u64(hashmap *map, u64 key, void *out_value);
+
+// The same operations for maps keyed by string, copied or borrowed
+KAPI b8 hashmap_set_string(hashmap *map, const char *key, const void *value);
+KAPI void *hashmap_get_string(hashmap *map, const char *key);
+KAPI b8 hashmap_remove_string(hashmap *map, const char *key, void *out_value);
+
+/**
+ * Removes every entry, keeping the map's capacity
+ */
+KAPI void hashmap_clear(hashmap *map);
@@ -0,0 +1,188 @@
+#include "ring_queue.h"
+
+#include "core/kmemory.h"
+
+// Elements in an mpmc_queue cell start after the sequence number, at an
+// offset that keeps them 16-byte aligned
+#define MPMC_CELL_HEADER_SIZE 16
+
+static u64 round_up_to_power_of_2(u64 value) {
+    u64 result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+b8 spsc_queue_create(u64 stride, u64 capacity, spsc_queue *out_queue) {
+    if (!out_queue || !stride || !capacity) {
+        return FALSE;
+    }
+
+    kzero_memory(out_queue, sizeof(spsc_queue));
+    out_queue->capacity = round_up_to_power_of_2(capacity);
+    out_queue->stride = stride;
+    out_queue->elements =
+        kallocate_aligned(out_queue->capacity * stride, KCACHE_LINE_SIZE,
+                          MEMORY_TAG_RING_QUEUE);
+
+    return out_queue->elements != 0;
+}
+
+void spsc_queue_destroy(spsc_queue *queue) {
+    if (!queue || !queue->elements) {
+        return;
+    }
+
+    kfree_aligned(queue->elements, queue->capacity * queue->stride,
+                  KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE);
+    kzero_memory(queue, sizeof(spsc_queue));
+}
+
+b8 spsc_queue_push(spsc_queue *queue, const void *value) {
+    u64 tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail - queue->cached_head >= queue->capacity) {
+        // Acquire pairs with the consumer's release, so the slot it freed is
+        // no longer being read when we overwrite it
+        queue->cached_head =
+            atomic_load_explicit(&queue->head, memory_order_acquire);
+        if (tail - queue->cached_head >= queue->capacity) {
+            return FALSE;
+        }
+    }
+
+    u64 index = tail & (queue->capacity - 1);
+    kcopy_memory(queue->elements + index * queue->stride, value,
+                 queue->stride);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+
+    return TRUE;
+}
+
+b8 spsc_queue_pop(spsc_queue *queue, void *out_value) {
+    u64 head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head == queue->cached_tail) {
+        // Acquire pairs with the producer's release, so the element's bytes
+        // are visible before we copy them out
+        queue->cached_tail =
+            atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head == queue->cached_tail) {
+            return FALSE;
+        }
+    }
+
+    u64 index = head & (queue->capacity - 1);
+    kcopy_memory(out_value, queue->elements + index * queue->stride,
+                 queue->stride);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+
+    return TRUE;
+}
+
+static _Atomic u64 *cell_sequence(mpmc_queue *queue, u64 position) {
+    u64 index = position & (queue->capacity - 1);
+    return (_Atomic u64 *)(queue->cells + index * queue->cell_size);
+}
+
+b8 mpmc_queue_create(u64 stride, u64 capacity, mpmc_queue *out_queue) {
+    if (!out_queue || !stride || !capacity) {
+        return FALSE;
+    }
+
+    kzero_memory(out_queue, sizeof(mpmc_queue));
+    // With a single cell, a full and an empty queue look the same
+    out_queue->capacity = round_up_to_power_of_2(KMAX(capacity, 2));
+    out_queue->stride = stride;
+    out_queue->cell_size = (MPMC_CELL_HEADER_SIZE + stride + 15) & ~15ull;
+    out_queue->cells =
+        kallocate_aligned(out_queue->capacity * out_queue->cell_size,
+                          KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE);
+    if (!out_queue->cells) {
+        return FALSE;
+    }
+
+    // A cell is free for the producer at position p when its sequence is p
+    for (u64 i = 0; i < out_queue->capacity; ++i) {
+        atomic_init(cell_sequence(out_queue, i), i);
+    }
+
+    return TRUE;
+}
+
+void mpmc_queue_destroy(mpmc_queue *queue) {
+    if (!queue || !queue->cells) {
+        return;
+    }
+
+    kfree_aligned(queue->cells, queue->capacity * queue->cell_size,
+                  KCACHE_LINE_SIZE, MEMORY_TAG_RING_QUEUE);
+    kzero_memory(queue, sizeof(mpmc_queue));
+}
+
+b8 mpmc_queue_push(mpmc_queue *queue, const void *value) {
+    u64 position =
+        atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+    _Atomic u64 *sequence;
+
+    for (;;) {
+        sequence = cell_sequence(queue, position);
+        u64 ready = atomic_load_explicit(sequence, memory_order_acquire);
+        i64 difference = (i64)(ready - position);
+
+        if (difference == 0) {
+            // The cell is free; try to claim it
+            if (atomic_compare_exchange_weak_explicit(
+                    &queue->enqueue_position, &position, position + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The cell still holds an element from one lap ago
+            return FALSE;
+        } else {
+            // Another producer claimed it first
+            position = atomic_load_explicit(&queue->enqueue_position,
+                                            memory_order_relaxed);
+        }
+    }
+
+    kcopy_memory((u8 *)sequence + MPMC_CELL_HEADER_SIZE, value, queue->stride);
+    // Hand the cell to the consumer at this position
+    atomic_store_explicit(sequence, position + 1, memory_order_release);
+
+    return TRUE;
+}
+
+b8 mpmc_queue_pop(mpmc_queue *queue, void *out_value) {
+    u64 position =
+        atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+    _Atomic u64 *sequence;
+
+    for (;;) {
+        sequence = cell_sequence(queue, position);
+        u64 ready = atomic_load_explicit(sequence, memory_order_acquire);
+        i64 difference = (i64)(ready - (position + 1));
+
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &queue->dequeue_position, &position, position + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Nothing has been pushed into the cell yet
+            return FALSE;
+        } else {
+            position = atomic_load_explicit(&queue->dequeue_position,
+                                            memory_order_relaxed);
+        }
+    }
+
+    kcopy_memory(out_value, (u8 *)sequence + MPMC_CELL_HEADER_SIZE,
+                 queue->stride);
+    // Free the cell for the producer one lap ahead
+    atomic_store_explicit(sequence, position + queue->capacity,
+                          memory_order_release);
+
+    return TRUE;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "defines.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+
+// Both queues keep their producer and consumer indices on separate cache
+// lines, so the two sides never invalidate each other's line on every
+// operation. Because of that alignment, a queue struct placed on the heap
+// must come from `kallocate_aligned` with KCACHE_LINE_SIZE.
+
+/**
+ * A bounded, lock-free queue for exactly one producer thread and one consumer
+ * thread. Each side only writes its own index and publishes it with a
+ * release store; the other side's index is cached and only re-read with an
+ * acquire load when the queue looks full or empty.
+ */
+typedef struct spsc_queue {
+    // Written by the consumer
+    alignas(KCACHE_LINE_SIZE) _Atomic u64 head;
+    u64 cached_tail;
+
+    // Written by the producer
+    alignas(KCACHE_LINE_SIZE) _Atomic u64 tail;
+    u64 cached_head;
+
+    // Read-only after creation
+    alignas(KCACHE_LINE_SIZE) u64 capacity;
+    u64 stride;
+    u8 *elements;
+} spsc_queue;
+
+/**
+ * A bounded, lock-free queue for any number of producers and consumers
+ * (Dmitry Vyukov's design). Each cell carries a sequence number that tells a
+ * producer or consumer whether the cell is ready for it, so claiming a cell
+ * is a single compare-and-swap on the shared index.
+ */
+typedef struct mpmc_queue {
+    alignas(KCACHE_LINE_SIZE) _Atomic u64 enqueue_position;
+    alignas(KCACHE_LINE_SIZE) _Atomic u64 dequeue_position;
+
+    alignas(KCACHE_LINE_SIZE) u64 capacity;
+    u64 stride;
+    // Sequence number plus padding plus element, rounded up to 16 bytes
+    u64 cell_size;
+    u8 *cells;
+} mpmc_queue;
+
+/**
+ * Creates a single-producer/single-consumer queue
+ * @param stride The size of one element in bytes
+ * @param capacity The most elements the queue holds. Rounded up to a power
+ * of two
+ * @param out_queue A pointer to hold the created queue
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 spsc_queue_create(u64 stride, u64 capacity, spsc_queue *out_queue);
+
+KAPI void spsc_queue_destroy(spsc_queue *queue);
+
+/**
+ * Copies an element into the queue. Only call from the producer thread
+ * @returns TRUE on success; FALSE if the queue is full
+ */
+KAPI b8 spsc_queue_push(spsc_queue *queue, const void *value);
+
+/**
+ * Copies the oldest element out of the queue. Only call from the consumer
+ * thread
+ * @returns TRUE on success; FALSE if the queue is empty
+ */
+KAPI b8 spsc_queue_pop(spsc_queue *queue, void *out_value);
+
+/**
+ * Creates a multi-producer/multi-consumer queue
+ * @param stride The size of one element in bytes
+ * @param capacity The most elements the queue holds. Rounded up to a power
+ * of two, and at least 2
+ * @param out_queue A pointer to hold the created queue
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 mpmc_queue_create(u64 stride, u64 capacity, mpmc_queue *out_queue);
+
+KAPI void mpmc_queue_destroy(mpmc_queue *queue);
+
+/**
+ * Copies an element into the queue. Safe to call from any thread
+ * @returns TRUE on success; FALSE if the queue is full
+ */
+KAPI b8 mpmc_queue_push(mpmc_queue *queue, const void *value);
+
+/**
+ * Copies the oldest available element out of the queue. Safe to call from
+ * any thread
+ * @returns TRUE on success; FALSE if the queue is empty
+ */
+KAPI b8 mpmc_queue_pop(mpmc_queue *queue, void *out_value);
@@ -0,0 +1,174 @@
+#include "slot_map.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#define SLOT_MAP_MIN_CAPACITY 8
+
+// Values come first so they keep the allocation's alignment, and the slots
+// after them are rounded up to their own alignment
+static u64 slots_offset(u32 capacity, u64 stride) {
+    return ((u64)capacity * stride + 7) & ~7ull;
+}
+
+static u64 allocation_size(u32 capacity, u64 stride) {
+    return slots_offset(capacity, stride) +
+           (u64)capacity * (sizeof(slot_map_slot) + sizeof(u32));
+}
+
+// Links slots [first, capacity) into the free list, in front of the rest
+static void push_free_slots(slot_map *map, u32 first) {
+    for (u32 i = map->capacity; i > first; --i) {
+        map->slots[i - 1].dense_index = map->free_head;
+        map->free_head = i - 1;
+    }
+}
+
+static b8 resize(slot_map *map, u32 capacity) {
+    // Nothing past `count` is read before being written, so only the new
+    // slots need initializing
+    u64 size = allocation_size(capacity, map->stride);
+    u8 *memory = kallocate_uninitialized(size, MEMORY_TAG_ARRAY);
+    if (!memory) {
+        return FALSE;
+    }
+
+    u8 *values = memory;
+    slot_map_slot *slots =
+        (slot_map_slot *)(memory + slots_offset(capacity, map->stride));
+    u32 *dense_to_slot = (u32 *)(slots + capacity);
+
+    u32 old_capacity = map->capacity;
+    if (map->values) {
+        kcopy_memory(values, map->values, (u64)map->count * map->stride);
+        kcopy_memory(slots, map->slots, old_capacity * sizeof(slot_map_slot));
+        kcopy_memory(dense_to_slot, map->dense_to_slot,
+                     map->count * sizeof(u32));
+        kfree(map->values, allocation_size(old_capacity, map->stride),
+              MEMORY_TAG_ARRAY);
+    }
+    kzero_memory(slots + old_capacity,
+                 (u64)(capacity - old_capacity) * sizeof(slot_map_slot));
+
+    map->values = values;
+    map->slots = slots;
+    map->dense_to_slot = dense_to_slot;
+    map->capacity = capacity;
+
+    // The list is only extended when empty, so its end marker is the old
+    // capacity and needs moving to the new one
+    map->free_head = capacity;
+    push_free_slots(map, old_capacity);
+    return TRUE;
+}
+
+b8 slot_map_create(u64 stride, u32 initial_capacity, slot_map *out_map) {
+    if (!out_map || !stride) {
+        return FALSE;
+    }
+
+    kzero_memory(out_map, sizeof(slot_map));
+    out_map->stride = stride;
+    return resize(out_map, KMAX(initial_capacity, SLOT_MAP_MIN_CAPACITY));
+}
+
+void slot_map_destroy(slot_map *map) {
+    if (!map || !map->values) {
+        return;
+    }
+
+    kfree(map->values, allocation_size(map->capacity, map->stride),
+          MEMORY_TAG_ARRAY);
+    kzero_memory(map, sizeof(slot_map));
+}
+
+b8 slot_map_insert(slot_map *map, const void *value,
+                   slot_handle *out_handle) {
+    if (map->free_head == map->capacity) {
+        if (map->capacity >= 0x80000000u || !resize(map, map->capacity * 2)) {
+            KERROR("slot_map_insert - failed to grow past %u values.",
+                   map->count);
+            return FALSE;
+        }
+    }
+
+    u32 index = map->free_head;
+    slot_map_slot *slot = &map->slots[index];
+    map->free_head = slot->dense_index;
+
+    u32 dense_index = map->count++;
+    slot->dense_index = dense_index;
+    slot->generation++;
+    map->dense_to_slot[dense_index] = index;
+
+    u8 *destination = map->values + (u64)dense_index * map->stride;
+    if (value) {
+        kcopy_memory(destination, value, map->stride);
+    } else {
+        kzero_memory(destination, map->stride);
+    }
+
+    out_handle->index = index;
+    out_handle->generation = slot->generation;
+    return TRUE;
+}
+
+b8 slot_map_is_valid(slot_map *map, slot_handle handle) {
+    // Free slots have even generations, so a handle's generation only ever
+    // matches while its slot holds the value it was made for
+    return handle.index < map->capacity &&
+           map->slots[handle.index].generation == handle.generation &&
+           (handle.generation & 1);
+}
+
+b8 slot_map_erase(slot_map *map, slot_handle handle) {
+    if (!slot_map_is_valid(map, handle)) {
+        KWARN("slot_map_erase - stale handle (index %u, generation %u).",
+              handle.index, handle.generation);
+        return FALSE;
+    }
+
+    slot_map_slot *slot = &map->slots[handle.index];
+    u32 last = --map->count;
+
+    // Fill the gap with the last value to keep the values packed
+    if (slot->dense_index != last) {
+        u32 moved_slot = map->dense_to_slot[last];
+        kcopy_memory(map->values + (u64)slot->dense_index * map->stride,
+                     map->values + (u64)last * map->stride, map->stride);
+        map->dense_to_slot[slot->dense_index] = moved_slot;
+        map->slots[moved_slot].dense_index = slot->dense_index;
+    }
+
+    slot->generation++;
+    slot->dense_index = map->free_head;
+    map->free_head = handle.index;
+    return TRUE;
+}
+
+void *slot_map_get(slot_map *map, slot_handle handle) {
+    if (!slot_map_is_valid(map, handle)) {
+        return 0;
+    }
+    return map->values +
+           (u64)map->slots[handle.index].dense_index * map->stride;
+}
+
+slot_handle slot_map_handle_at(slot_map *map, u32 dense_index) {
+    slot_handle handle = {0};
+    if (dense_index < map->count) {
+        handle.index = map->dense_to_slot[dense_index];
+        handle.generation = map->slots[handle.index].generation;
+    }
+    return handle;
+}
+
+void slot_map_clear(slot_map *map) {
+    for (u32 i = 0; i < map->count; ++i) {
+        map->slots[map->dense_to_slot[i]].generation++;
+    }
+    map->count = 0;
+
+    map->free_head = map->capacity;
+    push_free_slots(map, 0);
+}
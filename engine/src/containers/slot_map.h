@@ -0,0 +1,97 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * A stable reference to a value in a slot_map. It stays valid while the value
+ * moves around in the map's dense storage, and is detected as stale once the
+ * value is erased, even if the slot has been reused since. A zeroed handle is
+ * never valid.
+ */
+typedef struct slot_handle {
+    u32 index;
+    u32 generation;
+} slot_handle;
+
+typedef struct slot_map_slot {
+    // Where the value lives in the dense array while occupied; the next free
+    // slot while free
+    u32 dense_index;
+    // Odd while occupied, even while free. Bumped on every insert and erase
+    u32 generation;
+} slot_map_slot;
+
+/**
+ * A container that hands out generational handles to its values. Values are
+ * kept packed at the front of a dense array, so iterating over them is a
+ * straight walk through memory; a separate slot array maps each handle to its
+ * value's current position. Insert, erase and lookup are all O(1). Erasing
+ * moves the last value into the gap, so the order of values is not kept.
+ *
+ * Iterate with:
+ *     u8 *values = slot_map_values(&map);
+ *     for (u32 i = 0; i < map.count; ++i) { values + i * map.stride ... }
+ */
+typedef struct slot_map {
+    u64 stride;
+    u32 capacity;
+    u32 count;
+    // Head of the free slot list, or `capacity` when no slot is free
+    u32 free_head;
+    slot_map_slot *slots;
+    // The slot that owns each dense value, used to fix up a slot when its
+    // value is moved
+    u32 *dense_to_slot;
+    // All three arrays share one allocation starting at the values
+    u8 *values;
+} slot_map;
+
+/**
+ * Creates a slot map
+ * @param stride The size of one value in bytes
+ * @param initial_capacity The number of values to make room for up front.
+ * Can be 0
+ * @param out_map A pointer to hold the created map
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 slot_map_create(u64 stride, u32 initial_capacity, slot_map *out_map);
+
+KAPI void slot_map_destroy(slot_map *map);
+
+/**
+ * Copies a value into the map
+ * @param map The map to insert into
+ * @param value A pointer to the value to copy, or 0/NULL to zero the new value
+ * @param out_handle A pointer to hold the handle to the new value
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 slot_map_insert(slot_map *map, const void *value,
+                        slot_handle *out_handle);
+
+/**
+ * Removes a value. The handle, and any copies of it, become stale
+ * @returns TRUE if the handle was valid; otherwise FALSE
+ */
+KAPI b8 slot_map_erase(slot_map *map, slot_handle handle);
+
+/**
+ * Looks up a value
+ * @returns A pointer to the value, valid until the map is next modified, or
+ * 0/NULL if the handle is stale
+ */
+KAPI void *slot_map_get(slot_map *map, slot_handle handle);
+
+KAPI b8 slot_map_is_valid(slot_map *map, slot_handle handle);
+
+/**
+ * Gets the handle to the value at a position in the dense array, e.g. while
+ * iterating
+ */
+KAPI slot_handle slot_map_handle_at(slot_map *map, u32 dense_index);
+
+/**
+ * Removes every value, making every handle handed out so far stale
+ */
+KAPI void slot_map_clear(slot_map *map);
+
+KINLINE void *slot_map_values(slot_map *map) { return map->values; }
@@ -0,0 +1,23 @@
+#include "small_array.h"
+
+#include "core/kmemory.h"
+
+void _small_array_grow(void **heap, u32 *heap_capacity,
+                       const void *inline_data, u32 length, u64 stride) {
+    // Only called when the array is full, so this doubles its capacity
+    u32 new_capacity = length ? length * 2 : 1;
+    void *new_heap =
+        kallocate_uninitialized(new_capacity * stride, MEMORY_TAG_ARRAY);
+
+    kcopy_memory(new_heap, *heap ? *heap : inline_data, length * stride);
+    if (*heap) {
+        kfree(*heap, *heap_capacity * stride, MEMORY_TAG_ARRAY);
+    }
+
+    *heap = new_heap;
+    *heap_capacity = new_capacity;
+}
+
+void _small_array_free(void *heap, u32 heap_capacity, u64 stride) {
+    kfree(heap, heap_capacity * stride, MEMORY_TAG_ARRAY);
+}
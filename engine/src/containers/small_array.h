@@ -0,0 +1,69 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Grows a small array onto the heap, moving its elements out of the inline
+ * buffer on the first spill. Called by the generated `<name>_push`
+ */
+KAPI void _small_array_grow(void **heap, u32 *heap_capacity,
+                            const void *inline_data, u32 length, u64 stride);
+
+KAPI void _small_array_free(void *heap, u32 heap_capacity, u64 stride);
+
+/**
+ * Defines `name`, an array of T that stores its first `inline_capacity`
+ * elements inside the struct itself and only allocates once it grows past
+ * them. A zeroed struct is a valid empty array, and one that never spilled
+ * owns no memory, so the common case of a handful of elements costs no
+ * allocation at all. Call `<name>_destroy` once it may have spilled.
+ *
+ * Usage, at file scope:
+ *     SMALL_ARRAY_DEFINE(name_array, const char *, 8)
+ *     name_array names = {0};
+ *     name_array_push(&names, "a");
+ */
+#define SMALL_ARRAY_DEFINE(name, T, inline_capacity)                           \
+    typedef struct name {                                                      \
+        u32 length;                                                            \
+        /* Capacity of `heap`; 0 while the elements are stored inline */       \
+        u32 heap_capacity;                                                     \
+        T *heap;                                                               \
+        T inline_data[inline_capacity];                                        \
+    } name;                                                                    \
+                                                                               \
+    KINLINE T *name##_data(name *array) {                                      \
+        return array->heap ? array->heap : array->inline_data;                 \
+    }                                                                          \
+                                                                               \
+    KINLINE u32 name##_capacity(name *array) {                                 \
+        return array->heap ? array->heap_capacity : inline_capacity;           \
+    }                                                                          \
+                                                                               \
+    KINLINE void name##_push(name *array, T value) {                           \
+        if (array->length == name##_capacity(array)) {                         \
+            _small_array_grow((void **)&array->heap, &array->heap_capacity,    \
+                              array->inline_data, array->length, sizeof(T));   \
+        }                                                                      \
+        name##_data(array)[array->length++] = value;                           \
+    }                                                                          \
+                                                                               \
+    /* Removes an element, keeping the order of the rest */                    \
+    KINLINE void name##_remove_at(name *array, u32 index) {                    \
+        T *data = name##_data(array);                                          \
+        for (u32 i = index + 1; i < array->length; ++i) {                      \
+            data[i - 1] = data[i];                                             \
+        }                                                                      \
+        array->length--;                                                       \
+    }                                                                          \
+                                                                               \
+    KINLINE void name##_clear(name *array) { array->length = 0; }             \
+                                                                               \
+    KINLINE void name##_destroy(name *array) {                                 \
+        if (array->heap) {                                                     \
+            _small_array_free(array->heap, array->heap_capacity, sizeof(T));   \
+        }                                                                      \
+        array->heap = 0;                                                       \
+        array->heap_capacity = 0;                                              \
+        array->length = 0;                                                     \
+    }
@@ -7,6 +7,10 @@
 #include "core/input.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "core/memory_profiler.h"
+#include "core/recorder.h"
+#include "core/scratch_allocator.h"
+#include "core/string_intern.h"
 
 #include "renderer/renderer_frontend.h"
 #include "renderer/renderer_types.inl"
@@ -15,11 +19,16 @@ typedef struct application_state {
     game *game_inst;
     b8 is_running;
     b8 is_suspended;
+    // Set while replaying a recording, which needs no platform or renderer
+    b8 is_headless;
     platform_state platform;
     i16 width;
     i16 height;
     clock clock;
     f64 last_time;
+    // Posted event counts summed since they were last logged, and when
+    f64 event_stats_time;
+    event_frame_stats event_stats;
 } application_state;
 
 static b8 initialized = FALSE;
@@ -36,6 +45,26 @@ b8 application_on_key(u16 code, void *sender, void *listener_inst,
                       event_context context);
 b8 application_on_resized(u16 code, void *sender, void *listener_inst,
                           event_context context);
+void application_merge_wheel(event_context *accumulated, event_context next);
+
+// Adds up each frame's posted event counts, coalesced ones included, and
+// logs them once a second
+static void track_event_stats() {
+    event_frame_stats frame = event_get_frame_stats();
+    app_state.event_stats.posted += frame.posted;
+    app_state.event_stats.dispatched += frame.dispatched;
+    app_state.event_stats.coalesced += frame.coalesced;
+
+    f64 now = platform_get_absolute_time();
+    if (now - app_state.event_stats_time >= 1.0) {
+        KDEBUG("Events in the last second: %u posted, %u dispatched, %u "
+               "coalesced.",
+               app_state.event_stats.posted, app_state.event_stats.dispatched,
+               app_state.event_stats.coalesced);
+        kzero_memory(&app_state.event_stats, sizeof(event_frame_stats));
+        app_state.event_stats_time = now;
+    }
+}
 
 b8 application_create(game *game_inst) {
     if (initialized) {
@@ -49,6 +78,11 @@ b8 application_create(game *game_inst) {
     initialize_logging();
     input_initialize();
 
+    if (game_inst->app_config.heap_profile_path) {
+        memory_profiler_start(game_inst->app_config.heap_profile_interval,
+                              game_inst->app_config.heap_profile_path);
+    }
+
     // TODO: remove this
     KFATAL("A test message: %f", 3.14f);
     KERROR("A test message: %f", 3.14f);
@@ -66,22 +100,48 @@ b8 application_create(game *game_inst) {
         return FALSE;
     }
 
+    if (!string_intern_initialize()) {
+        KFATAL("String intern table failed initialization. Application cannot "
+               "continue.");
+        return FALSE;
+    }
+
     event_register(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_register(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_register(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
     event_register(EVENT_CODE_RESIZED, 0, application_on_resized);
 
-    if (!platform_startup(&app_state.platform, game_inst->app_config.name,
-                          game_inst->app_config.start_pos_x,
-                          game_inst->app_config.start_pos_y,
-                          game_inst->app_config.start_width,
-                          game_inst->app_config.start_height)) {
-        return FALSE;
+    // A drag-resize or a fast mouse can post dozens of these per frame, but
+    // only the latest size and position, and the total scroll, matter
+    event_set_coalescing(EVENT_CODE_RESIZED, EVENT_COALESCE_LAST_VALUE, 0);
+    event_set_coalescing(EVENT_CODE_MOUSE_MOVED, EVENT_COALESCE_LAST_VALUE, 0);
+    event_set_coalescing(EVENT_CODE_MOUSE_WHEEL, EVENT_COALESCE_ACCUMULATE,
+                         application_merge_wheel);
+
+    if (game_inst->app_config.replay_path) {
+        if (!recorder_start_replay(game_inst->app_config.replay_path)) {
+            KFATAL("Failed to load the recording to replay.");
+            return FALSE;
+        }
+        app_state.is_headless = TRUE;
+    } else if (game_inst->app_config.record_path) {
+        recorder_start_recording(game_inst->app_config.record_path);
     }
 
-    if (!renderer_initialize(game_inst->app_config.name, &app_state.platform)) {
-        KFATAL("Failed to initialize renderer. Aborting application.");
-        return FALSE;
+    if (!app_state.is_headless) {
+        if (!platform_startup(&app_state.platform, game_inst->app_config.name,
+                              game_inst->app_config.start_pos_x,
+                              game_inst->app_config.start_pos_y,
+                              game_inst->app_config.start_width,
+                              game_inst->app_config.start_height)) {
+            return FALSE;
+        }
+
+        if (!renderer_initialize(game_inst->app_config.name,
+                                 &app_state.platform)) {
+            KFATAL("Failed to initialize renderer. Aborting application.");
+            return FALSE;
+        }
     }
 
     if (!app_state.game_inst->initialize(app_state.game_inst)) {
@@ -101,22 +161,40 @@ b8 application_run() {
     clock_start(&app_state.clock);
     clock_update(&app_state.clock);
     app_state.last_time = app_state.clock.elapsed;
+    app_state.event_stats_time = platform_get_absolute_time();
 
     f64 running_time = 0;
     u8 frame_count = 0;
     f64 target_frame_seconds = 1.0f / 60;
 
+    scratch_marker marker = scratch_begin();
     KINFO(get_memory_usage_str());
+    scratch_end(marker);
 
     while (app_state.is_running) {
-        if (!platform_pump_messages(&app_state.platform)) {
+        // A replay stands in for the platform, feeding back the recorded
+        // input along with the delta time the frame had
+        f32 replay_delta = 0;
+        if (app_state.is_headless) {
+            if (!recorder_replay_frame(&replay_delta)) {
+                app_state.is_running = FALSE;
+                break;
+            }
+        } else if (!platform_pump_messages(&app_state.platform)) {
             app_state.is_running = FALSE;
         };
 
+        // Input and window events posted while pumping are handled here, out
+        // of the OS message loop and before the game sees this frame
+        event_dispatch_posted();
+        track_event_stats();
+
         if (!app_state.is_suspended) {
             clock_update(&app_state.clock);
             f64 current_time = app_state.clock.elapsed;
-            f64 delta = (current_time - app_state.last_time);
+            f64 delta = app_state.is_headless
+                            ? replay_delta
+                            : (current_time - app_state.last_time);
             f64 frame_start_time = platform_get_absolute_time();
 
             if (!app_state.game_inst->update(app_state.game_inst, (f32)delta)) {
@@ -131,9 +209,11 @@ b8 application_run() {
                 break;
             }
 
-            render_packet packet;
-            packet.delta_time = delta;
-            renderer_draw_frame(&packet);
+            if (!app_state.is_headless) {
+                render_packet packet;
+                packet.delta_time = delta;
+                renderer_draw_frame(&packet);
+            }
 
             f64 frame_end_time = platform_get_absolute_time();
             f64 frame_elapsed_time = frame_end_time - frame_start_time;
@@ -157,7 +237,17 @@ b8 application_run() {
             input_update(delta);
 
             app_state.last_time = current_time;
+            recorder_end_frame((f32)delta);
+        } else {
+            // Keeps input that arrived while suspended, such as the resize
+            // that resumes the game, on a frame of its own
+            recorder_end_suspended_frame();
         }
+
+        // Everything allocated with MEMORY_TAG_FRAME is released here, after
+        // the last consumer of this frame's data has run. Suspended frames
+        // still dispatch events, whose handlers may allocate frame memory
+        memory_end_frame();
     }
 
     app_state.is_running = FALSE;
@@ -166,11 +256,17 @@ b8 application_run() {
     event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_unregister(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
 
+    recorder_shutdown();
     event_shutdown();
     input_shutdown();
-    renderer_shutdown();
+    if (!app_state.is_headless) {
+        renderer_shutdown();
+    }
+    string_intern_shutdown();
 
-    platform_shutdown(&app_state.platform);
+    if (!app_state.is_headless) {
+        platform_shutdown(&app_state.platform);
+    }
 
     return TRUE;
 }
@@ -237,10 +333,24 @@ b8 application_on_resized(u16 code, void *sender, void *listener_inst,
 
                 app_state.game_inst->on_resize(app_state.game_inst, width,
                                                height);
-                renderer_on_resized(width, height);
+                if (!app_state.is_headless) {
+                    renderer_on_resized(width, height);
+                }
             }
         }
     }
 
     return FALSE;
 }
+
+void application_merge_wheel(event_context *accumulated, event_context next) {
+    // Saturates rather than wrapping when a frame's wheel deltas add up to
+    // more than an i8 holds
+    i32 z_delta = accumulated->data.i8[0] + next.data.i8[0];
+    if (z_delta < -128) {
+        z_delta = -128;
+    } else if (z_delta > 127) {
+        z_delta = 127;
+    }
+    accumulated->data.i8[0] = (i8)z_delta;
+}
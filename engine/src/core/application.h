@@ -19,6 +19,22 @@ typedef struct application_config {
 
     // The application name used in windowing, if applicable
     char *name;
+
+    // If set, every input and platform event of the session is recorded to
+    // this file, for replaying later
+    const char *record_path;
+
+    // If set, the session is replayed from a recording in this file instead
+    // of taking input. Replays run headless, without a window or renderer
+    const char *replay_path;
+
+    // If set, allocations are sampled from startup and the heap profile is
+    // written to this file at shutdown
+    const char *heap_profile_path;
+
+    // Mean bytes allocated between heap profile samples, or 0 for the
+    // profiler's default
+    u64 heap_profile_interval;
 } application_config;
 
 KAPI b8 application_create(struct game *game_inst);
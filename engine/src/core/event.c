@@ -1,25 +1,89 @@
 #include "event.h"
 #include "containers/darray.h"
+#include "containers/ring_queue.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "core/scratch_allocator.h"
+#include "platform/platform.h"
 
 typedef struct registered_event {
     void *listener;
+    // 0 once unregistered, until the code's run is next compacted
     PFN_on_event callback;
+    i32 priority;
 } registered_event;
 
+// A code's listeners are `listeners[first, first + count)`, highest priority
+// first, so dispatching a code reads one contiguous run. Unregistering only
+// marks a listener, and `count` includes those until the run is compacted
 typedef struct event_code_entry {
-    registered_event *events;
+    u32 first;
+    u32 count;
+    u32 tombstones;
+    event_coalesce_mode coalesce_mode;
+    PFN_event_merge merge;
 } event_code_entry;
 
 #define MAX_MESSAGE_CODES 16384
 
+// Marks a posted event that carries no payload
+#define NO_PAYLOAD 0xFF
+
+// Payload offsets are kept 16-byte aligned
+#define PAYLOAD_ALIGNMENT 16
+
+typedef struct posted_event {
+    u16 code;
+    // The payload buffer the event's payload lives in, or NO_PAYLOAD
+    u8 payload_buffer;
+    void *sender;
+    event_context context;
+} posted_event;
+
+// One of the buffers payloads are bump-allocated from. A buffer is only
+// rewound once every event with a payload in it has been dispatched
+typedef struct payload_buffer {
+    u8 *memory;
+    _Atomic u32 used;
+    // Payloads allocated and not yet dispatched
+    _Atomic u32 pending;
+} payload_buffer;
+
 typedef struct event_system_state {
-    event_code_entry registered[MAX_MESSAGE_CODES];
+    // Every code's run of listeners, packed one after another
+    registered_event *listeners;
+    // The entry in `codes` of each code, plus one. 0 for codes that never had
+    // a listener
+    u16 code_entries[MAX_MESSAGE_CODES];
+    event_code_entry *codes;
+    // Bumped on every change to the registry, so a dispatch working from a
+    // copy of a run can tell cheaply whether the copy is still current
+    _Atomic u32 version;
+    // Guards the registry. Never held while a callback runs, so callbacks may
+    // register and unregister freely
+    platform_mutex registry_lock;
+
+    // Events posted this frame go into one queue while the other is being
+    // dispatched, so listeners that post do not extend the current batch.
+    // Only the main thread touches these
+    posted_event *queues[2];
+    u32 post_queue;
+
+    // Events posted from other threads, moved into the batch on dispatch
+    mpmc_queue thread_queue;
+    event_frame_stats frame_stats;
+
+    // Payloads are written into `payload_buffers[payload_write_buffer]`. The
+    // main thread moves on to the next buffer at each dispatch, if it is free
+    payload_buffer payload_buffers[EVENT_PAYLOAD_BUFFER_COUNT];
+    _Atomic u32 payload_write_buffer;
 } event_system_state;
 
 static b8 is_initialized = FALSE;
 static event_system_state state;
+// Set on the thread that initialized the system, which is the one that
+// dispatches posted events
+static _Thread_local b8 is_main_thread = FALSE;
 
 b8 event_initialize() {
     if (is_initialized == TRUE) {
@@ -28,6 +92,21 @@ b8 event_initialize() {
 
     is_initialized = FALSE;
     kzero_memory(&state, sizeof(state));
+    if (!platform_mutex_create(&state.registry_lock) ||
+        !mpmc_queue_create(sizeof(posted_event), EVENT_THREAD_QUEUE_CAPACITY,
+                           &state.thread_queue)) {
+        platform_mutex_destroy(&state.registry_lock);
+        return FALSE;
+    }
+    state.listeners = darray_create(registered_event);
+    state.codes = darray_create(event_code_entry);
+    state.queues[0] = darray_create(posted_event);
+    state.queues[1] = darray_create(posted_event);
+    for (u32 i = 0; i < EVENT_PAYLOAD_BUFFER_COUNT; ++i) {
+        state.payload_buffers[i].memory =
+            kallocate(EVENT_PAYLOAD_BUFFER_SIZE, MEMORY_TAG_EVENT);
+    }
+    is_main_thread = TRUE;
     is_initialized = TRUE;
 
     KINFO("Event subsystem initialized successfully!");
@@ -36,35 +115,114 @@ b8 event_initialize() {
 }
 
 void event_shutdown() {
-    for (u16 i = 0; i < MAX_MESSAGE_CODES; ++i) {
-        if (state.registered[i].events != 0) {
-            darray_destroy(state.registered[i].events);
-            state.registered[i].events = 0;
+    darray_destroy(state.listeners);
+    darray_destroy(state.codes);
+    state.listeners = 0;
+    state.codes = 0;
+
+    darray_destroy(state.queues[0]);
+    darray_destroy(state.queues[1]);
+    state.queues[0] = state.queues[1] = 0;
+    mpmc_queue_destroy(&state.thread_queue);
+    for (u32 i = 0; i < EVENT_PAYLOAD_BUFFER_COUNT; ++i) {
+        kfree(state.payload_buffers[i].memory, EVENT_PAYLOAD_BUFFER_SIZE,
+              MEMORY_TAG_EVENT);
+    }
+    platform_mutex_destroy(&state.registry_lock);
+    is_initialized = FALSE;
+}
+
+// The functions below up to `event_fire` expect the registry lock to be held
+
+static event_code_entry *find_entry(u16 code) {
+    u16 index = state.code_entries[code];
+    return index ? &state.codes[index - 1] : 0;
+}
+
+static event_code_entry *find_or_add_entry(u16 code) {
+    if (!state.code_entries[code]) {
+        // New runs start empty at the end of the pool
+        event_code_entry entry = {0};
+        entry.first = (u32)darray_length(state.listeners);
+        darray_push(state.codes, entry);
+        state.code_entries[code] = (u16)darray_length(state.codes);
+    }
+    return find_entry(code);
+}
+
+// Moves every other run starting at or after `at` by `delta`, after listeners
+// were inserted or removed there
+static void shift_runs(event_code_entry *changed, u32 at, i32 delta) {
+    u64 count = darray_length(state.codes);
+    for (u64 i = 0; i < count; ++i) {
+        event_code_entry *entry = &state.codes[i];
+        if (entry != changed && entry->first >= at) {
+            entry->first += delta;
         }
     }
 }
 
+// Drops a run's unregistered listeners, keeping the order of the rest
+static void compact_run(event_code_entry *entry) {
+    if (!entry->tombstones) {
+        return;
+    }
+
+    registered_event *run = state.listeners + entry->first;
+    u32 live = 0;
+    for (u32 i = 0; i < entry->count; ++i) {
+        if (run[i].callback) {
+            run[live++] = run[i];
+        }
+    }
+
+    darray_erase_range(state.listeners, entry->first + live, entry->tombstones);
+    shift_runs(entry, entry->first + entry->count, -(i32)entry->tombstones);
+    entry->count = live;
+    entry->tombstones = 0;
+}
+
 b8 event_register(u16 code, void *listener, PFN_on_event on_event) {
+    return event_register_priority(code, listener, on_event, 0);
+}
+
+b8 event_register_priority(u16 code, void *listener, PFN_on_event on_event,
+                           i32 priority) {
     if (is_initialized == FALSE) {
         return FALSE;
     }
 
-    if (state.registered[code].events == 0) {
-        state.registered[code].events = darray_create(registered_event);
-    }
+    platform_mutex_lock(&state.registry_lock);
 
-    u64 registered_count = darray_length(state.registered[code].events);
-    for (u64 i = 0; i < registered_count; i++) {
-        if (state.registered[code].events[i].listener == listener) {
+    event_code_entry *entry = find_or_add_entry(code);
+    registered_event *run = state.listeners + entry->first;
+    for (u32 i = 0; i < entry->count; i++) {
+        if (run[i].callback && run[i].listener == listener) {
+            platform_mutex_unlock(&state.registry_lock);
             return FALSE;
         }
     }
 
+    // Registering is rare next to dispatching, so this is where runs are
+    // compacted and kept in order. Equal priorities keep registration order
+    compact_run(entry);
+    run = state.listeners + entry->first;
+    u32 position = 0;
+    while (position < entry->count && run[position].priority >= priority) {
+        position++;
+    }
+
     registered_event event;
     event.listener = listener;
     event.callback = on_event;
-    darray_push(state.registered[code].events, event);
+    event.priority = priority;
+    u32 at = entry->first + position;
+    darray_insert_at(state.listeners, at, event);
+    shift_runs(entry, at, 1);
+    entry->count++;
+    atomic_fetch_add_explicit(&state.version, 1, memory_order_release);
 
+    platform_mutex_unlock(&state.registry_lock);
     return TRUE;
 }
 
@@ -73,39 +231,377 @@ b8 event_unregister(u16 code, void *listener, PFN_on_event on_event) {
         return FALSE;
     }
 
-    if (state.registered[code].events == 0) {
-        return FALSE;
-    }
+    platform_mutex_lock(&state.registry_lock);
 
-    u64 registered_count = darray_length(state.registered[code].events);
-    for (u64 i = 0; i < registered_count; ++i) {
-        registered_event e = state.registered[code].events[i];
-        if (e.listener == listener && e.callback == on_event) {
-            registered_event popped_event;
-            darray_pop_at(state.registered[code].events, i, &popped_event);
+    event_code_entry *entry = find_entry(code);
+    u32 count = entry ? entry->count : 0;
+    for (u32 i = 0; i < count; ++i) {
+        registered_event *e = &state.listeners[entry->first + i];
+        if (e->callback == on_event && e->listener == listener) {
+            e->callback = 0;
+            entry->tombstones++;
+            atomic_fetch_add_explicit(&state.version, 1, memory_order_release);
+            platform_mutex_unlock(&state.registry_lock);
             return TRUE;
         }
     }
 
+    platform_mutex_unlock(&state.registry_lock);
     return FALSE;
 }
 
+b8 event_set_coalescing(u16 code, event_coalesce_mode mode,
+                        PFN_event_merge merge) {
+    if (is_initialized == FALSE) {
+        return FALSE;
+    }
+    if (mode == EVENT_COALESCE_ACCUMULATE && !merge) {
+        KERROR("event_set_coalescing - accumulating code %u requires a merge "
+               "function.",
+               code);
+        return FALSE;
+    }
+
+    platform_mutex_lock(&state.registry_lock);
+    event_code_entry *entry = find_or_add_entry(code);
+    entry->coalesce_mode = mode;
+    entry->merge = merge;
+    platform_mutex_unlock(&state.registry_lock);
+    return TRUE;
+}
+
+typedef struct listener_snapshot {
+    registered_event *events;
+    u32 count;
+    u32 version;
+    event_coalesce_mode coalesce_mode;
+    PFN_event_merge merge;
+} listener_snapshot;
+
+// Copies a code's listeners into scratch memory, so they can be called
+// without holding the registry lock
+static b8 take_snapshot(u16 code, listener_snapshot *out_snapshot) {
+    platform_mutex_lock(&state.registry_lock);
+
+    event_code_entry *entry = find_entry(code);
+    u32 live = entry ? entry->count - entry->tombstones : 0;
+    out_snapshot->count = 0;
+    out_snapshot->coalesce_mode = entry ? entry->coalesce_mode : 0;
+    out_snapshot->merge = entry ? entry->merge : 0;
+    out_snapshot->version =
+        atomic_load_explicit(&state.version, memory_order_relaxed);
+    out_snapshot->events = scratch_allocate(live * sizeof(registered_event));
+    if (out_snapshot->events && live) {
+        registered_event *run = state.listeners + entry->first;
+        for (u32 i = 0; i < entry->count; ++i) {
+            if (run[i].callback) {
+                out_snapshot->events[out_snapshot->count++] = run[i];
+            }
+        }
+    }
+
+    platform_mutex_unlock(&state.registry_lock);
+    return out_snapshot->events != 0 || live == 0;
+}
+
+// Whether a listener from a snapshot is still registered. While the registry
+// is unchanged this is one atomic load; once it has changed, every check goes
+// back to the registry
+static b8 still_registered(u16 code, const listener_snapshot *snapshot,
+                           registered_event e) {
+    if (atomic_load_explicit(&state.version, memory_order_acquire) ==
+        snapshot->version) {
+        return TRUE;
+    }
+
+    b8 found = FALSE;
+    platform_mutex_lock(&state.registry_lock);
+    event_code_entry *entry = find_entry(code);
+    u32 count = entry ? entry->count : 0;
+    for (u32 i = 0; i < count; ++i) {
+        registered_event *registered = &state.listeners[entry->first + i];
+        if (registered->callback == e.callback &&
+            registered->listener == e.listener) {
+            found = TRUE;
+            break;
+        }
+    }
+    platform_mutex_unlock(&state.registry_lock);
+
+    return found;
+}
+
 b8 event_fire(u16 code, void *sender, event_context context) {
     if (is_initialized == FALSE) {
         return FALSE;
     }
 
-    if (state.registered[code].events == 0) {
+    scratch_marker marker = scratch_begin();
+    listener_snapshot snapshot;
+    if (!take_snapshot(code, &snapshot)) {
+        KERROR("event_fire - out of scratch memory for code %u.", code);
+        scratch_end(marker);
         return FALSE;
     }
 
-    u64 registered_count = darray_length(state.registered[code].events);
-    for (u64 i = 0; i < registered_count; i++) {
-        registered_event e = state.registered[code].events[i];
-        if (e.callback(code, sender, e.listener, context)) {
-            return TRUE;
+    b8 handled = FALSE;
+    for (u32 i = 0; i < snapshot.count && !handled; i++) {
+        registered_event e = snapshot.events[i];
+        if (still_registered(code, &snapshot, e)) {
+            handled = e.callback(code, sender, e.listener, context);
         }
     }
 
-    return FALSE;
+    scratch_end(marker);
+    return handled;
+}
+
+static b8 post(posted_event *event) {
+    if (!is_main_thread) {
+        return mpmc_queue_push(&state.thread_queue, event);
+    }
+
+    darray_push(state.queues[state.post_queue], *event);
+    return TRUE;
+}
+
+b8 event_post(u16 code, void *sender, event_context context) {
+    if (is_initialized == FALSE) {
+        return FALSE;
+    }
+
+    posted_event event;
+    event.code = code;
+    event.payload_buffer = NO_PAYLOAD;
+    event.sender = sender;
+    event.context = context;
+    return post(&event);
+}
+
+// Claims the current write buffer. Counting the payload as pending before
+// checking the buffer is still current means the main thread cannot rewind
+// it in between; all four operations are sequentially consistent for that
+static u32 acquire_payload_buffer() {
+    for (;;) {
+        u32 index = atomic_load(&state.payload_write_buffer);
+        atomic_fetch_add(&state.payload_buffers[index].pending, 1);
+        if (atomic_load(&state.payload_write_buffer) == index) {
+            return index;
+        }
+        atomic_fetch_sub(&state.payload_buffers[index].pending, 1);
+    }
+}
+
+static void release_payload(u8 buffer) {
+    if (buffer != NO_PAYLOAD) {
+        atomic_fetch_sub_explicit(&state.payload_buffers[buffer].pending, 1,
+                                  memory_order_release);
+    }
+}
+
+b8 event_post_payload(u16 code, void *sender, const void *payload, u32 size) {
+    if (is_initialized == FALSE || size > EVENT_PAYLOAD_BUFFER_SIZE) {
+        return FALSE;
+    }
+
+    u32 index = acquire_payload_buffer();
+    payload_buffer *buffer = &state.payload_buffers[index];
+    u32 aligned_size =
+        (size + PAYLOAD_ALIGNMENT - 1) & ~(u32)(PAYLOAD_ALIGNMENT - 1);
+    // Only claimed if it fits, so failed posts cannot push `used` round
+    u32 offset = atomic_load_explicit(&buffer->used, memory_order_relaxed);
+    b8 fits;
+    while ((fits = offset <= EVENT_PAYLOAD_BUFFER_SIZE - aligned_size) &&
+           !atomic_compare_exchange_weak_explicit(
+               &buffer->used, &offset, offset + aligned_size,
+               memory_order_relaxed, memory_order_relaxed)) {
+    }
+    if (!buffer->memory || !fits) {
+        KWARN("event_post_payload - payload buffer full, dropping event %u "
+              "(%u bytes). Consider raising EVENT_PAYLOAD_BUFFER_SIZE.",
+              code, size);
+        release_payload(index);
+        return FALSE;
+    }
+    kcopy_memory(buffer->memory + offset, payload, size);
+
+    posted_event event;
+    event.code = code;
+    event.payload_buffer = index;
+    event.sender = sender;
+    event.context.data.u32[0] = index;
+    event.context.data.u32[1] = offset;
+    event.context.data.u32[2] = size;
+    event.context.data.u32[3] = 0;
+    if (!post(&event)) {
+        release_payload(index);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+const void *event_payload(event_context context, u32 *out_size) {
+    u32 index = context.data.u32[0];
+    if (index >= EVENT_PAYLOAD_BUFFER_COUNT) {
+        return 0;
+    }
+
+    if (out_size) {
+        *out_size = context.data.u32[2];
+    }
+    return state.payload_buffers[index].memory + context.data.u32[1];
+}
+
+// Moves payload writing on to the next buffer once every payload in it has
+// been dispatched. Otherwise the current buffer keeps filling
+static void rotate_payload_buffers() {
+    u32 current = atomic_load(&state.payload_write_buffer);
+    u32 next = (current + 1) % EVENT_PAYLOAD_BUFFER_COUNT;
+    payload_buffer *buffer = &state.payload_buffers[next];
+    if (atomic_load(&buffer->pending) == 0) {
+        atomic_store(&buffer->used, 0);
+        atomic_store(&state.payload_write_buffer, next);
+    }
+}
+
+// Stable LSD radix sort on the code, one byte per pass, so events of one
+// code keep the order they were posted in
+static void sort_by_code(posted_event *events, posted_event *temp,
+                         u64 count) {
+    posted_event *from = events;
+    posted_event *to = temp;
+    for (u32 shift = 0; shift < 16; shift += 8) {
+        u64 offsets[256] = {0};
+        for (u64 i = 0; i < count; ++i) {
+            offsets[(from[i].code >> shift) & 0xFF]++;
+        }
+
+        u64 total = 0;
+        for (u32 i = 0; i < 256; ++i) {
+            u64 bucket = offsets[i];
+            offsets[i] = total;
+            total += bucket;
+        }
+
+        for (u64 i = 0; i < count; ++i) {
+            to[offsets[(from[i].code >> shift) & 0xFF]++] = from[i];
+        }
+
+        posted_event *swap = from;
+        from = to;
+        to = swap;
+    }
+    // After an even number of passes the result is back in `events`
+}
+
+// Sends a run of events that share a code to each listener in turn,
+// coalescing them first if the code asks for it
+// @returns The number of events coalesced away
+static u64 dispatch_run(posted_event *events, b8 *handled, u64 count) {
+    u16 code = events[0].code;
+    listener_snapshot snapshot;
+    if (!take_snapshot(code, &snapshot)) {
+        KERROR("event_dispatch_posted - out of scratch memory for code %u.",
+               code);
+        return 0;
+    }
+
+    u64 posted = count;
+    // The originals stay in the batch, so their payloads are still released
+    posted_event coalesced;
+    if (snapshot.coalesce_mode != EVENT_COALESCE_NONE && count > 1) {
+        coalesced = events[count - 1];
+        if (snapshot.coalesce_mode == EVENT_COALESCE_ACCUMULATE) {
+            coalesced.context = events[0].context;
+            for (u64 i = 1; i < count; ++i) {
+                snapshot.merge(&coalesced.context, events[i].context);
+            }
+        }
+        events = &coalesced;
+        count = 1;
+    }
+
+    for (u32 l = 0; l < snapshot.count; ++l) {
+        registered_event e = snapshot.events[l];
+        for (u64 i = 0; i < count; ++i) {
+            // Checked per event, as a callback may unregister its listener
+            if (!handled[i] && still_registered(code, &snapshot, e)) {
+                handled[i] = e.callback(code, events[i].sender, e.listener,
+                                        events[i].context);
+            }
+        }
+    }
+    return posted - count;
 }
+
+void event_dispatch_posted() {
+    if (is_initialized == FALSE) {
+        return;
+    }
+
+    // Take in what other threads posted. Anything they post from here on
+    // waits for the next frame
+    posted_event *events = state.queues[state.post_queue];
+    posted_event threaded;
+    while (mpmc_queue_pop(&state.thread_queue, &threaded)) {
+        darray_push(events, threaded);
+    }
+    state.queues[state.post_queue] = events;
+
+    u64 count = darray_length(events);
+    state.post_queue ^= 1;
+    // Payloads posted from here on go into a buffer this batch does not use
+    rotate_payload_buffers();
+    state.frame_stats.posted = (u32)count;
+    state.frame_stats.dispatched = (u32)count;
+    state.frame_stats.coalesced = 0;
+    if (!count) {
+        return;
+    }
+
+    scratch_marker marker = scratch_begin();
+    posted_event *temp = scratch_allocate(count * sizeof(posted_event));
+    b8 *handled = scratch_allocate(count * sizeof(b8));
+    if (!temp || !handled) {
+        // Without scratch memory, fall back to dispatching one at a time
+        for (u64 i = 0; i < count; ++i) {
+            event_fire(events[i].code, events[i].sender, events[i].context);
+            release_payload(events[i].payload_buffer);
+        }
+        scratch_end(marker);
+        darray_clear(events);
+        return;
+    }
+
+    // Input usually arrives as one code at a time, already in order
+    for (u64 i = 1; i < count; ++i) {
+        if (events[i].code < events[i - 1].code) {
+            sort_by_code(events, temp, count);
+            break;
+        }
+    }
+    kzero_memory(handled, count * sizeof(b8));
+
+    u64 first = 0;
+    u64 coalesced = 0;
+    while (first < count) {
+        u64 end = first + 1;
+        while (end < count && events[end].code == events[first].code) {
+            end++;
+        }
+
+        coalesced += dispatch_run(events + first, handled + first, end - first);
+        first = end;
+    }
+    state.frame_stats.dispatched = (u32)(count - coalesced);
+    state.frame_stats.coalesced = (u32)coalesced;
+
+    for (u64 i = 0; i < count; ++i) {
+        release_payload(events[i].payload_buffer);
+    }
+
+    scratch_end(marker);
+    darray_clear(events);
+}
+
+event_frame_stats event_get_frame_stats() { return state.frame_stats; }
@@ -25,6 +25,55 @@ typedef struct event_context {
 typedef b8 (*PFN_on_event)(u16 code, void *sender, void *listener_inst,
                            event_context data);
 
+// The most events other threads can have posted and waiting for dispatch.
+// Posting beyond that fails until the main thread has caught up
+#ifndef EVENT_THREAD_QUEUE_CAPACITY
+#define EVENT_THREAD_QUEUE_CAPACITY 4096
+#endif
+
+// Size of each buffer that posted event payloads are copied into
+#ifndef EVENT_PAYLOAD_BUFFER_SIZE
+#define EVENT_PAYLOAD_BUFFER_SIZE (64 * 1024)
+#endif
+
+// Payload buffers rotate at each dispatch, so a buffer still referenced by
+// undispatched events is skipped rather than overwritten
+#define EVENT_PAYLOAD_BUFFER_COUNT 3
+
+// How the events posted for one code in a frame are combined before dispatch
+typedef enum event_coalesce_mode {
+    // Every posted event is dispatched
+    EVENT_COALESCE_NONE = 0,
+    // Only the last event is dispatched, e.g. for absolute positions or sizes
+    EVENT_COALESCE_LAST_VALUE,
+    // The events are folded into one with a merge function, e.g. for deltas
+    EVENT_COALESCE_ACCUMULATE
+} event_coalesce_mode;
+
+/**
+ * Folds the context of a later event into the combined context so far
+ * @param accumulated The combined context, starting as the first event's
+ * @param next The context of the next event posted
+ */
+typedef void (*PFN_event_merge)(event_context *accumulated,
+                                event_context next);
+
+// Counts for the most recent `event_dispatch_posted`
+typedef struct event_frame_stats {
+    // Events taken from the posted queues
+    u32 posted;
+    // Events sent to listeners once coalesced
+    u32 dispatched;
+    // Events folded into another by coalescing
+    u32 coalesced;
+} event_frame_stats;
+
+// Registering, unregistering, firing and posting are safe from any thread.
+// Callbacks run on the thread that fires the event, or on the main thread for
+// posted events. A listener unregistered while another thread is dispatching
+// to it may still receive the event already being delivered, but no later
+// ones
+
 b8 event_initialize();
 void event_shutdown();
 
@@ -40,6 +89,21 @@ void event_shutdown();
  */
 KAPI b8 event_register(u16 code, void *listener, PFN_on_event on_event);
 
+/**
+ * Registers like `event_register`, with a priority deciding the order
+ * listeners are called in. Higher priorities are called first, and listeners
+ * of equal priority in the order they registered. `event_register` uses
+ * priority 0
+ * @param code The event code to listen for
+ * @param listener A pointer to a listener instance. Can be 0/NULL
+ * @param on_event The callback function pointer to be invoked when the event
+ * code is fired.
+ * @param priority The listener's priority
+ * @returns TRUE if the event is sucessfully registered; otherwise FALSE
+ */
+KAPI b8 event_register_priority(u16 code, void *listener, PFN_on_event on_event,
+                                i32 priority);
+
 /**
  * Unregister to listen for when events are sent with the provided code. If no
  * matching registration is found, this function returns FALSE
@@ -61,6 +125,80 @@ KAPI b8 event_unregister(u16 code, void *listener, PFN_on_event on_event);
  */
 KAPI b8 event_fire(u16 code, void *sender, event_context context);
 
+/**
+ * Queues an event to be sent to listeners of the given code when the posted
+ * events are next dispatched, once per frame after the platform's messages
+ * have been pumped. Events posted while dispatching are held for the next
+ * frame. Use `event_fire` for the rare events that must be handled
+ * immediately. Posting from a thread other than the main thread goes through
+ * a lock-free queue
+ * @param code The event code to post
+ * @param sender A pointer to the sender. Can be 0/NULL. Must still be valid
+ * when the event is dispatched
+ * @param data The event data
+ * @returns TRUE if the event was queued; FALSE if the system is not
+ * initialized or, from another thread, the queue is full
+ */
+KAPI b8 event_post(u16 code, void *sender, event_context context);
+
+/**
+ * Posts an event whose data does not fit in an event_context, such as text
+ * input or a file path. The payload is copied into a shared buffer rather
+ * than allocated, and the event's context describes where it is; listeners
+ * read it back with `event_payload`. Safe from any thread
+ * @param code The event code to post
+ * @param sender A pointer to the sender. Can be 0/NULL
+ * @param payload The data to copy
+ * @param size The size of the payload in bytes. At most
+ * EVENT_PAYLOAD_BUFFER_SIZE
+ * @returns TRUE if the event was queued; FALSE if it could not be, e.g.
+ * because this frame's payload buffer is full
+ */
+KAPI b8 event_post_payload(u16 code, void *sender, const void *payload,
+                           u32 size);
+
+/**
+ * Gets the payload of an event posted with `event_post_payload`. Only valid
+ * for such events, and only during the callback
+ * @param context The context the listener was called with
+ * @param out_size A pointer to hold the payload's size. Can be 0/NULL
+ * @returns A pointer to the payload, 16-byte aligned
+ */
+KAPI const void *event_payload(event_context context, u32 *out_size);
+
+/**
+ * Sends every event posted since the last call. Events are grouped by code,
+ * keeping their posted order within a code, and each listener of a code is
+ * handed all of that code's events before the next listener. Order across
+ * codes is not preserved, so events whose relative order matters, such as a
+ * key's press and release, should be sent with `event_fire`. Returning TRUE
+ * from a callback stops that one event from reaching later listeners. Only
+ * call from the main thread
+ */
+void event_dispatch_posted();
+
+/**
+ * Sets how events posted for a code are coalesced. Coalescing happens when
+ * posted events are dispatched, before any listener runs, and only within one
+ * frame's batch; the sender of the last event is kept. Events sent with
+ * `event_fire` are never coalesced, and accumulating is not meaningful for
+ * events posted with a payload
+ * @param code The event code
+ * @param mode The coalescing mode. EVENT_COALESCE_NONE, the default, turns it
+ * off
+ * @param merge The merge function for EVENT_COALESCE_ACCUMULATE. Ignored
+ * otherwise
+ * @returns TRUE on success; FALSE if accumulating without a merge function
+ */
+KAPI b8 event_set_coalescing(u16 code, event_coalesce_mode mode,
+                             PFN_event_merge merge);
+
+/**
+ * Gets the counts of the most recent dispatch of posted events, including how
+ * many were coalesced away. Only call from the main thread
+ */
+KAPI event_frame_stats event_get_frame_stats();
+
 // System internal event codes. Application should use codes beyond 255.
 typedef enum system_event_code {
     // Shuts the application down on the next frame.
@@ -110,5 +248,12 @@ typedef enum system_event_code {
      */
     EVENT_CODE_RESIZED = 0x08,
 
+    // A memory tag went over the budget set with `memory_set_tag_budget`.
+    /* Context usage:
+     * u16 tag = data.data.u16[0];
+     * u64 current_bytes = data.data.u64[1];
+     */
+    EVENT_CODE_MEMORY_BUDGET_EXCEEDED = 0x09,
+
     MAX_EVENT_CODE = 0xFF
 } system_event_code;
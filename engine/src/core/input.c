@@ -1,10 +1,16 @@
 #include "core/input.h"
+#include "containers/bitset.h"
 #include "core/event.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "core/recorder.h"
 
+STATIC_ASSERT(KEYS_MAX_KEYS <= 256, "Expected key codes to fit in 256 bits.");
+
+// One bit per key, so copying and comparing the whole keyboard touches 32
+// bytes
 typedef struct keyboard_state {
-    b8 keys[256];
+    bitset256 keys;
 } keyboard_state;
 
 typedef struct mouse_state {
@@ -43,24 +49,29 @@ void input_update(f64 delta_time) {
 }
 
 void input_process_key(keys key, b8 pressed) {
-    if (state.keyboard_current.keys[key] != pressed) {
-        state.keyboard_current.keys[key] = pressed;
+    recorder_record(RECORDER_ENTRY_KEY, key, pressed, 0, 0);
+    if (bitset256_test(&state.keyboard_current.keys, key) != pressed) {
+        bitset256_assign(&state.keyboard_current.keys, key, pressed);
 
         event_context context;
         context.data.u16[0] = key;
 
+        // Fired rather than posted: posted events are grouped by code, which
+        // would swap a release and a later press within one frame
         event_fire(pressed ? EVENT_CODE_KEY_PRESSED : EVENT_CODE_KEY_RELEASED,
                    0, context);
     }
 }
 
 void input_process_button(buttons button, b8 pressed) {
+    recorder_record(RECORDER_ENTRY_BUTTON, button, pressed, 0, 0);
     if (state.mouse_current.buttons[button] != pressed) {
         state.mouse_current.buttons[button] = pressed;
 
         event_context context;
         context.data.u16[0] = button;
 
+        // Fired for the same reason as keys
         event_fire(pressed ? EVENT_CODE_BUTTON_PRESSED
                            : EVENT_CODE_BUTTON_RELEASED,
                    0, context);
@@ -68,6 +79,7 @@ void input_process_button(buttons button, b8 pressed) {
 }
 
 void input_process_mouse_move(i16 x, i16 y) {
+    recorder_record(RECORDER_ENTRY_MOUSE_MOVE, 0, 0, x, y);
     if (state.mouse_current.x != x || state.mouse_current.y != y) {
         // KDEBUG("Mouse pos: %i, %i", x ,y);
 
@@ -77,14 +89,15 @@ void input_process_mouse_move(i16 x, i16 y) {
         event_context context;
         context.data.u16[0] = x;
         context.data.u16[1] = y;
-        event_fire(EVENT_CODE_MOUSE_MOVED, 0, context);
+        event_post(EVENT_CODE_MOUSE_MOVED, 0, context);
     }
 }
 
 void input_process_mouse_wheel(i8 z_delta) {
+    recorder_record(RECORDER_ENTRY_MOUSE_WHEEL, 0, (u8)z_delta, 0, 0);
     event_context context;
     context.data.u8[0] = z_delta;
-    event_fire(EVENT_CODE_MOUSE_WHEEL, 0, context);
+    event_post(EVENT_CODE_MOUSE_WHEEL, 0, context);
 }
 
 b8 input_is_key_down(keys key) {
@@ -92,7 +105,7 @@ b8 input_is_key_down(keys key) {
         return FALSE;
     }
 
-    return state.keyboard_current.keys[key] == TRUE;
+    return bitset256_test(&state.keyboard_current.keys, key);
 }
 
 b8 input_is_key_up(keys key) {
@@ -100,7 +113,7 @@ b8 input_is_key_up(keys key) {
         return FALSE;
     }
 
-    return state.keyboard_current.keys[key] == FALSE;
+    return !bitset256_test(&state.keyboard_current.keys, key);
 }
 
 b8 input_was_key_down(keys key) {
@@ -108,7 +121,7 @@ b8 input_was_key_down(keys key) {
         return FALSE;
     }
 
-    return state.keyboard_previous.keys[key] == TRUE;
+    return bitset256_test(&state.keyboard_previous.keys, key);
 }
 
 b8 input_was_key_up(keys key) {
@@ -116,7 +129,16 @@ b8 input_was_key_up(keys key) {
         return FALSE;
     }
 
-    return state.keyboard_previous.keys[key] == FALSE;
+    return !bitset256_test(&state.keyboard_previous.keys, key);
+}
+
+b8 input_any_key_changed() {
+    if (!initialized) {
+        return FALSE;
+    }
+
+    return bitset256_differ(&state.keyboard_current.keys,
+                            &state.keyboard_previous.keys);
 }
 
 b8 input_is_button_up(buttons button) {
@@ -151,6 +151,12 @@ KAPI b8 input_is_key_up(keys key);
 KAPI b8 input_was_key_down(keys key);
 KAPI b8 input_was_key_up(keys key);
 
+/**
+ * @returns TRUE if any key was pressed or released since the last
+ * `input_update`; otherwise FALSE
+ */
+KAPI b8 input_any_key_changed();
+
 void input_process_key(keys key, b8 pressed);
 
 KAPI b8 input_is_button_down(buttons button);
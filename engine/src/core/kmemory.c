@@ -1,53 +1,534 @@
 #include "kmemory.h"
 
-#include "core/kstring.h"
+#include "core/asserts.h"
+#include "core/event.h"
+#include "core/linear_allocator.h"
 #include "core/logger.h"
+#include "core/memory_profiler.h"
+#include "core/pool_allocator.h"
+#include "core/scratch_allocator.h"
+#include "core/tlsf_allocator.h"
 #include "platform/platform.h"
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <string.h>
 
+// Allocation accounting for one thread. Only the owning thread writes to its
+// shard, so updates are plain relaxed loads and stores instead of locked
+// read-modify-writes, and each shard sits on its own cache lines so threads
+// never write to a line another thread is writing to.
+typedef struct memory_stat_shard {
+    alignas(KCACHE_LINE_SIZE) _Atomic i64
+        tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    _Atomic u64 allocation_count[MEMORY_TAG_MAX_TAGS];
+    _Atomic u64 free_count[MEMORY_TAG_MAX_TAGS];
+
+    atomic_bool in_use;
+} memory_stat_shard;
+
 struct memory_stats {
-    u64 total_allocated;
-    u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    // Frame arena bytes used by the last completed frame
+    u64 frame_last_used;
+    // The most frame arena bytes any single frame has used
+    u64 frame_high_water_mark;
+
+    u64 frame_number;
+    // Merged counts at the end of the last frame, to diff the next one against
+    u64 last_allocation_count[MEMORY_TAG_MAX_TAGS];
+    u64 last_free_count[MEMORY_TAG_MAX_TAGS];
+    // Allocations and frees made during the last completed frame
+    u64 frame_allocations[MEMORY_TAG_MAX_TAGS];
+    u64 frame_frees[MEMORY_TAG_MAX_TAGS];
+    // Only written at the end of a frame; snapshots fold in the current usage
+    // without storing it
+    u64 peak_bytes[MEMORY_TAG_MAX_TAGS];
+
+    _Atomic u64 budgets[MEMORY_TAG_MAX_TAGS];
+    // Set once the budget event has fired for a tag, until it is back within
+    // budget
+    b8 over_budget[MEMORY_TAG_MAX_TAGS];
 };
 
 static const char *memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "UNKOWN     ", "ARRAY      ", "DARRAY     ", "DICT       ", "RING_QUEUE ",
     "BST        ", "STRING     ", "APPLICATION", "JOB        ", "TEXTURE    ",
     "MAT_INST   ", "RENDERER   ", "GAME       ", "TRANSFORM  ", "ENTITY     ",
-    "ENTITY_NODE", "SCENE      "};
+    "ENTITY_NODE", "SCENE      ", "EVENT      ", "FRAME      ", "SCRATCH    "};
 
 static struct memory_stats stats;
+static memory_stat_shard stat_shards[KMEMORY_MAX_STAT_SHARDS];
+// Shared by threads that could not get a shard of their own
+static memory_stat_shard overflow_shard;
+static _Thread_local memory_stat_shard *thread_shard;
+// Hands a thread's shard back when the thread exits
+static platform_thread_key shard_key;
 
-void initialize_memory() { platform_zero_memory(&stats, sizeof(stats)); }
+// Frame arena allocations made since the last `memory_end_frame`
+static u64 frame_allocated;
+static u64 frame_allocation_count;
 
-void shutdown_memory() {}
+// A MEMORY_TAG_FRAME allocation the frame arena had no room for, served from
+// the heap instead. The header sits in front of the block, padded out to the
+// block's alignment, and the list is freed by `memory_end_frame`
+typedef struct frame_overflow_block {
+    struct frame_overflow_block *next;
+    u64 total_size;
+    u64 alignment;
+} frame_overflow_block;
 
-void *kallocate(u64 size, memory_tag tag) {
+static frame_overflow_block *frame_overflow;
+static void free_frame_overflow();
+// Set on the thread that initialized the memory system, the only one allowed
+// to make MEMORY_TAG_FRAME allocations
+static _Thread_local b8 is_main_thread;
+
+static linear_allocator frame_arena;
+static tlsf_allocator heap;
+static platform_mutex heap_mutex;
+// Pools register from whichever thread creates them while the report may be
+// built on another, so the list is only touched under this lock
+static platform_mutex pool_mutex;
+static pool_allocator *pools[KMEMORY_MAX_POOLS];
+
+static void release_stat_shard(void *shard) {
+    // Other exit handlers may still free memory after this one. Forgetting
+    // the shard makes them take a new one, which is handed back in a later
+    // round of exit handlers, rather than write to a shard that another
+    // thread may already own
+    thread_shard = 0;
+    atomic_store_explicit(&((memory_stat_shard *)shard)->in_use, FALSE,
+                          memory_order_release);
+}
+
+static memory_stat_shard *acquire_stat_shard() {
+    // A shard released by an exited thread keeps its counts; they remain
+    // part of the merged totals and the new owner keeps adding to them.
+    for (u32 i = 0; i < KMEMORY_MAX_STAT_SHARDS; ++i) {
+        _Bool expected = FALSE;
+        if (atomic_compare_exchange_strong(&stat_shards[i].in_use, &expected,
+                                           TRUE)) {
+            platform_thread_key_set(&shard_key, &stat_shards[i]);
+            return &stat_shards[i];
+        }
+    }
+
+    return &overflow_shard;
+}
+
+static void shard_add_i64(memory_stat_shard *shard, _Atomic i64 *counter,
+                          i64 value) {
+    if (shard == &overflow_shard) {
+        atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+    } else {
+        atomic_store_explicit(
+            counter,
+            atomic_load_explicit(counter, memory_order_relaxed) + value,
+            memory_order_relaxed);
+    }
+}
+
+static void shard_add_u64(memory_stat_shard *shard, _Atomic u64 *counter,
+                          u64 value) {
+    if (shard == &overflow_shard) {
+        atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+    } else {
+        atomic_store_explicit(
+            counter,
+            atomic_load_explicit(counter, memory_order_relaxed) + value,
+            memory_order_relaxed);
+    }
+}
+
+static memory_stat_shard *get_stat_shard() {
+    if (!thread_shard) {
+        thread_shard = acquire_stat_shard();
+    }
+    return thread_shard;
+}
+
+static void record_allocation(memory_tag tag, u64 size, u64 count) {
+    memory_stat_shard *shard = get_stat_shard();
+    shard_add_i64(shard, &shard->tagged_allocations[tag], (i64)size);
+    shard_add_u64(shard, &shard->allocation_count[tag], count);
+}
+
+static void record_free(memory_tag tag, u64 size, u64 count) {
+    memory_stat_shard *shard = get_stat_shard();
+    shard_add_i64(shard, &shard->tagged_allocations[tag], -(i64)size);
+    shard_add_u64(shard, &shard->free_count[tag], count);
+}
+
+void memory_track_allocation(u64 size, u64 count, memory_tag tag) {
+    record_allocation(tag, size, count);
+}
+
+void memory_track_free(u64 size, u64 count, memory_tag tag) {
+    record_free(tag, size, count);
+}
+
+void initialize_memory() {
+    platform_zero_memory(&stats, sizeof(stats));
+    is_main_thread = TRUE;
+    // Exit handlers run in the order their keys were created. The scratch
+    // stack's goes first, so the frees it records still land in the
+    // thread's own stat shard
+    scratch_allocator_initialize();
+    platform_thread_key_create(release_stat_shard, &shard_key);
+    linear_allocator_create(KMEMORY_FRAME_ARENA_SIZE, 0, &frame_arena);
+    platform_mutex_create(&pool_mutex);
+    memory_profiler_initialize();
+
+#if KMEMORY_USE_TLSF
+    platform_mutex_create(&heap_mutex);
+    if (!tlsf_allocator_create(KMEMORY_HEAP_SIZE, 0, &heap)) {
+        KWARN("Failed to reserve the TLSF heap, falling back to the platform "
+              "allocator.");
+    }
+#endif
+}
+
+void shutdown_memory() {
+    free_frame_overflow();
+    memory_profiler_shutdown();
+#if KMEMORY_USE_TLSF
+    tlsf_allocator_destroy(&heap);
+    platform_mutex_destroy(&heap_mutex);
+#endif
+    scratch_allocator_shutdown();
+    linear_allocator_destroy(&frame_arena);
+    platform_mutex_destroy(&pool_mutex);
+    platform_thread_key_destroy(&shard_key);
+}
+
+void memory_get_tag_stats(memory_tag_stats out_stats[MEMORY_TAG_MAX_TAGS]) {
+    i64 current_bytes[MEMORY_TAG_MAX_TAGS] = {0};
+    platform_zero_memory(out_stats,
+                         sizeof(memory_tag_stats) * MEMORY_TAG_MAX_TAGS);
+
+    for (u32 i = 0; i <= KMEMORY_MAX_STAT_SHARDS; ++i) {
+        memory_stat_shard *shard =
+            i < KMEMORY_MAX_STAT_SHARDS ? &stat_shards[i] : &overflow_shard;
+
+        for (u32 tag = 0; tag < MEMORY_TAG_MAX_TAGS; ++tag) {
+            current_bytes[tag] += atomic_load_explicit(
+                &shard->tagged_allocations[tag], memory_order_relaxed);
+            out_stats[tag].allocation_count += atomic_load_explicit(
+                &shard->allocation_count[tag], memory_order_relaxed);
+            out_stats[tag].free_count += atomic_load_explicit(
+                &shard->free_count[tag], memory_order_relaxed);
+        }
+    }
+
+    for (u32 tag = 0; tag < MEMORY_TAG_MAX_TAGS; ++tag) {
+        out_stats[tag].current_bytes =
+            current_bytes[tag] > 0 ? (u64)current_bytes[tag] : 0;
+    }
+}
+
+void memory_register_pool(pool_allocator *pool) {
+    platform_mutex_lock(&pool_mutex);
+    for (u32 i = 0; i < KMEMORY_MAX_POOLS; ++i) {
+        if (!pools[i]) {
+            pools[i] = pool;
+            platform_mutex_unlock(&pool_mutex);
+            return;
+        }
+    }
+    platform_mutex_unlock(&pool_mutex);
+
+    KWARN("More than %i pool allocators exist; '%s' will not be reported.",
+          KMEMORY_MAX_POOLS, pool->name);
+}
+
+void memory_unregister_pool(pool_allocator *pool) {
+    platform_mutex_lock(&pool_mutex);
+    for (u32 i = 0; i < KMEMORY_MAX_POOLS; ++i) {
+        if (pools[i] == pool) {
+            pools[i] = 0;
+            break;
+        }
+    }
+    platform_mutex_unlock(&pool_mutex);
+}
+
+static void *heap_allocate(u64 size, u64 alignment) {
+#if KMEMORY_USE_TLSF
+    platform_mutex_lock(&heap_mutex);
+    void *block = tlsf_allocator_allocate_aligned(&heap, size, alignment);
+    platform_mutex_unlock(&heap_mutex);
+    if (block) {
+        return block;
+    }
+#endif
+
+    if (alignment > PLATFORM_DEFAULT_ALIGNMENT) {
+        return platform_allocate_aligned(size, alignment);
+    }
+    return platform_allocate(size, TRUE);
+}
+
+static void heap_free(void *block, u64 alignment) {
+#if KMEMORY_USE_TLSF
+    if (tlsf_allocator_owns(&heap, block)) {
+        platform_mutex_lock(&heap_mutex);
+        tlsf_allocator_free(&heap, block);
+        platform_mutex_unlock(&heap_mutex);
+        return;
+    }
+#endif
+
+    if (alignment > PLATFORM_DEFAULT_ALIGNMENT) {
+        platform_free_aligned(block);
+    } else {
+        platform_free(block, TRUE);
+    }
+}
+
+static void *frame_allocate(u64 size, u64 alignment) {
+    // Checked up front, with room for the worst-case alignment padding, so
+    // a full arena is not reported as an error by the linear allocator
+    if (frame_arena.allocated + size + alignment <= frame_arena.total_size) {
+        void *block =
+            linear_allocator_allocate_aligned(&frame_arena, size, alignment);
+        if (block) {
+            return block;
+        }
+    }
+
+    if (!frame_overflow) {
+        KWARN("The frame arena is full; this frame's remaining allocations go "
+              "to the heap. Consider raising KMEMORY_FRAME_ARENA_SIZE.");
+    }
+
+    u64 block_alignment = KMAX(alignment, PLATFORM_DEFAULT_ALIGNMENT);
+    u64 header_size = (sizeof(frame_overflow_block) + block_alignment - 1) &
+                      ~(block_alignment - 1);
+    u8 *memory = heap_allocate(header_size + size, block_alignment);
+    if (!memory) {
+        return 0;
+    }
+
+    frame_overflow_block *header = (frame_overflow_block *)memory;
+    header->next = frame_overflow;
+    header->total_size = header_size + size;
+    header->alignment = block_alignment;
+    frame_overflow = header;
+    return memory + header_size;
+}
+
+static void free_frame_overflow() {
+    while (frame_overflow) {
+        frame_overflow_block *next = frame_overflow->next;
+        heap_free(frame_overflow, frame_overflow->alignment);
+        frame_overflow = next;
+    }
+}
+
+static void check_budget(memory_tag tag, u64 current_bytes) {
+    u64 budget =
+        atomic_load_explicit(&stats.budgets[tag], memory_order_relaxed);
+    if (!budget || current_bytes <= budget) {
+        stats.over_budget[tag] = FALSE;
+        return;
+    }
+
+    if (stats.over_budget[tag]) {
+        return;
+    }
+    stats.over_budget[tag] = TRUE;
+
+    event_context context;
+    context.data.u16[0] = tag;
+    context.data.u64[1] = current_bytes;
+    event_fire(EVENT_CODE_MEMORY_BUDGET_EXCEEDED, 0, context);
+}
+
+void memory_end_frame() {
+    stats.frame_last_used = frame_arena.allocated;
+    if (frame_arena.allocated > stats.frame_high_water_mark) {
+        stats.frame_high_water_mark = frame_arena.allocated;
+    }
+
+    // Sample before the frame arena is released so its usage counts towards
+    // the peak
+    memory_tag_stats tag_stats[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(tag_stats);
+
+    record_free(MEMORY_TAG_FRAME, frame_allocated, frame_allocation_count);
+    frame_allocated = 0;
+    frame_allocation_count = 0;
+
+    linear_allocator_free_all(&frame_arena);
+    free_frame_overflow();
+
+    for (u32 tag = 0; tag < MEMORY_TAG_MAX_TAGS; ++tag) {
+        memory_tag_stats *current = &tag_stats[tag];
+        if (tag == MEMORY_TAG_FRAME) {
+            // The frame's allocations were all just freed
+            current->free_count = current->allocation_count;
+        }
+
+        stats.frame_allocations[tag] =
+            current->allocation_count - stats.last_allocation_count[tag];
+        stats.frame_frees[tag] =
+            current->free_count - stats.last_free_count[tag];
+        stats.last_allocation_count[tag] = current->allocation_count;
+        stats.last_free_count[tag] = current->free_count;
+
+        if (current->current_bytes > stats.peak_bytes[tag]) {
+            stats.peak_bytes[tag] = current->current_bytes;
+        }
+
+        check_budget(tag, current->current_bytes);
+    }
+
+    stats.frame_number++;
+}
+
+void memory_get_snapshot(memory_snapshot *out_snapshot) {
+    memory_tag_stats tag_stats[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(tag_stats);
+
+    out_snapshot->total_bytes = 0;
+    out_snapshot->frame_number = stats.frame_number;
+
+    for (u32 tag = 0; tag < MEMORY_TAG_MAX_TAGS; ++tag) {
+        memory_tag_stats *current = &tag_stats[tag];
+        memory_tag_snapshot *out = &out_snapshot->tags[tag];
+
+        out->current_bytes = current->current_bytes;
+        out->peak_bytes = KMAX(stats.peak_bytes[tag], current->current_bytes);
+        out->live_allocations =
+            current->allocation_count > current->free_count
+                ? current->allocation_count - current->free_count
+                : 0;
+        out->frame_allocations = stats.frame_allocations[tag];
+        out->frame_frees = stats.frame_frees[tag];
+        out->budget_bytes =
+            atomic_load_explicit(&stats.budgets[tag], memory_order_relaxed);
+
+        out_snapshot->total_bytes += current->current_bytes;
+    }
+}
+
+void memory_set_tag_budget(memory_tag tag, u64 budget_bytes) {
+    if (tag >= MEMORY_TAG_MAX_TAGS) {
+        KERROR("memory_set_tag_budget - invalid memory tag %u.", tag);
+        return;
+    }
+
+    atomic_store_explicit(&stats.budgets[tag], budget_bytes,
+                          memory_order_relaxed);
+}
+
+static void *allocate(u64 size, u64 alignment, memory_tag tag, b8 zero) {
     if (tag == MEMORY_TAG_UNKOWN) {
         KWARN("kallocate callend using MEMORY_TAG_UNKOWN. Re-class this "
               "allocation.");
     }
 
-    stats.total_allocated += size;
-    stats.tagged_allocations[tag] += size;
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        KERROR("kallocate_aligned - alignment %llu is not a power of two.",
+               alignment);
+        return 0;
+    }
+
+    if (tag == MEMORY_TAG_FRAME) {
+        KASSERT_MSG(is_main_thread,
+                    "MEMORY_TAG_FRAME allocations are main-thread only.");
+        void *block = frame_allocate(size, alignment);
+        if (!block) {
+            KERROR("kallocate_aligned - failed to allocate %lluB for the "
+                   "frame.",
+                   size);
+            return 0;
+        }
+
+        frame_allocated += size;
+        frame_allocation_count++;
+        record_allocation(tag, size, 1);
+
+        if (zero) {
+            platform_zero_memory(block, size);
+        }
+        return block;
+    }
+
+    // Large blocks get their own huge-page mapping. The pages come from the
+    // OS already zeroed, and their alignment covers any sane request. They
+    // are accounted at their mapped size, which rounding up to whole huge
+    // pages can make far bigger than requested
+    if (size >= KMEMORY_LARGE_ALLOCATION_SIZE &&
+        alignment <= PLATFORM_HUGE_PAGE_SIZE) {
+        void *block = platform_allocate_large(size);
+        if (block) {
+            record_allocation(tag, platform_large_allocation_size(size), 1);
+#if KMEMORY_PROFILER
+            memory_profiler_on_allocate(block, size);
+#endif
+        }
+        return block;
+    }
+
+    void *block = heap_allocate(size, alignment);
+    if (!block) {
+        KERROR("kallocate_aligned - failed to allocate %lluB.", size);
+        return 0;
+    }
 
-    void *block = platform_allocate(size, FALSE);
-    platform_zero_memory(block, size);
+    record_allocation(tag, size, 1);
+#if KMEMORY_PROFILER
+    memory_profiler_on_allocate(block, size);
+#endif
+    if (zero) {
+        platform_zero_memory(block, size);
+    }
 
     return block;
 }
 
+void *kallocate(u64 size, memory_tag tag) {
+    return allocate(size, 1, tag, TRUE);
+}
+
+void *kallocate_uninitialized(u64 size, memory_tag tag) {
+    return allocate(size, 1, tag, FALSE);
+}
+
+void *kallocate_aligned(u64 size, u64 alignment, memory_tag tag) {
+    return allocate(size, alignment, tag, TRUE);
+}
+
 void kfree(void *block, u64 size, memory_tag tag) {
+    kfree_aligned(block, size, 1, tag);
+}
+
+void kfree_aligned(void *block, u64 size, u64 alignment, memory_tag tag) {
     if (tag == MEMORY_TAG_UNKOWN) {
         KWARN("kfree callend using MEMORY_TAG_UNKOWN. Re-class this "
               "allocation.");
     }
 
-    stats.total_allocated -= size;
-    stats.tagged_allocations[tag] -= size;
+    // Frame allocations are released all at once by `memory_end_frame`
+    if (tag == MEMORY_TAG_FRAME || !block) {
+        return;
+    }
+
+#if KMEMORY_PROFILER
+    // Before the block is released, so its address cannot be handed out and
+    // sampled again while the old sample is still recorded
+    memory_profiler_on_free(block);
+#endif
+    if (size >= KMEMORY_LARGE_ALLOCATION_SIZE &&
+        alignment <= PLATFORM_HUGE_PAGE_SIZE) {
+        record_free(tag, platform_large_allocation_size(size), 1);
+        platform_free_large(block, size);
+        return;
+    }
 
-    platform_free(block, FALSE);
+    record_free(tag, size, 1);
+    heap_free(block, alignment);
 }
 
 void *kzero_memory(void *block, u64 size) {
@@ -58,43 +539,116 @@ void *kcopy_memory(void *dest, const void *source, u64 size) {
     return platform_copy_memory(dest, source, size);
 }
 
+void *kmove_memory(void *dest, const void *source, u64 size) {
+    return platform_move_memory(dest, source, size);
+}
+
 void *kset_memory(void *block, i32 value, u64 size) {
     return platform_set_memory(block, value, size);
 }
 
-char *get_memory_usage_str() {
+static const char *get_unit_for_size(u64 size_bytes, f32 *out_amount) {
     const u64 gib = 1024 * 1024 * 1024;
     const u64 mib = 1024 * 1024;
     const u64 kib = 1024;
 
-    char buffer[8000] = "System memory use (tagged): \n";
-    u64 offset = strlen(buffer);
+    if (size_bytes >= gib) {
+        *out_amount = size_bytes / (f32)gib;
+        return "GiB";
+    } else if (size_bytes >= mib) {
+        *out_amount = size_bytes / (f32)mib;
+        return "MiB";
+    } else if (size_bytes >= kib) {
+        *out_amount = size_bytes / (f32)kib;
+        return "KiB";
+    }
+
+    *out_amount = (f32)size_bytes;
+    return "B";
+}
+
+char *get_memory_usage_str() {
+    memory_snapshot snapshot;
+    memory_get_snapshot(&snapshot);
+
+    // A line per tag and per pool, plus the frame arena and heap lines
+    u64 capacity = (MEMORY_TAG_MAX_TAGS + KMEMORY_MAX_POOLS + 3) * 128;
+    char *buffer = scratch_allocate(capacity);
+    if (!buffer) {
+        return "";
+    }
+
+    u64 offset = snprintf(buffer, capacity, "System memory use (tagged): \n");
 
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
-        char unit[4] = "XiB";
-        float amount = 1.0f;
-
-        if (stats.tagged_allocations[i] >= gib) {
-            unit[0] = 'G';
-            amount = stats.tagged_allocations[i] / (float)gib;
-        } else if (stats.tagged_allocations[i] >= mib) {
-            unit[0] = 'M';
-            amount = stats.tagged_allocations[i] / (float)mib;
-        } else if (stats.tagged_allocations[i] >= kib) {
-            unit[0] = 'K';
-            amount = stats.tagged_allocations[i] / (float)kib;
-        } else {
-            unit[0] = 'B';
-            unit[1] = 0;
-            amount = (float)stats.tagged_allocations[i];
-        }
+        memory_tag_snapshot *tag = &snapshot.tags[i];
+
+        f32 amount = 1.0f;
+        f32 tag_peak_amount = 1.0f;
+        const char *unit = get_unit_for_size(tag->current_bytes, &amount);
+        const char *tag_peak_unit =
+            get_unit_for_size(tag->peak_bytes, &tag_peak_amount);
 
-        i32 length = snprintf(buffer + offset, 8000, "  %s: %.2f%s\n",
-                              memory_tag_strings[i], amount, unit);
+        i32 length = snprintf(
+            buffer + offset, capacity - offset,
+            "  %s: %.2f%s (peak %.2f%s, %llu live, %llu/%llu allocs/frees "
+            "last frame)\n",
+            memory_tag_strings[i], amount, unit, tag_peak_amount,
+            tag_peak_unit, tag->live_allocations, tag->frame_allocations,
+            tag->frame_frees);
 
         offset += length;
     }
 
-    char *out_string = string_duplicate(buffer);
-    return out_string;
+    f32 last_amount, peak_amount, size_amount;
+    const char *last_unit =
+        get_unit_for_size(stats.frame_last_used, &last_amount);
+    const char *peak_unit =
+        get_unit_for_size(stats.frame_high_water_mark, &peak_amount);
+    const char *size_unit =
+        get_unit_for_size(frame_arena.total_size, &size_amount);
+    offset += snprintf(buffer + offset, capacity - offset,
+                       "Frame arena: %.2f%s last frame, %.2f%s peak, "
+                       "%.2f%s capacity\n",
+                       last_amount, last_unit, peak_amount, peak_unit,
+                       size_amount, size_unit);
+
+#if KMEMORY_USE_TLSF
+    platform_mutex_lock(&heap_mutex);
+    u64 heap_used = heap.total_size - heap.free_space;
+    u64 heap_largest = tlsf_allocator_largest_free_block(&heap);
+    platform_mutex_unlock(&heap_mutex);
+
+    f32 used_amount, largest_amount, heap_amount;
+    const char *used_unit = get_unit_for_size(heap_used, &used_amount);
+    const char *largest_unit =
+        get_unit_for_size(heap_largest, &largest_amount);
+    const char *heap_unit = get_unit_for_size(heap.total_size, &heap_amount);
+    offset += snprintf(buffer + offset, capacity - offset,
+                       "TLSF heap: %.2f%s used, %.2f%s largest free block, "
+                       "%.2f%s capacity\n",
+                       used_amount, used_unit, largest_amount, largest_unit,
+                       heap_amount, heap_unit);
+#endif
+
+    // Held while the lines are written, so no pool can unregister and be
+    // destroyed halfway through
+    platform_mutex_lock(&pool_mutex);
+    for (u32 i = 0; i < KMEMORY_MAX_POOLS; ++i) {
+        pool_allocator *pool = pools[i];
+        if (!pool || offset >= capacity) {
+            continue;
+        }
+
+        offset += snprintf(
+            buffer + offset, capacity - offset,
+            "Pool '%s' (%s): %llu/%llu blocks of %lluB in use, %llu peak, "
+            "%u chunks\n",
+            pool->name, memory_tag_strings[pool->tag], pool->blocks_in_use,
+            (u64)pool->chunk_count * pool->blocks_per_chunk, pool->block_size,
+            pool->peak_blocks_in_use, pool->chunk_count);
+    }
+    platform_mutex_unlock(&pool_mutex);
+
+    return buffer;
 }
@@ -22,21 +22,174 @@ typedef enum memory_tag {
     MEMORY_TAG_ENTITY,
     MEMORY_TAG_ENTITY_NODE,
     MEMORY_TAG_SCENE,
+    // Buffers holding the payloads of posted events
+    MEMORY_TAG_EVENT,
+
+    // Transient allocations that only live until the end of the current
+    // frame. These are served from the frame arena, or the heap once it is
+    // full, and must not be freed. Main thread only; other threads should use
+    // their scratch stack
+    MEMORY_TAG_FRAME,
+
+    // Pages committed for the per-thread scratch stacks
+    MEMORY_TAG_SCRATCH,
 
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
+// Size of the arena backing MEMORY_TAG_FRAME allocations. Use the frame
+// statistics in `get_memory_usage_str` to size it.
+#ifndef KMEMORY_FRAME_ARENA_SIZE
+#define KMEMORY_FRAME_ARENA_SIZE (4 * 1024 * 1024)
+#endif
+
+// When enabled, kallocate/kfree are served from a TLSF heap that reserves
+// KMEMORY_HEAP_SIZE bytes up front instead of calling into the platform for
+// every request. Requests the heap cannot satisfy fall back to the platform.
+#ifndef KMEMORY_USE_TLSF
+#define KMEMORY_USE_TLSF 1
+#endif
+
+#ifndef KMEMORY_HEAP_SIZE
+#define KMEMORY_HEAP_SIZE (64 * 1024 * 1024)
+#endif
+
+// Allocations of at least this many bytes bypass the heap and are mapped
+// directly from the OS, backed by huge pages where available. The mapping is
+// rounded up to whole huge pages, and the tag stats count the rounded size
+#ifndef KMEMORY_LARGE_ALLOCATION_SIZE
+#define KMEMORY_LARGE_ALLOCATION_SIZE (2 * 1024 * 1024)
+#endif
+
+// Allocation stats are kept in one shard per thread and merged on read.
+// Threads beyond this count share a single, contended shard.
+#ifndef KMEMORY_MAX_STAT_SHARDS
+#define KMEMORY_MAX_STAT_SHARDS 64
+#endif
+
+// The most pool allocators that can be listed in the memory report at once
+#define KMEMORY_MAX_POOLS 32
+
+struct pool_allocator;
+
+typedef struct memory_tag_stats {
+    // Bytes currently allocated under the tag
+    u64 current_bytes;
+    // Allocations and frees made under the tag since startup
+    u64 allocation_count;
+    u64 free_count;
+} memory_tag_stats;
+
+typedef struct memory_tag_snapshot {
+    // Bytes currently allocated under the tag
+    u64 current_bytes;
+    // The most bytes seen allocated under the tag. Sampled at the end of each
+    // frame and whenever a snapshot is taken, so short spikes within a frame
+    // can be missed
+    u64 peak_bytes;
+    // Allocations made under the tag that have not been freed yet
+    u64 live_allocations;
+    // Allocations and frees made under the tag during the last completed frame
+    u64 frame_allocations;
+    u64 frame_frees;
+    // The budget set with `memory_set_tag_budget`, or 0 if there is none
+    u64 budget_bytes;
+} memory_tag_snapshot;
+
+typedef struct memory_snapshot {
+    memory_tag_snapshot tags[MEMORY_TAG_MAX_TAGS];
+    // Bytes currently allocated under all tags together
+    u64 total_bytes;
+    // The number of frames completed since startup
+    u64 frame_number;
+} memory_snapshot;
+
 void initialize_memory();
 void shutdown_memory();
 
+/**
+ * Releases every MEMORY_TAG_FRAME allocation at once, records the frame's
+ * per-tag statistics and fires EVENT_CODE_MEMORY_BUDGET_EXCEEDED for tags
+ * over budget. Called by the application once per main loop iteration,
+ * including while it is suspended
+ */
+void memory_end_frame();
+
+// Accounts for memory that allocators obtain without going through kallocate,
+// such as pages committed in a virtual memory reservation. `count` is the
+// number of allocations or frees to record along with the bytes
+void memory_track_allocation(u64 size, u64 count, memory_tag tag);
+void memory_track_free(u64 size, u64 count, memory_tag tag);
+
+// Pool allocators register themselves, from any thread, so their stats show
+// up in `get_memory_usage_str`
+void memory_register_pool(struct pool_allocator *pool);
+void memory_unregister_pool(struct pool_allocator *pool);
+
 KAPI void *kallocate(u64 size, memory_tag tag);
 
+/**
+ * Allocates a block without zeroing it, for callers that overwrite the whole
+ * block before reading it. Free it with `kfree`
+ * @param size The number of bytes to allocate
+ * @param tag The memory tag to account the allocation under
+ * @returns A pointer to the block, or 0/NULL on failure
+ */
+KAPI void *kallocate_uninitialized(u64 size, memory_tag tag);
+
 KAPI void kfree(void *block, u64 size, memory_tag tag);
 
+/**
+ * Allocates a zeroed block whose address is a multiple of the given alignment
+ * @param size The number of bytes to allocate
+ * @param alignment The required alignment. Must be a power of two
+ * @param tag The memory tag to account the allocation under
+ * @returns A pointer to the block, or 0/NULL on failure
+ */
+KAPI void *kallocate_aligned(u64 size, u64 alignment, memory_tag tag);
+
+/**
+ * Frees a block from `kallocate_aligned`. Size and alignment must match the
+ * values it was allocated with
+ */
+KAPI void kfree_aligned(void *block, u64 size, u64 alignment, memory_tag tag);
+
 KAPI void *kzero_memory(void *block, u64 size);
 
 KAPI void *kcopy_memory(void *dest, const void *source, u64 size);
 
+// Like `kcopy_memory`, but the ranges may overlap
+KAPI void *kmove_memory(void *dest, const void *source, u64 size);
+
 KAPI void *kset_memory(void *dest, i32 value, u64 size);
 
+/**
+ * Merges the allocation stats of every thread. Safe to call from any thread
+ * @param out_stats An array with an entry for each memory tag to fill
+ */
+KAPI void
+memory_get_tag_stats(memory_tag_stats out_stats[MEMORY_TAG_MAX_TAGS]);
+
+/**
+ * Builds a human-readable report of memory use. The string is allocated from
+ * the calling thread's scratch stack, so open a scratch scope around the call
+ * @returns The report, valid until the enclosing `scratch_end`
+ */
 KAPI char *get_memory_usage_str();
+
+/**
+ * Fills a snapshot of per-tag memory statistics without formatting anything.
+ * Cheap enough to poll every frame; safe to call from any thread
+ * @param out_snapshot A pointer to hold the snapshot
+ */
+KAPI void memory_get_snapshot(memory_snapshot *out_snapshot);
+
+/**
+ * Sets a budget for a memory tag. At the end of a frame in which the tag's
+ * usage goes over budget, EVENT_CODE_MEMORY_BUDGET_EXCEEDED is fired once; it
+ * fires again only after usage has dropped back within budget
+ * @param tag The memory tag to budget
+ * @param budget_bytes The most bytes the tag should use, or 0 to remove the
+ * budget
+ */
+KAPI void memory_set_tag_budget(memory_tag tag, u64 budget_bytes);
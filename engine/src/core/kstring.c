@@ -1,11 +1,15 @@
 #include "kstring.h"
 #include "kmemory.h"
+#include "scratch_allocator.h"
 
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
 
 char *string_duplicate(const char *str) {
     u64 length = string_length(str);
-    char *copy = kallocate(length + 1, MEMORY_TAG_STRING);
+    char *copy = kallocate_uninitialized(length + 1, MEMORY_TAG_STRING);
     kcopy_memory(copy, str, length + 1);
 
     return copy;
@@ -16,3 +20,655 @@ u64 string_length(const char *str) { return strlen(str); }
 b8 strings_equal(const char *str0, const char *str1) {
     return strcmp(str0, str1) == 0;
 }
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+static u64 rotate_left(u64 value, u32 bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Unaligned little-endian reads; the compiler turns these into single loads
+static u64 read_u64(const u8 *bytes) {
+    u64 value;
+    memcpy(&value, bytes, sizeof(u64));
+    return value;
+}
+
+static u32 read_u32(const u8 *bytes) {
+    u32 value;
+    memcpy(&value, bytes, sizeof(u32));
+    return value;
+}
+
+static u64 xxh_round(u64 accumulator, u64 input) {
+    accumulator += input * XXH_PRIME64_2;
+    accumulator = rotate_left(accumulator, 31);
+    return accumulator * XXH_PRIME64_1;
+}
+
+static u64 xxh_merge_round(u64 hash, u64 accumulator) {
+    hash ^= xxh_round(0, accumulator);
+    return hash * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+u64 hash_bytes(const void *data, u64 size, u64 seed) {
+    const u8 *bytes = data;
+    const u8 *end = bytes + size;
+    u64 hash;
+
+    if (size >= 32) {
+        // Four independent lanes over 32-byte stripes
+        u64 v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        u64 v2 = seed + XXH_PRIME64_2;
+        u64 v3 = seed;
+        u64 v4 = seed - XXH_PRIME64_1;
+        const u8 *limit = end - 32;
+        do {
+            v1 = xxh_round(v1, read_u64(bytes));
+            v2 = xxh_round(v2, read_u64(bytes + 8));
+            v3 = xxh_round(v3, read_u64(bytes + 16));
+            v4 = xxh_round(v4, read_u64(bytes + 24));
+            bytes += 32;
+        } while (bytes <= limit);
+
+        hash = rotate_left(v1, 1) + rotate_left(v2, 7) +
+               rotate_left(v3, 12) + rotate_left(v4, 18);
+        hash = xxh_merge_round(hash, v1);
+        hash = xxh_merge_round(hash, v2);
+        hash = xxh_merge_round(hash, v3);
+        hash = xxh_merge_round(hash, v4);
+    } else {
+        hash = seed + XXH_PRIME64_5;
+    }
+
+    hash += size;
+
+    // Remaining bytes, 8, then 4, then 1 at a time
+    for (; bytes + 8 <= end; bytes += 8) {
+        hash ^= xxh_round(0, read_u64(bytes));
+        hash = rotate_left(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (bytes + 4 <= end) {
+        hash ^= (u64)read_u32(bytes) * XXH_PRIME64_1;
+        hash = rotate_left(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        bytes += 4;
+    }
+    for (; bytes < end; ++bytes) {
+        hash ^= *bytes * XXH_PRIME64_5;
+        hash = rotate_left(hash, 11) * XXH_PRIME64_1;
+    }
+
+    // Final avalanche
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+u64 string_hash(const char *str) {
+    return hash_bytes(str, string_length(str), 0);
+}
+
+void string_builder_init(string_builder *builder, char *buffer,
+                         u64 capacity) {
+    builder->data = buffer;
+    builder->length = 0;
+    builder->capacity = capacity;
+    builder->growable = FALSE;
+    builder->truncated = FALSE;
+    buffer[0] = 0;
+}
+
+void string_builder_init_scratch(string_builder *builder,
+                                 u64 initial_capacity) {
+    u64 capacity = KMAX(initial_capacity, 16);
+    builder->data = scratch_allocate(capacity);
+    builder->length = 0;
+    builder->capacity = builder->data ? capacity : 0;
+    builder->growable = TRUE;
+    builder->truncated = FALSE;
+}
+
+// Makes room for `size` more bytes, growing the buffer if it can
+// @returns How many of the bytes fit
+static u64 make_room(string_builder *builder, u64 size) {
+    // One byte is always kept back for the terminator
+    u64 available = builder->capacity ? builder->capacity - 1 - builder->length
+                                      : 0;
+    if (size <= available) {
+        return size;
+    }
+
+    if (builder->growable) {
+        u64 required = builder->length + size + 1;
+        u64 capacity = KMAX(builder->capacity * 2, required);
+        char *grown = builder->data ? scratch_resize(builder->data,
+                                                     builder->capacity,
+                                                     capacity)
+                                    : scratch_allocate(capacity);
+        if (grown) {
+            builder->data = grown;
+            builder->capacity = capacity;
+            return size;
+        }
+    }
+
+    builder->truncated = TRUE;
+    return available;
+}
+
+void string_builder_append_n(string_builder *builder, const char *str,
+                             u64 length) {
+    u64 count = make_room(builder, length);
+    if (count) {
+        kcopy_memory(builder->data + builder->length, str, count);
+        builder->length += count;
+    }
+}
+
+void string_builder_append(string_builder *builder, const char *str) {
+    string_builder_append_n(builder, str, string_length(str));
+}
+
+static void append_repeated(string_builder *builder, char c, u64 count) {
+    count = make_room(builder, count);
+    if (count) {
+        kset_memory(builder->data + builder->length, c, count);
+        builder->length += count;
+    }
+}
+
+void string_builder_append_char(string_builder *builder, char c) {
+    if (make_room(builder, 1)) {
+        builder->data[builder->length++] = c;
+    }
+}
+
+// Numbers are written backwards from the end of a small buffer. 64 bytes
+// holds any u64 in decimal or hex plus a fixed-point fraction
+#define NUMBER_BUFFER_SIZE 64
+
+static char *format_u64(char *end, u64 value) {
+    do {
+        *--end = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+static char *format_hex(char *end, u64 value, b8 uppercase) {
+    const char *digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+    do {
+        *--end = digits[value & 0xF];
+        value >>= 4;
+    } while (value);
+    return end;
+}
+
+void string_builder_append_u64(string_builder *builder, u64 value) {
+    char buffer[NUMBER_BUFFER_SIZE];
+    char *end = buffer + NUMBER_BUFFER_SIZE;
+    char *start = format_u64(end, value);
+    string_builder_append_n(builder, start, end - start);
+}
+
+void string_builder_append_i64(string_builder *builder, i64 value) {
+    if (value < 0) {
+        string_builder_append_char(builder, '-');
+        // Negate as unsigned so that the most negative value does not
+        // overflow
+        string_builder_append_u64(builder, 0 - (u64)value);
+    } else {
+        string_builder_append_u64(builder, value);
+    }
+}
+
+void string_builder_append_hex(string_builder *builder, u64 value,
+                               u32 min_digits) {
+    char buffer[NUMBER_BUFFER_SIZE];
+    char *end = buffer + NUMBER_BUFFER_SIZE;
+    char *start = format_hex(end, value, FALSE);
+    if ((u64)(end - start) < min_digits) {
+        append_repeated(builder, '0', min_digits - (end - start));
+    }
+    string_builder_append_n(builder, start, end - start);
+}
+
+// The largest precision formatted without libc. 10^9 times a fraction below
+// 1 stays well inside a double's exact integer range
+#define MAX_FIXED_PRECISION 9
+
+static const u64 powers_of_10[MAX_FIXED_PRECISION + 1] = {
+    1,      10,      100,      1000,      10000,
+    100000, 1000000, 10000000, 100000000, 1000000000};
+
+// Formats the magnitude of a finite value below 1e18
+// @returns The start of the digits, which end at `end`
+static char *format_fixed(char *end, f64 magnitude, u32 precision) {
+    u64 scale = powers_of_10[precision];
+    u64 integer = (u64)magnitude;
+    f64 scaled = (magnitude - (f64)integer) * (f64)scale;
+    u64 fraction = (u64)scaled;
+    f64 remainder = scaled - (f64)fraction;
+    if (remainder > 0.5) {
+        fraction++;
+    } else if (remainder == 0.5) {
+        // The multiplication may have rounded onto the tie. fma gives its
+        // exact error, which says which side the value really falls on.
+        // Exact ties round half to even, as in libc; the last digit printed
+        // is the integer's when there is no fraction
+        f64 error = fma(magnitude - (f64)integer, (f64)scale, -scaled);
+        u64 last_digit = precision ? fraction : integer;
+        if (error > 0 || (error == 0 && (last_digit & 1))) {
+            fraction++;
+        }
+    }
+    // Rounding the fraction up can carry into the integer part
+    if (fraction >= scale) {
+        fraction -= scale;
+        integer++;
+    }
+
+    char *start = end;
+    if (precision) {
+        for (u32 i = 0; i < precision; ++i) {
+            *--start = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        *--start = '.';
+    }
+    return format_u64(start, integer);
+}
+
+static b8 is_fixed_formattable(f64 value, u32 precision) {
+    // NaN fails both comparisons
+    return precision <= MAX_FIXED_PRECISION && value > -1e18 && value < 1e18;
+}
+
+void string_builder_append_f64(string_builder *builder, f64 value,
+                               u32 precision) {
+    if (!is_fixed_formattable(value, precision)) {
+        string_builder_appendf(builder, "%.*f", (i32)precision, value);
+        return;
+    }
+
+    char buffer[NUMBER_BUFFER_SIZE];
+    char *end = buffer + NUMBER_BUFFER_SIZE;
+    char *start = format_fixed(end, value < 0 ? -value : value, precision);
+    if (value < 0) {
+        *--start = '-';
+    }
+    string_builder_append_n(builder, start, end - start);
+}
+
+typedef struct format_spec {
+    b8 left_align;
+    b8 zero_pad;
+    // '+', ' ' or 0: what to print in front of non-negative numbers
+    char positive_sign;
+    // The '#' flag, which only libc implements
+    b8 alternate;
+    u32 width;
+    i32 precision; // -1 when not given
+} format_spec;
+
+// Appends one formatted field. `sign` is kept in front of any zero padding,
+// and `zeros` more leading zeros go between the two and `text`
+static void append_field(string_builder *builder, const format_spec *spec,
+                         const char *sign, u64 zeros, const char *text,
+                         u64 length) {
+    u64 sign_length = sign ? string_length(sign) : 0;
+    u64 field_length = sign_length + zeros + length;
+    u64 padding = spec->width > field_length ? spec->width - field_length : 0;
+
+    if (!spec->left_align && !spec->zero_pad) {
+        append_repeated(builder, ' ', padding);
+    }
+    if (sign_length) {
+        string_builder_append_n(builder, sign, sign_length);
+    }
+    if (!spec->left_align && spec->zero_pad) {
+        append_repeated(builder, '0', padding);
+    }
+    append_repeated(builder, '0', zeros);
+    string_builder_append_n(builder, text, length);
+    if (spec->left_align) {
+        append_repeated(builder, ' ', padding);
+    }
+}
+
+// Appends integer digits. A precision is the minimum number of digits, and
+// turns off zero padding; a zero printed with precision 0 has no digits
+static void append_integer(string_builder *builder, format_spec *spec,
+                           const char *sign, const char *digits, u64 length) {
+    u64 zeros = 0;
+    if (spec->precision >= 0) {
+        spec->zero_pad = FALSE;
+        if (spec->precision == 0 && length == 1 && digits[0] == '0') {
+            length = 0;
+        }
+        if ((u64)spec->precision > length) {
+            zeros = spec->precision - length;
+        }
+    }
+    append_field(builder, spec, sign, zeros, digits, length);
+}
+
+// Hands a conversion this formatter does not implement to libc, formatting
+// straight into the builder's buffer. The caller reads the argument with the
+// type that `length_modifier` and `conversion` call for and passes it on
+static void append_with_libc(string_builder *builder, const format_spec *spec,
+                             const char *length_modifier, char conversion,
+                             ...) {
+    // Rebuild the conversion with any '*' width and precision resolved
+    char libc_format[32];
+    char *out = libc_format;
+    *out++ = '%';
+    if (spec->left_align) {
+        *out++ = '-';
+    }
+    if (spec->zero_pad) {
+        *out++ = '0';
+    }
+    if (spec->positive_sign) {
+        *out++ = spec->positive_sign;
+    }
+    if (spec->alternate) {
+        *out++ = '#';
+    }
+    char digits[NUMBER_BUFFER_SIZE];
+    char *digits_end = digits + NUMBER_BUFFER_SIZE;
+    if (spec->width) {
+        char *start = format_u64(digits_end, spec->width);
+        kcopy_memory(out, start, digits_end - start);
+        out += digits_end - start;
+    }
+    if (spec->precision >= 0) {
+        *out++ = '.';
+        char *start = format_u64(digits_end, spec->precision);
+        kcopy_memory(out, start, digits_end - start);
+        out += digits_end - start;
+    }
+    while (*length_modifier) {
+        *out++ = *length_modifier++;
+    }
+    *out++ = conversion;
+    *out = 0;
+
+    __builtin_va_list args;
+    va_start(args, conversion);
+    __builtin_va_list measure_args;
+    va_copy(measure_args, args);
+    i32 length = vsnprintf(0, 0, libc_format, measure_args);
+    va_end(measure_args);
+    if (length > 0) {
+        // vsnprintf also writes a terminator, which make_room keeps a byte
+        // for
+        u64 count = make_room(builder, length);
+        if (count) {
+            vsnprintf(builder->data + builder->length, count + 1, libc_format,
+                      args);
+            builder->length += count;
+        }
+    }
+    va_end(args);
+}
+
+void string_builder_appendfv(string_builder *builder, const char *format,
+                             __builtin_va_list args) {
+    u64 start_length = builder->length;
+    const char *literal = format;
+    while (*format) {
+        if (*format != '%') {
+            format++;
+            continue;
+        }
+
+        // Copy the literal text before the conversion in one go
+        string_builder_append_n(builder, literal, format - literal);
+        const char *spec_start = format++;
+
+        format_spec spec = {0};
+        spec.precision = -1;
+        for (;; ++format) {
+            if (*format == '-') {
+                spec.left_align = TRUE;
+            } else if (*format == '0') {
+                spec.zero_pad = TRUE;
+            } else if (*format == '#') {
+                spec.alternate = TRUE;
+            } else if (*format == '+' || *format == ' ') {
+                // '+' wins over ' ' when both are given
+                if (spec.positive_sign != '+') {
+                    spec.positive_sign = *format;
+                }
+            } else {
+                break;
+            }
+        }
+
+        if (*format == '*') {
+            i32 width = va_arg(args, i32);
+            if (width < 0) {
+                spec.left_align = TRUE;
+                width = -width;
+            }
+            spec.width = width;
+            format++;
+        } else {
+            while (*format >= '0' && *format <= '9') {
+                spec.width = spec.width * 10 + (*format++ - '0');
+            }
+        }
+
+        if (*format == '.') {
+            format++;
+            spec.precision = 0;
+            if (*format == '*') {
+                spec.precision = va_arg(args, i32);
+                format++;
+            } else {
+                while (*format >= '0' && *format <= '9') {
+                    spec.precision = spec.precision * 10 + (*format++ - '0');
+                }
+            }
+        }
+
+        // 0 for int, 1 for long, 2 for long long and size_t, 3 for long
+        // double. Narrower types are promoted to int when passed through
+        // varargs
+        u32 size = 0;
+        b8 narrow_char = FALSE;
+        b8 narrow_short = FALSE;
+        if (*format == 'h') {
+            format++;
+            if (*format == 'h') {
+                narrow_char = TRUE;
+                format++;
+            } else {
+                narrow_short = TRUE;
+            }
+        } else if (*format == 'l') {
+            format++;
+            size = 1;
+            if (*format == 'l') {
+                size = 2;
+                format++;
+            }
+        } else if (*format == 'z' || *format == 'j' || *format == 't') {
+            size = 2;
+            format++;
+        } else if (*format == 'L') {
+            size = 3;
+            format++;
+        }
+
+        char buffer[NUMBER_BUFFER_SIZE];
+        char *end = buffer + NUMBER_BUFFER_SIZE;
+        char conversion = *format;
+        if (conversion) {
+            format++;
+        }
+
+        switch (conversion) {
+        case 'd':
+        case 'i': {
+            i64 value = size == 2   ? va_arg(args, long long)
+                        : size == 1 ? va_arg(args, long)
+                                    : va_arg(args, int);
+            if (narrow_char) {
+                value = (signed char)value;
+            } else if (narrow_short) {
+                value = (short)value;
+            }
+            u64 magnitude = value < 0 ? 0 - (u64)value : (u64)value;
+            char *start = format_u64(end, magnitude);
+            char sign[2] = {value < 0 ? '-' : spec.positive_sign, 0};
+            append_integer(builder, &spec, sign, start, end - start);
+        } break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            u64 value = size == 2   ? va_arg(args, unsigned long long)
+                        : size == 1 ? va_arg(args, unsigned long)
+                                    : va_arg(args, unsigned int);
+            if (narrow_char) {
+                value = (unsigned char)value;
+            } else if (narrow_short) {
+                value = (unsigned short)value;
+            }
+            if (conversion == 'o' || spec.alternate) {
+                append_with_libc(builder, &spec, "ll", conversion,
+                                 (unsigned long long)value);
+                break;
+            }
+            char *start = conversion == 'u'
+                              ? format_u64(end, value)
+                              : format_hex(end, value, conversion == 'X');
+            append_integer(builder, &spec, 0, start, end - start);
+        } break;
+        case 'p': {
+            u64 value = (u64)va_arg(args, void *);
+            if (!value) {
+                // As glibc prints it
+                spec.zero_pad = FALSE;
+                append_field(builder, &spec, 0, 0, "(nil)", 5);
+                break;
+            }
+            char *start = format_hex(end, value, FALSE);
+            append_field(builder, &spec, "0x", 0, start, end - start);
+        } break;
+        case 'f':
+        case 'F': {
+            if (size == 3) {
+                append_with_libc(builder, &spec, "L", conversion,
+                                 va_arg(args, long double));
+                break;
+            }
+            f64 value = va_arg(args, f64);
+            u32 precision = spec.precision < 0 ? 6 : spec.precision;
+            if (spec.alternate || !is_fixed_formattable(value, precision)) {
+                append_with_libc(builder, &spec, "", conversion, value);
+                break;
+            }
+            char *start =
+                format_fixed(end, value < 0 ? -value : value, precision);
+            char sign[2] = {value < 0 ? '-' : spec.positive_sign, 0};
+            append_field(builder, &spec, sign, 0, start, end - start);
+        } break;
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (size == 3) {
+                append_with_libc(builder, &spec, "L", conversion,
+                                 va_arg(args, long double));
+            } else {
+                append_with_libc(builder, &spec, "", conversion,
+                                 va_arg(args, f64));
+            }
+            break;
+        case 's': {
+            if (size == 1) {
+                // Wide strings
+                append_with_libc(builder, &spec, "l", conversion,
+                                 va_arg(args, const void *));
+                break;
+            }
+            const char *str = va_arg(args, const char *);
+            if (!str) {
+                str = "(null)";
+            }
+            // A precision limits how much of the string is read
+            u64 length = spec.precision < 0
+                             ? string_length(str)
+                             : strnlen(str, spec.precision);
+            spec.zero_pad = FALSE;
+            append_field(builder, &spec, 0, 0, str, length);
+        } break;
+        case 'c': {
+            if (size == 1) {
+                // A wide character, which is promoted like an int
+                append_with_libc(builder, &spec, "l", conversion,
+                                 va_arg(args, unsigned int));
+                break;
+            }
+            char c = (char)va_arg(args, int);
+            spec.zero_pad = FALSE;
+            append_field(builder, &spec, 0, 0, &c, 1);
+        } break;
+        case 'n': {
+            // Stores how much this call has appended so far
+            u64 count = builder->length - start_length;
+            if (narrow_char) {
+                *va_arg(args, signed char *) = (signed char)count;
+            } else if (narrow_short) {
+                *va_arg(args, short *) = (short)count;
+            } else if (size == 2) {
+                *va_arg(args, long long *) = (long long)count;
+            } else if (size == 1) {
+                *va_arg(args, long *) = (long)count;
+            } else {
+                *va_arg(args, int *) = (int)count;
+            }
+        } break;
+        case '%':
+            string_builder_append_char(builder, '%');
+            break;
+        default:
+            // Not a conversion at all, so there is no argument to read:
+            // print it as written
+            string_builder_append_n(builder, spec_start, format - spec_start);
+            break;
+        }
+
+        literal = format;
+    }
+
+    string_builder_append_n(builder, literal, format - literal);
+}
+
+void string_builder_appendf(string_builder *builder, const char *format,
+                            ...) {
+    __builtin_va_list args;
+    va_start(args, format);
+    string_builder_appendfv(builder, format, args);
+    va_end(args);
+}
+
+const char *string_builder_cstr(string_builder *builder) {
+    if (!builder->capacity) {
+        return "";
+    }
+    builder->data[builder->length] = 0;
+    return builder->data;
+}
@@ -7,3 +7,92 @@ u64 string_length(const char *str);
 KAPI char *string_duplicate(const char *str);
 
 KAPI b8 strings_equal(const char *str0, const char *str1);
+
+/**
+ * Hashes a block of memory with xxHash64. Fast and well distributed, but not
+ * cryptographic. Suitable for hash table, pipeline and asset keys
+ * @param data The bytes to hash. Can be 0/NULL if size is 0
+ * @param size The number of bytes
+ * @param seed Changes the hash, e.g. to get independent hashes of one key
+ * @returns The 64-bit hash
+ */
+KAPI u64 hash_bytes(const void *data, u64 size, u64 seed);
+
+/**
+ * Hashes a null-terminated string with `hash_bytes`, using a seed of 0
+ */
+KAPI u64 string_hash(const char *str);
+
+/**
+ * Appends text and numbers into one buffer without going through the heap
+ * or libc's formatting. The buffer is either supplied by the caller, in which
+ * case output that does not fit is cut off and `truncated` is set, or lives
+ * on the calling thread's scratch stack, where it grows in place as long as
+ * nothing else is allocated from the stack in the meantime.
+ */
+typedef struct string_builder {
+    char *data;
+    u64 length;
+    // Bytes available in `data`, including room for the terminator
+    u64 capacity;
+    // Whether `data` is on the scratch stack and may grow
+    b8 growable;
+    b8 truncated;
+} string_builder;
+
+/**
+ * Starts a builder over a caller-provided buffer
+ * @param builder The builder to initialize
+ * @param buffer The buffer to write into
+ * @param capacity The size of the buffer in bytes. Must be at least 1
+ */
+KAPI void string_builder_init(string_builder *builder, char *buffer,
+                              u64 capacity);
+
+/**
+ * Starts a builder on the calling thread's scratch stack. Its contents are
+ * released by the `scratch_end` of the enclosing scratch scope
+ * @param builder The builder to initialize
+ * @param initial_capacity The number of bytes to start with
+ */
+KAPI void string_builder_init_scratch(string_builder *builder,
+                                      u64 initial_capacity);
+
+KAPI void string_builder_append(string_builder *builder, const char *str);
+KAPI void string_builder_append_n(string_builder *builder, const char *str,
+                                  u64 length);
+KAPI void string_builder_append_char(string_builder *builder, char c);
+KAPI void string_builder_append_i64(string_builder *builder, i64 value);
+KAPI void string_builder_append_u64(string_builder *builder, u64 value);
+
+/**
+ * Appends a value as lowercase hexadecimal, without a prefix
+ * @param min_digits Pads with leading zeros up to this many digits
+ */
+KAPI void string_builder_append_hex(string_builder *builder, u64 value,
+                                    u32 min_digits);
+
+/**
+ * Appends a value in fixed-point notation, e.g. 3.14 for a precision of 2.
+ * Values of 1e18 and above, and precisions above 9, are handed to libc
+ */
+KAPI void string_builder_append_f64(string_builder *builder, f64 value,
+                                    u32 precision);
+
+/**
+ * Appends printf-style formatted text in one pass. Supports the flags
+ * `-0+ `, width and precision (including `*`), the length modifiers
+ * `hh h l ll z j t`, and the conversions `d i u x X p s c f F n %`. The rest
+ * of printf (`o e g a`, the `#` flag, `L` and wide characters) is handed to
+ * libc. A null `%p` prints `(nil)`, as in glibc
+ */
+KAPI void string_builder_appendf(string_builder *builder, const char *format,
+                                 ...);
+KAPI void string_builder_appendfv(string_builder *builder, const char *format,
+                                  __builtin_va_list args);
+
+/**
+ * @returns The built string, null-terminated. Stays valid until the builder
+ * is next appended to
+ */
+KAPI const char *string_builder_cstr(string_builder *builder);
@@ -0,0 +1,85 @@
+#include "linear_allocator.h"
+
+#include "core/logger.h"
+#include "platform/platform.h"
+
+void linear_allocator_create(u64 total_size, void *memory,
+                             linear_allocator *out_allocator) {
+    if (!out_allocator) {
+        return;
+    }
+
+    out_allocator->total_size = total_size;
+    out_allocator->allocated = 0;
+    out_allocator->high_water_mark = 0;
+    out_allocator->owns_memory = memory == 0;
+
+    // The allocator's own block sits below kallocate, so it is taken straight
+    // from the platform
+    if (memory) {
+        out_allocator->memory = memory;
+    } else {
+        out_allocator->memory = platform_allocate(total_size, TRUE);
+    }
+}
+
+void linear_allocator_destroy(linear_allocator *allocator) {
+    if (!allocator) {
+        return;
+    }
+
+    if (allocator->owns_memory && allocator->memory) {
+        platform_free(allocator->memory, TRUE);
+    }
+
+    allocator->memory = 0;
+    allocator->total_size = 0;
+    allocator->allocated = 0;
+    allocator->high_water_mark = 0;
+    allocator->owns_memory = FALSE;
+}
+
+void *linear_allocator_allocate(linear_allocator *allocator, u64 size) {
+    return linear_allocator_allocate_aligned(allocator, size,
+                                             LINEAR_ALLOCATOR_ALIGNMENT);
+}
+
+void *linear_allocator_allocate_aligned(linear_allocator *allocator,
+                                        u64 size, u64 alignment) {
+    if (!allocator || !allocator->memory) {
+        KERROR("linear_allocator_allocate - allocator not initialized.");
+        return 0;
+    }
+
+    if (alignment < LINEAR_ALLOCATOR_ALIGNMENT) {
+        alignment = LINEAR_ALLOCATOR_ALIGNMENT;
+    }
+
+    // Align the address rather than the offset, in case the block itself is
+    // less aligned than requested
+    u64 base = (u64)allocator->memory;
+    u64 address = (base + allocator->allocated + (alignment - 1)) &
+                  ~(alignment - 1);
+    u64 offset = address - base;
+
+    if (offset + size > allocator->total_size) {
+        u64 remaining = allocator->total_size - allocator->allocated;
+        KERROR("linear_allocator_allocate - Tried to allocate %lluB, only "
+               "%lluB remaining.",
+               size, remaining);
+        return 0;
+    }
+
+    allocator->allocated = offset + size;
+    if (allocator->allocated > allocator->high_water_mark) {
+        allocator->high_water_mark = allocator->allocated;
+    }
+
+    return (u8 *)allocator->memory + offset;
+}
+
+void linear_allocator_free_all(linear_allocator *allocator) {
+    if (allocator && allocator->memory) {
+        allocator->allocated = 0;
+    }
+}
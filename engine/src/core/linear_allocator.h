@@ -0,0 +1,58 @@
+#pragma once
+
+#include "defines.h"
+
+// Every allocation handed out by a linear allocator is aligned to this
+// boundary, which is enough for SIMD types such as vec4
+#define LINEAR_ALLOCATOR_ALIGNMENT 16
+
+typedef struct linear_allocator {
+    u64 total_size;
+    u64 allocated;
+
+    // The most bytes that were ever in use between two calls to
+    // `linear_allocator_free_all`
+    u64 high_water_mark;
+
+    void *memory;
+    b8 owns_memory;
+} linear_allocator;
+
+/**
+ * Creates a linear (bump) allocator over a block of memory. Allocations only
+ * move a pointer forward and cannot be freed individually; the whole block is
+ * released at once with `linear_allocator_free_all`
+ * @param total_size The size of the block in bytes
+ * @param memory The block to allocate from. If 0/NULL, the allocator reserves
+ * and owns its own block
+ * @param out_allocator A pointer to hold the created allocator
+ */
+KAPI void linear_allocator_create(u64 total_size, void *memory,
+                                  linear_allocator *out_allocator);
+
+KAPI void linear_allocator_destroy(linear_allocator *allocator);
+
+/**
+ * Allocates a block from the allocator. The memory is NOT zeroed
+ * @param allocator The allocator to allocate from
+ * @param size The number of bytes to allocate
+ * @returns A pointer to the block, or 0/NULL if the allocator is exhausted
+ */
+KAPI void *linear_allocator_allocate(linear_allocator *allocator, u64 size);
+
+/**
+ * Allocates a block whose address is a multiple of the given alignment. The
+ * memory is NOT zeroed
+ * @param allocator The allocator to allocate from
+ * @param size The number of bytes to allocate
+ * @param alignment The required alignment. Must be a power of two
+ * @returns A pointer to the block, or 0/NULL if the allocator is exhausted
+ */
+KAPI void *linear_allocator_allocate_aligned(linear_allocator *allocator,
+                                             u64 size, u64 alignment);
+
+/**
+ * Releases every allocation made from the allocator at once
+ * @param allocator The allocator to reset
+ */
+KAPI void linear_allocator_free_all(linear_allocator *allocator);
@@ -1,11 +1,10 @@
 #include "logger.h"
 #include "assert.h"
+#include "core/kstring.h"
+#include "core/scratch_allocator.h"
 #include "platform/platform.h"
 
-// TODO: temporary
 #include <stdarg.h>
-#include <stdio.h>
-#include <string.h>
 
 b8 initialize_logging() {
     // TODO: create a log file
@@ -16,35 +15,65 @@ void shutdown_logging() {
     // TODO: cleanup logging
 };
 
-// Each call to `log_output` uses 64kb per call
+// Set while a thread is inside `log_output`. A message logged while building
+// another one (e.g. the scratch stack failing to grow) is written unformatted
+// instead of recursing.
+static _Thread_local b8 logging = FALSE;
+
+// Formats into the calling thread's scratch stack in a single pass, so a
+// call only takes as much memory as the message needs
 void log_output(log_level level, const char *message, ...) {
     const char *level_strings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]: ",
                                     "[INFO]: ",  "[DEBUG]: ", "[TRACE]: "};
 
     b8 is_error = level < 2;
 
-    // Avoids dynamic allocation because it's slow
-    char out_message[32000];
-    memset(out_message, 0, sizeof(out_message));
-
-    // Format original message.Add commentMore actions
-    // NOTE: Oddly enough, MS's headers override the GCC/Clang va_list type with
-    // a "typedef char* va_list" in some cases, and as a result throws a strange
-    // error here. The workaround for now is to just use __builtin_va_list,
-    // which is the type GCC/Clang's va_start expects.
-    __builtin_va_list arg_ptr;
-    va_start(arg_ptr, message);
-    vsnprintf(out_message, 32000, message, arg_ptr);
-    va_end(arg_ptr);
-
-    char out_message2[32000];
-    sprintf(out_message2, "%s%s\n", level_strings[level], out_message);
-
-    if (is_error) {
-        platform_console_write_error(out_message2, level);
+    scratch_marker marker = scratch_begin();
+    const char *out_message = 0;
+
+    if (!logging) {
+        logging = TRUE;
+
+        string_builder builder;
+        string_builder_init_scratch(&builder, 256);
+        string_builder_append(&builder, level_strings[level]);
+
+        // NOTE: Oddly enough, MS's headers override the GCC/Clang va_list
+        // type with a "typedef char* va_list" in some cases, and as a result
+        // throws a strange error here. The workaround for now is to just use
+        // __builtin_va_list, which is the type GCC/Clang's va_start expects.
+        __builtin_va_list arg_ptr;
+        va_start(arg_ptr, message);
+        string_builder_appendfv(&builder, message, arg_ptr);
+        va_end(arg_ptr);
+        string_builder_append_char(&builder, '\n');
+
+        if (!builder.truncated) {
+            out_message = string_builder_cstr(&builder);
+        }
+
+        logging = FALSE;
+    }
+
+    if (out_message) {
+        if (is_error) {
+            platform_console_write_error(out_message, level);
+        } else {
+            platform_console_write(out_message, level);
+        }
     } else {
-        platform_console_write(out_message2, level);
+        if (is_error) {
+            platform_console_write_error(level_strings[level], level);
+            platform_console_write_error(message, level);
+            platform_console_write_error("\n", level);
+        } else {
+            platform_console_write(level_strings[level], level);
+            platform_console_write(message, level);
+            platform_console_write("\n", level);
+        }
     }
+
+    scratch_end(marker);
 };
 
 KAPI void report_assertion_failure(const char *expr, const char *msg,
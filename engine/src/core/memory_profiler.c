@@ -0,0 +1,405 @@
+#include "memory_profiler.h"
+
+#include "core/logger.h"
+#include "core/scratch_allocator.h"
+#include "platform/platform.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+STATIC_ASSERT((KMEMORY_PROFILER_MAX_SITES & (KMEMORY_PROFILER_MAX_SITES - 1)) ==
+                  0,
+              "KMEMORY_PROFILER_MAX_SITES must be a power of two.");
+STATIC_ASSERT((KMEMORY_PROFILER_MAX_LIVE_SAMPLES &
+               (KMEMORY_PROFILER_MAX_LIVE_SAMPLES - 1)) == 0,
+              "KMEMORY_PROFILER_MAX_LIVE_SAMPLES must be a power of two.");
+
+// Both tables are kept at most half full so probe sequences stay short
+#define SITE_SLOTS (KMEMORY_PROFILER_MAX_SITES * 2)
+#define LIVE_SLOTS (KMEMORY_PROFILER_MAX_LIVE_SAMPLES * 2)
+
+// Counts of live samples per address bucket, so kfree can rule out almost
+// every block without taking the lock
+#define LIVE_FILTER_SIZE 65536
+
+// Space reserved in the report for the module map
+#define MODULE_MAP_CAPACITY (1024 * 1024)
+
+typedef struct profiler_site {
+    // 0 marks an empty slot
+    u64 hash;
+    u32 frame_count;
+    void *frames[KMEMORY_PROFILER_MAX_FRAMES];
+
+    // Sampled allocations made from the site, and those not yet freed
+    u64 allocation_count;
+    u64 allocation_bytes;
+    u64 live_count;
+    u64 live_bytes;
+} profiler_site;
+
+typedef struct live_sample {
+    // 0/NULL marks an empty slot
+    void *block;
+    u64 size;
+    u32 site;
+} live_sample;
+
+typedef struct memory_profiler_state {
+    atomic_bool active;
+    u64 sample_interval;
+    char output_path[256];
+
+    // Guards both tables
+    platform_mutex mutex;
+    profiler_site *sites;
+    u32 site_count;
+    live_sample *live;
+    u64 dropped_samples;
+
+    _Atomic u64 live_sample_count;
+    _Atomic u16 live_filter[LIVE_FILTER_SIZE];
+} memory_profiler_state;
+
+static memory_profiler_state state;
+
+// Bytes this thread may still allocate before taking its next sample
+static _Thread_local i64 bytes_until_sample;
+static _Thread_local u64 rng_state;
+
+static u64 next_random() {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1Dull;
+}
+
+// Distances between samples are exponentially distributed, which makes
+// sampling a Poisson process over allocated bytes: an allocation of `size`
+// bytes is sampled with probability 1 - e^(-size / interval), the model
+// pprof's heap_v2 format assumes when it scales the samples back up
+static i64 next_sample_distance() {
+    // Uniform in (0, 1]
+    f64 uniform = ((next_random() >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return (i64)(-log(uniform) * (f64)state.sample_interval) + 1;
+}
+
+static u64 hash_pointer(const void *pointer) {
+    u64 x = (u64)pointer;
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    return x;
+}
+
+static u64 hash_frames(void **frames, u32 frame_count) {
+    // FNV-1a over the return addresses
+    u64 hash = 0xCBF29CE484222325ull;
+    for (u32 i = 0; i < frame_count; ++i) {
+        hash ^= (u64)frames[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash ? hash : 1;
+}
+
+static u32 filter_index(const void *block) {
+    return hash_pointer(block) & (LIVE_FILTER_SIZE - 1);
+}
+
+// Returns the site's index, adding it if needed, or -1 if the table is full
+static i32 find_site(void **frames, u32 frame_count) {
+    u64 hash = hash_frames(frames, frame_count);
+    u32 slot = hash & (SITE_SLOTS - 1);
+
+    while (state.sites[slot].hash) {
+        profiler_site *site = &state.sites[slot];
+        if (site->hash == hash && site->frame_count == frame_count &&
+            memcmp(site->frames, frames, frame_count * sizeof(void *)) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & (SITE_SLOTS - 1);
+    }
+
+    if (state.site_count >= KMEMORY_PROFILER_MAX_SITES) {
+        return -1;
+    }
+
+    profiler_site *site = &state.sites[slot];
+    site->hash = hash;
+    site->frame_count = frame_count;
+    memcpy(site->frames, frames, frame_count * sizeof(void *));
+    state.site_count++;
+
+    return slot;
+}
+
+static b8 insert_live_sample(void *block, u64 size, u32 site) {
+    if (atomic_load_explicit(&state.live_sample_count, memory_order_relaxed) >=
+        KMEMORY_PROFILER_MAX_LIVE_SAMPLES) {
+        return FALSE;
+    }
+
+    u32 slot = hash_pointer(block) & (LIVE_SLOTS - 1);
+    while (state.live[slot].block) {
+        slot = (slot + 1) & (LIVE_SLOTS - 1);
+    }
+
+    state.live[slot].block = block;
+    state.live[slot].size = size;
+    state.live[slot].site = site;
+    return TRUE;
+}
+
+static live_sample *find_live_sample(void *block) {
+    u32 slot = hash_pointer(block) & (LIVE_SLOTS - 1);
+    while (state.live[slot].block) {
+        if (state.live[slot].block == block) {
+            return &state.live[slot];
+        }
+        slot = (slot + 1) & (LIVE_SLOTS - 1);
+    }
+    return 0;
+}
+
+static void remove_live_sample(live_sample *sample) {
+    // Backward-shift deletion: pull later entries of the probe sequence into
+    // the hole so lookups never need tombstones
+    u32 hole = sample - state.live;
+    u32 slot = hole;
+    for (;;) {
+        slot = (slot + 1) & (LIVE_SLOTS - 1);
+        if (!state.live[slot].block) {
+            break;
+        }
+
+        u32 home = hash_pointer(state.live[slot].block) & (LIVE_SLOTS - 1);
+        // Only move the entry if its home is not between the hole and it
+        if (((slot - home) & (LIVE_SLOTS - 1)) >=
+            ((slot - hole) & (LIVE_SLOTS - 1))) {
+            state.live[hole] = state.live[slot];
+            hole = slot;
+        }
+    }
+    state.live[hole].block = 0;
+}
+
+void memory_profiler_initialize() {
+    platform_zero_memory(&state, sizeof(state));
+    platform_mutex_create(&state.mutex);
+}
+
+void memory_profiler_shutdown() {
+    memory_profiler_stop();
+
+    if (state.sites && state.output_path[0]) {
+        if (memory_profiler_write_report(state.output_path)) {
+            KINFO("Heap profile with %u call sites written to '%s'.",
+                  state.site_count, state.output_path);
+        }
+    }
+
+    platform_mutex_lock(&state.mutex);
+    if (state.sites) {
+        platform_free(state.sites, FALSE);
+        platform_free(state.live, FALSE);
+        state.sites = 0;
+        state.live = 0;
+    }
+    atomic_store_explicit(&state.live_sample_count, 0, memory_order_relaxed);
+    platform_mutex_unlock(&state.mutex);
+
+    platform_mutex_destroy(&state.mutex);
+}
+
+b8 memory_profiler_start(u64 sample_interval, const char *output_path) {
+#if KMEMORY_PROFILER
+    platform_mutex_lock(&state.mutex);
+    if (!state.sites) {
+        // The tables sit below kallocate, so they come from the platform
+        state.sites = platform_allocate(sizeof(profiler_site) * SITE_SLOTS,
+                                        FALSE);
+        state.live = platform_allocate(sizeof(live_sample) * LIVE_SLOTS,
+                                       FALSE);
+        if (!state.sites || !state.live) {
+            platform_mutex_unlock(&state.mutex);
+            KERROR("memory_profiler_start - could not allocate its tables.");
+            return FALSE;
+        }
+        platform_zero_memory(state.sites, sizeof(profiler_site) * SITE_SLOTS);
+        platform_zero_memory(state.live, sizeof(live_sample) * LIVE_SLOTS);
+    }
+
+    state.sample_interval =
+        sample_interval ? sample_interval : KMEMORY_PROFILER_DEFAULT_INTERVAL;
+    state.output_path[0] = 0;
+    if (output_path) {
+        strncpy(state.output_path, output_path, sizeof(state.output_path) - 1);
+    }
+    platform_mutex_unlock(&state.mutex);
+
+    atomic_store_explicit(&state.active, TRUE, memory_order_release);
+    return TRUE;
+#else
+    KWARN("memory_profiler_start - built without KMEMORY_PROFILER.");
+    return FALSE;
+#endif
+}
+
+void memory_profiler_stop() {
+    atomic_store_explicit(&state.active, FALSE, memory_order_relaxed);
+}
+
+void memory_profiler_on_allocate(void *block, u64 size) {
+    if (!atomic_load_explicit(&state.active, memory_order_acquire)) {
+        return;
+    }
+
+    if (!rng_state) {
+        rng_state = hash_pointer(&rng_state) ^
+                    (u64)(platform_get_absolute_time() * 1000000000.0);
+        rng_state = rng_state ? rng_state : 1;
+        bytes_until_sample = next_sample_distance();
+    }
+
+    bytes_until_sample -= (i64)size;
+    if (bytes_until_sample > 0) {
+        return;
+    }
+    bytes_until_sample = next_sample_distance();
+
+    // Capture outside the lock; it is the expensive part of a sample
+    void *frames[KMEMORY_PROFILER_MAX_FRAMES];
+    u32 frame_count =
+        platform_capture_backtrace(1, frames, KMEMORY_PROFILER_MAX_FRAMES);
+
+    platform_mutex_lock(&state.mutex);
+    if (!state.sites) {
+        platform_mutex_unlock(&state.mutex);
+        return;
+    }
+
+    i32 site_index = find_site(frames, frame_count);
+    if (site_index < 0 || !insert_live_sample(block, size, site_index)) {
+        state.dropped_samples++;
+        platform_mutex_unlock(&state.mutex);
+        return;
+    }
+
+    profiler_site *site = &state.sites[site_index];
+    site->allocation_count++;
+    site->allocation_bytes += size;
+    site->live_count++;
+    site->live_bytes += size;
+
+    atomic_fetch_add_explicit(&state.live_sample_count, 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&state.live_filter[filter_index(block)], 1,
+                              memory_order_relaxed);
+    platform_mutex_unlock(&state.mutex);
+}
+
+void memory_profiler_on_free(void *block) {
+    // Nearly every free leaves here, before touching the lock
+    if (!atomic_load_explicit(&state.live_sample_count,
+                              memory_order_relaxed) ||
+        !atomic_load_explicit(&state.live_filter[filter_index(block)],
+                              memory_order_relaxed)) {
+        return;
+    }
+
+    platform_mutex_lock(&state.mutex);
+    live_sample *sample = state.live ? find_live_sample(block) : 0;
+    if (sample) {
+        profiler_site *site = &state.sites[sample->site];
+        site->live_count--;
+        site->live_bytes -= sample->size;
+        remove_live_sample(sample);
+
+        atomic_fetch_sub_explicit(&state.live_sample_count, 1,
+                                  memory_order_relaxed);
+        atomic_fetch_sub_explicit(&state.live_filter[filter_index(block)], 1,
+                                  memory_order_relaxed);
+    }
+    platform_mutex_unlock(&state.mutex);
+}
+
+b8 memory_profiler_write_report(const char *path) {
+    scratch_marker marker = scratch_begin();
+
+    platform_mutex_lock(&state.mutex);
+    if (!state.sites) {
+        platform_mutex_unlock(&state.mutex);
+        scratch_end(marker);
+        return FALSE;
+    }
+
+    // A line per site with up to KMEMORY_PROFILER_MAX_FRAMES addresses
+    u64 site_line_size = 96 + KMEMORY_PROFILER_MAX_FRAMES * 20;
+    u64 capacity =
+        256 + state.site_count * site_line_size + MODULE_MAP_CAPACITY;
+    char *buffer = scratch_allocate(capacity);
+    if (!buffer) {
+        platform_mutex_unlock(&state.mutex);
+        scratch_end(marker);
+        KERROR("memory_profiler_write_report - report does not fit in "
+               "scratch memory.");
+        return FALSE;
+    }
+
+    u64 live_count = 0, live_bytes = 0;
+    u64 allocation_count = 0, allocation_bytes = 0;
+    for (u32 i = 0; i < SITE_SLOTS; ++i) {
+        profiler_site *site = &state.sites[i];
+        live_count += site->live_count;
+        live_bytes += site->live_bytes;
+        allocation_count += site->allocation_count;
+        allocation_bytes += site->allocation_bytes;
+    }
+
+    u64 offset = snprintf(buffer, capacity,
+                          "heap profile: %llu: %llu [%llu: %llu] @ "
+                          "heap_v2/%llu\n",
+                          live_count, live_bytes, allocation_count,
+                          allocation_bytes, state.sample_interval);
+
+    for (u32 i = 0; i < SITE_SLOTS; ++i) {
+        profiler_site *site = &state.sites[i];
+        if (!site->hash) {
+            continue;
+        }
+
+        offset += snprintf(buffer + offset, capacity - offset,
+                           "%llu: %llu [%llu: %llu] @", site->live_count,
+                           site->live_bytes, site->allocation_count,
+                           site->allocation_bytes);
+        for (u32 f = 0; f < site->frame_count; ++f) {
+            offset += snprintf(buffer + offset, capacity - offset, " %p",
+                               site->frames[f]);
+        }
+        buffer[offset++] = '\n';
+    }
+
+    u64 dropped_samples = state.dropped_samples;
+    platform_mutex_unlock(&state.mutex);
+
+    // Log once the lock is released, so a slow console write never stalls
+    // threads that are sampling allocations
+    if (dropped_samples) {
+        KWARN("memory_profiler_write_report - %llu samples were dropped; "
+              "raise KMEMORY_PROFILER_MAX_SITES or "
+              "KMEMORY_PROFILER_MAX_LIVE_SAMPLES.",
+              dropped_samples);
+    }
+
+    // pprof needs the module map to symbolize addresses in relocated code
+    offset += snprintf(buffer + offset, capacity - offset,
+                       "\nMAPPED_LIBRARIES:\n");
+    offset += platform_get_module_map(buffer + offset, capacity - offset);
+
+    b8 result = platform_write_file(path, buffer, offset);
+    scratch_end(marker);
+
+    return result;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "defines.h"
+
+// Compiles the sampling heap profiler into kallocate/kfree. While it is not
+// started, the only cost is one atomic load per call.
+#ifndef KMEMORY_PROFILER
+#define KMEMORY_PROFILER 1
+#endif
+
+// The most stack frames recorded per sampled allocation
+#define KMEMORY_PROFILER_MAX_FRAMES 16
+
+// The most distinct call sites the profiler tracks. Samples from further call
+// sites are dropped and counted in the report
+#ifndef KMEMORY_PROFILER_MAX_SITES
+#define KMEMORY_PROFILER_MAX_SITES 4096
+#endif
+
+// The most sampled allocations that can be live at once
+#ifndef KMEMORY_PROFILER_MAX_LIVE_SAMPLES
+#define KMEMORY_PROFILER_MAX_LIVE_SAMPLES 16384
+#endif
+
+// Mean number of bytes allocated between two samples when none is given
+#define KMEMORY_PROFILER_DEFAULT_INTERVAL (512 * 1024)
+
+void memory_profiler_initialize();
+
+/**
+ * Writes the report if the profiler was started with an output path, then
+ * releases the profiler's tables. Called by `shutdown_memory`
+ */
+void memory_profiler_shutdown();
+
+/**
+ * Starts sampling allocations. On average one allocation is recorded, with
+ * its backtrace, every `sample_interval` bytes; larger allocations are more
+ * likely to be picked. Samples are aggregated per call site
+ * @param sample_interval Mean bytes between samples, or 0 for
+ * KMEMORY_PROFILER_DEFAULT_INTERVAL
+ * @param output_path Where to write the profile at shutdown. Can be 0/NULL
+ * @returns TRUE if the profiler was started; otherwise FALSE
+ */
+KAPI b8 memory_profiler_start(u64 sample_interval, const char *output_path);
+
+/**
+ * Stops taking new samples. Frees of allocations that were already sampled
+ * are still tracked
+ */
+KAPI void memory_profiler_stop();
+
+/**
+ * Writes the samples gathered so far as a heap profile in the legacy
+ * "heap_v2" text format read by pprof
+ * @param path The file to write
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 memory_profiler_write_report(const char *path);
+
+// Hooks called by kallocate/kfree
+void memory_profiler_on_allocate(void *block, u64 size);
+void memory_profiler_on_free(void *block);
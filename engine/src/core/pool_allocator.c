@@ -0,0 +1,110 @@
+#include "pool_allocator.h"
+
+#include "core/logger.h"
+
+// Every chunk starts with a link to the next one, padded so the first block
+// keeps the alignment kallocate gives the chunk
+#define POOL_CHUNK_HEADER_SIZE 16
+
+static u64 chunk_size(pool_allocator *allocator) {
+    return POOL_CHUNK_HEADER_SIZE +
+           allocator->block_size * allocator->blocks_per_chunk;
+}
+
+static b8 add_chunk(pool_allocator *allocator) {
+    void **chunk = kallocate(chunk_size(allocator), allocator->tag);
+    if (!chunk) {
+        return FALSE;
+    }
+
+    *chunk = allocator->chunks;
+    allocator->chunks = chunk;
+    allocator->chunk_count++;
+
+    // Thread the new blocks onto the free list in address order, so the
+    // first allocations from a chunk are adjacent in memory
+    u8 *blocks = (u8 *)chunk + POOL_CHUNK_HEADER_SIZE;
+    for (u32 i = allocator->blocks_per_chunk; i > 0; --i) {
+        void **block = (void **)(blocks + (i - 1) * allocator->block_size);
+        *block = allocator->free_list;
+        allocator->free_list = block;
+    }
+
+    return TRUE;
+}
+
+void pool_allocator_create(const char *name, u64 block_size,
+                           u32 blocks_per_chunk, memory_tag tag,
+                           pool_allocator *out_allocator) {
+    if (!out_allocator) {
+        return;
+    }
+
+    kzero_memory(out_allocator, sizeof(pool_allocator));
+
+    // Free blocks hold the free list link, and blocks of 16 bytes or more
+    // keep 16-byte alignment for SIMD members
+    u64 alignment = block_size >= 16 ? 16 : sizeof(void *);
+    if (block_size < sizeof(void *)) {
+        block_size = sizeof(void *);
+    }
+
+    out_allocator->name = name;
+    out_allocator->tag = tag;
+    out_allocator->block_size = (block_size + alignment - 1) & ~(alignment - 1);
+    out_allocator->blocks_per_chunk = blocks_per_chunk ? blocks_per_chunk : 1;
+
+    memory_register_pool(out_allocator);
+}
+
+void pool_allocator_destroy(pool_allocator *allocator) {
+    if (!allocator) {
+        return;
+    }
+
+    if (allocator->blocks_in_use) {
+        KWARN("pool_allocator_destroy - pool '%s' destroyed with %llu blocks "
+              "still in use.",
+              allocator->name, allocator->blocks_in_use);
+    }
+
+    memory_unregister_pool(allocator);
+
+    u64 size = chunk_size(allocator);
+    void **chunk = allocator->chunks;
+    while (chunk) {
+        void **next = *chunk;
+        kfree(chunk, size, allocator->tag);
+        chunk = next;
+    }
+
+    kzero_memory(allocator, sizeof(pool_allocator));
+}
+
+void *pool_allocator_allocate(pool_allocator *allocator) {
+    if (!allocator->free_list && !add_chunk(allocator)) {
+        KERROR("pool_allocator_allocate - pool '%s' could not grow.",
+               allocator->name);
+        return 0;
+    }
+
+    void **block = allocator->free_list;
+    allocator->free_list = *block;
+
+    allocator->blocks_in_use++;
+    if (allocator->blocks_in_use > allocator->peak_blocks_in_use) {
+        allocator->peak_blocks_in_use = allocator->blocks_in_use;
+    }
+
+    return block;
+}
+
+void pool_allocator_free(pool_allocator *allocator, void *block) {
+    if (!block) {
+        return;
+    }
+
+    *(void **)block = allocator->free_list;
+    allocator->free_list = block;
+    allocator->blocks_in_use--;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "core/kmemory.h"
+#include "defines.h"
+
+/**
+ * A pool of fixed-size blocks. Blocks are carved out of chunks taken from
+ * kallocate under the pool's memory tag, and free blocks are threaded through
+ * an intrusive free list, so allocate and free are a single pointer swap.
+ * Chunks are only returned when the pool is destroyed.
+ */
+typedef struct pool_allocator {
+    // Shown in the memory usage report
+    const char *name;
+    memory_tag tag;
+
+    u64 block_size;
+    // The number of blocks added each time the pool runs dry
+    u32 blocks_per_chunk;
+
+    void *free_list;
+    void *chunks;
+
+    u32 chunk_count;
+    u64 blocks_in_use;
+    u64 peak_blocks_in_use;
+} pool_allocator;
+
+/**
+ * Creates a pool allocator and registers it with the memory report
+ * @param name A name for the pool. Must outlive the pool
+ * @param block_size The size of every block in bytes
+ * @param blocks_per_chunk The number of blocks to add whenever the pool runs
+ * out of free blocks
+ * @param tag The memory tag the pool's chunks are accounted under
+ * @param out_allocator A pointer to hold the created allocator
+ */
+KAPI void pool_allocator_create(const char *name, u64 block_size,
+                                u32 blocks_per_chunk, memory_tag tag,
+                                pool_allocator *out_allocator);
+
+KAPI void pool_allocator_destroy(pool_allocator *allocator);
+
+/**
+ * Takes a block from the pool, adding a chunk first if none are free. The
+ * memory is NOT zeroed
+ * @param allocator The pool to allocate from
+ * @returns A pointer to the block
+ */
+KAPI void *pool_allocator_allocate(pool_allocator *allocator);
+
+/**
+ * Returns a block to the pool it was allocated from
+ * @param allocator The pool the block belongs to
+ * @param block The block to free
+ */
+KAPI void pool_allocator_free(pool_allocator *allocator, void *block);
@@ -0,0 +1,272 @@
+#include "recorder.h"
+
+#include "containers/darray.h"
+#include "core/event.h"
+#include "core/input.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+STATIC_ASSERT(sizeof(recorder_entry) == 16,
+              "Expected recorder entries to be 16 bytes.");
+
+// "KREC", little endian
+#define RECORDING_MAGIC 0x4345524Bu
+#define RECORDING_VERSION 2
+
+// How many entries are buffered before they are appended to the log, 64 KiB
+#define RECORDER_FLUSH_ENTRIES 4096
+
+// Comes before the entries in the log. The entries run to the end of the
+// file, so a log cut short by a crash still replays up to its last write
+typedef struct recording_header {
+    u32 magic;
+    u16 version;
+    u16 entry_size;
+} recording_header;
+
+typedef struct recorder_state {
+    b8 recording;
+    b8 replaying;
+    const char *path;
+    f64 start_time;
+    u32 frame;
+
+    // Recorded entries not yet appended to the log. Those since the last
+    // frame entry belong to the frame in progress
+    recorder_entry *entries;
+    u32 frame_entry_count;
+
+    // The loaded log, and how far the replay has got through it
+    u8 *log;
+    u64 log_size;
+    const recorder_entry *replay_entries;
+    u32 replay_count;
+    u32 replay_cursor;
+} recorder_state;
+
+static recorder_state state;
+
+b8 recorder_start_recording(const char *path) {
+    if (state.recording || state.replaying) {
+        KERROR("recorder_start_recording - the recorder is already in use.");
+        return FALSE;
+    }
+
+    kzero_memory(&state, sizeof(state));
+    recording_header header = {0};
+    header.magic = RECORDING_MAGIC;
+    header.version = RECORDING_VERSION;
+    header.entry_size = sizeof(recorder_entry);
+    if (!platform_write_file(path, &header, sizeof(header))) {
+        KERROR("recorder_start_recording - could not create '%s'.", path);
+        return FALSE;
+    }
+
+    state.entries = darray_reserve(recorder_entry, RECORDER_FLUSH_ENTRIES);
+    state.path = path;
+    state.start_time = platform_get_absolute_time();
+    state.recording = TRUE;
+    KINFO("Recording input to '%s'.", path);
+    return TRUE;
+}
+
+// Checks an entry before anything of the log is replayed, so that a corrupt
+// or hand-edited log cannot index past the input state's arrays
+static b8 is_valid_entry(const recorder_entry *entry) {
+    switch (entry->type) {
+    case RECORDER_ENTRY_FRAME:
+        // Also rejects NaN
+        return entry->delta_time >= 0;
+    case RECORDER_ENTRY_KEY:
+        return entry->code < KEYS_MAX_KEYS && entry->value <= 1;
+    case RECORDER_ENTRY_BUTTON:
+        return entry->code < BUTTON_MAX_BUTTONS && entry->value <= 1;
+    case RECORDER_ENTRY_MOUSE_MOVE:
+    case RECORDER_ENTRY_MOUSE_WHEEL:
+    case RECORDER_ENTRY_RESIZE:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+b8 recorder_start_replay(const char *path) {
+    if (state.recording || state.replaying) {
+        KERROR("recorder_start_replay - the recorder is already in use.");
+        return FALSE;
+    }
+
+    kzero_memory(&state, sizeof(state));
+    u64 size = 0;
+    if (!platform_get_file_size(path, &size) ||
+        size < sizeof(recording_header)) {
+        KERROR("recorder_start_replay - '%s' is not a recording.", path);
+        return FALSE;
+    }
+
+    u8 *log = kallocate(size, MEMORY_TAG_ARRAY);
+    if (!platform_read_file(path, log, size)) {
+        kfree(log, size, MEMORY_TAG_ARRAY);
+        return FALSE;
+    }
+
+    recording_header *header = (recording_header *)log;
+    if (header->magic != RECORDING_MAGIC ||
+        header->version != RECORDING_VERSION ||
+        header->entry_size != sizeof(recorder_entry)) {
+        KERROR("recorder_start_replay - '%s' is not a recording made by this "
+               "version.",
+               path);
+        kfree(log, size, MEMORY_TAG_ARRAY);
+        return FALSE;
+    }
+
+    // A partly written last entry is dropped
+    const recorder_entry *entries =
+        (recorder_entry *)(log + sizeof(recording_header));
+    u32 count = (u32)((size - sizeof(recording_header)) /
+                      sizeof(recorder_entry));
+    u32 frame_count = 0;
+    for (u32 i = 0; i < count; ++i) {
+        if (!is_valid_entry(&entries[i])) {
+            KERROR("recorder_start_replay - '%s' has an invalid entry at %u.",
+                   path, i);
+            kfree(log, size, MEMORY_TAG_ARRAY);
+            return FALSE;
+        }
+        frame_count += entries[i].type == RECORDER_ENTRY_FRAME;
+    }
+
+    state.log = log;
+    state.log_size = size;
+    state.replay_entries = entries;
+    state.replay_count = count;
+    state.path = path;
+    state.start_time = platform_get_absolute_time();
+    state.replaying = TRUE;
+    KINFO("Replaying %u frames from '%s'.", frame_count, path);
+    return TRUE;
+}
+
+// Appends the buffered entries to the log. Recording stops if that fails,
+// rather than carrying on with a gap in the log
+static b8 flush_entries() {
+    u32 count = (u32)darray_length(state.entries);
+    b8 written = !count || platform_append_file(state.path, state.entries,
+                                                count * sizeof(recorder_entry));
+    darray_clear(state.entries);
+    if (!written) {
+        KERROR("Failed to write the recording to '%s', recording stopped.",
+               state.path);
+        state.recording = FALSE;
+    }
+    return written;
+}
+
+void recorder_shutdown() {
+    if (state.recording) {
+        // Input from a frame that never ended would be dropped on replay
+        darray_length_set(state.entries, darray_length(state.entries) -
+                                             state.frame_entry_count);
+        if (flush_entries()) {
+            KINFO("Recorded %u frames to '%s'.", state.frame, state.path);
+        }
+    }
+    if (state.entries) {
+        darray_destroy(state.entries);
+    }
+
+    if (state.replaying) {
+        // What replays are compared by
+        f64 elapsed = platform_get_absolute_time() - state.start_time;
+        KINFO("Replayed %u frames in %.3f s, %.3f ms per frame.", state.frame,
+              elapsed, state.frame ? elapsed * 1000.0 / state.frame : 0.0);
+        kfree(state.log, state.log_size, MEMORY_TAG_ARRAY);
+    }
+
+    kzero_memory(&state, sizeof(state));
+}
+
+b8 recorder_is_replaying() { return state.replaying; }
+
+static void push_entry(recorder_entry *entry) {
+    entry->frame = state.frame;
+    entry->time = (f32)(platform_get_absolute_time() - state.start_time);
+    darray_push(state.entries, *entry);
+    state.frame_entry_count++;
+}
+
+void recorder_record(recorder_entry_type type, u16 code, u8 value, i16 x,
+                     i16 y) {
+    if (!state.recording) {
+        return;
+    }
+
+    recorder_entry entry;
+    entry.type = type;
+    entry.value = value;
+    entry.code = code;
+    entry.xy[0] = x;
+    entry.xy[1] = y;
+    push_entry(&entry);
+}
+
+void recorder_end_frame(f32 delta_time) {
+    if (!state.recording) {
+        return;
+    }
+
+    recorder_entry entry = {0};
+    entry.type = RECORDER_ENTRY_FRAME;
+    entry.delta_time = delta_time;
+    push_entry(&entry);
+    state.frame++;
+    state.frame_entry_count = 0;
+
+    // Only whole frames are written, so the log always ends on a frame
+    if (darray_length(state.entries) >= RECORDER_FLUSH_ENTRIES) {
+        flush_entries();
+    }
+}
+
+void recorder_end_suspended_frame() {
+    if (state.recording && state.frame_entry_count) {
+        recorder_end_frame(0);
+    }
+}
+
+b8 recorder_replay_frame(f32 *out_delta_time) {
+    while (state.replaying && state.replay_cursor < state.replay_count) {
+        const recorder_entry *entry =
+            &state.replay_entries[state.replay_cursor++];
+
+        switch (entry->type) {
+        case RECORDER_ENTRY_FRAME:
+            *out_delta_time = entry->delta_time;
+            state.frame++;
+            return TRUE;
+        case RECORDER_ENTRY_KEY:
+            input_process_key(entry->code, entry->value);
+            break;
+        case RECORDER_ENTRY_BUTTON:
+            input_process_button(entry->code, entry->value);
+            break;
+        case RECORDER_ENTRY_MOUSE_MOVE:
+            input_process_mouse_move(entry->xy[0], entry->xy[1]);
+            break;
+        case RECORDER_ENTRY_MOUSE_WHEEL:
+            input_process_mouse_wheel((i8)entry->value);
+            break;
+        case RECORDER_ENTRY_RESIZE: {
+            event_context context;
+            context.data.u16[0] = entry->xy[0];
+            context.data.u16[1] = entry->xy[1];
+            event_post(EVENT_CODE_RESIZED, 0, context);
+        } break;
+        }
+    }
+
+    // Input from a frame that never ended is dropped with it
+    return FALSE;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "defines.h"
+
+// Records every input call and platform event of a session into a compact
+// binary log, and replays such a log in place of the platform. A replay needs
+// no window, feeds the same input on the same frames with the same frame
+// times, and so drives the game through an identical workload every run.
+
+typedef enum recorder_entry_type {
+    // Ends a frame. Every entry since the previous one happened during it
+    RECORDER_ENTRY_FRAME,
+    RECORDER_ENTRY_KEY,
+    RECORDER_ENTRY_BUTTON,
+    RECORDER_ENTRY_MOUSE_MOVE,
+    RECORDER_ENTRY_MOUSE_WHEEL,
+    RECORDER_ENTRY_RESIZE
+} recorder_entry_type;
+
+/**
+ * One recorded call, 16 bytes in the log
+ */
+typedef struct recorder_entry {
+    // The frame it happened in, counting from 0 when recording started
+    u32 frame;
+    // Seconds since recording started
+    f32 time;
+    // A recorder_entry_type
+    u8 type;
+    // Whether a key or button was pressed, or the wheel's delta
+    u8 value;
+    // The key or button
+    u16 code;
+    union {
+        // Mouse position, or the window's new size
+        i16 xy[2];
+        // The delta time the game was updated with, for frame entries
+        f32 delta_time;
+    };
+} recorder_entry;
+
+/**
+ * Starts recording. The log is written a few thousand entries at a time as
+ * frames end, so a crash loses at most the last unwritten stretch
+ * @param path The file to write the log to. Replaced if it exists
+ * @returns TRUE on success; otherwise FALSE
+ */
+b8 recorder_start_recording(const char *path);
+
+/**
+ * Loads a log to replay with `recorder_replay_frame`. Every entry is checked
+ * first, and a log with any invalid entry is rejected as a whole
+ * @param path The log to replay
+ * @returns TRUE if the log was loaded; otherwise FALSE
+ */
+b8 recorder_start_replay(const char *path);
+
+/**
+ * Writes out the rest of the recording, if there is one, or reports how long
+ * the replay took, and frees the recorder's memory
+ */
+void recorder_shutdown();
+
+b8 recorder_is_replaying();
+
+/**
+ * Records an input call or platform event. Does nothing unless recording
+ */
+void recorder_record(recorder_entry_type type, u16 code, u8 value, i16 x,
+                     i16 y);
+
+/**
+ * Ends the current frame of the recording. Does nothing unless recording
+ * @param delta_time The delta time the game was updated with this frame
+ */
+void recorder_end_frame(f32 delta_time);
+
+/**
+ * Ends a frame the game was suspended for, but only if input or platform
+ * events were recorded during it, so a long suspension adds nothing to the
+ * log. Does nothing unless recording
+ */
+void recorder_end_suspended_frame();
+
+/**
+ * Feeds the input and platform events of the next recorded frame back in,
+ * in place of pumping the platform's messages
+ * @param out_delta_time A pointer to hold the delta time to update the game
+ * with this frame
+ * @returns TRUE if a frame was replayed; FALSE once the log has ended
+ */
+b8 recorder_replay_frame(f32 *out_delta_time);
@@ -0,0 +1,102 @@
+#include "scratch_allocator.h"
+
+#include "core/kmemory.h"
+#include "core/virtual_arena.h"
+#include "platform/platform.h"
+
+typedef struct scratch_stack {
+    virtual_arena arena;
+    u64 top;
+} scratch_stack;
+
+static _Thread_local scratch_stack thread_stack;
+// Releases a thread's reservation when the thread exits
+static platform_thread_key stack_key;
+static b8 initialized = FALSE;
+
+// Runs before the memory system hands back the thread's stat shard, which
+// `initialize_memory` arranges by creating this key first
+static void release_stack(void *value) {
+    scratch_stack *stack = value;
+    virtual_arena_destroy(&stack->arena);
+    stack->top = 0;
+}
+
+static scratch_stack *get_stack() {
+    scratch_stack *stack = &thread_stack;
+    if (!stack->arena.base) {
+        if (!virtual_arena_create(KSCRATCH_RESERVE_SIZE, MEMORY_TAG_SCRATCH,
+                                  &stack->arena)) {
+            return 0;
+        }
+
+        if (initialized) {
+            platform_thread_key_set(&stack_key, stack);
+        }
+    }
+    return stack;
+}
+
+void scratch_allocator_initialize() {
+    initialized = platform_thread_key_create(release_stack, &stack_key);
+}
+
+void scratch_allocator_shutdown() {
+    // Other threads release their stacks as they exit; the calling thread
+    // releases its own here
+    release_stack(&thread_stack);
+
+    if (initialized) {
+        platform_thread_key_destroy(&stack_key);
+        initialized = FALSE;
+    }
+}
+
+scratch_marker scratch_begin() { return thread_stack.top; }
+
+void *scratch_allocate(u64 size) {
+    scratch_stack *stack = get_stack();
+    if (!stack) {
+        return 0;
+    }
+
+    u64 offset = (stack->top + (KSCRATCH_ALIGNMENT - 1)) &
+                 ~(u64)(KSCRATCH_ALIGNMENT - 1);
+    if (!virtual_arena_commit(&stack->arena, offset + size)) {
+        return 0;
+    }
+
+    stack->top = offset + size;
+    return stack->arena.base + offset;
+}
+
+void *scratch_resize(void *block, u64 old_size, u64 new_size) {
+    scratch_stack *stack = get_stack();
+    if (!stack) {
+        return 0;
+    }
+
+    u64 offset = (u8 *)block - stack->arena.base;
+    if (offset + old_size == stack->top) {
+        if (!virtual_arena_commit(&stack->arena, offset + new_size)) {
+            return 0;
+        }
+        stack->top = offset + new_size;
+        return block;
+    }
+
+    void *grown = scratch_allocate(new_size);
+    if (grown) {
+        kcopy_memory(grown, block, old_size);
+    }
+    return grown;
+}
+
+void scratch_end(scratch_marker marker) {
+    scratch_stack *stack = &thread_stack;
+    stack->top = marker;
+
+    if (marker == 0 && stack->arena.committed_size > KSCRATCH_RETAIN_SIZE) {
+        virtual_arena_decommit(&stack->arena, KSCRATCH_RETAIN_SIZE);
+    }
+}
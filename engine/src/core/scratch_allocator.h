@@ -0,0 +1,58 @@
+#pragma once
+
+#include "defines.h"
+
+// Address space reserved for each thread's scratch stack. Pages are only
+// committed as the stack grows into them.
+#ifndef KSCRATCH_RESERVE_SIZE
+#define KSCRATCH_RESERVE_SIZE (64 * 1024 * 1024)
+#endif
+
+// When a thread's scratch stack empties, committed pages beyond this size
+// are handed back to the OS so one large spike does not pin memory forever
+#ifndef KSCRATCH_RETAIN_SIZE
+#define KSCRATCH_RETAIN_SIZE (1024 * 1024)
+#endif
+
+// Every scratch allocation is aligned to this boundary
+#define KSCRATCH_ALIGNMENT 16
+
+// The top of a thread's scratch stack at some point in time
+typedef u64 scratch_marker;
+
+void scratch_allocator_initialize();
+void scratch_allocator_shutdown();
+
+/**
+ * Opens a scratch scope on the calling thread. Everything allocated with
+ * `scratch_allocate` until the matching `scratch_end` is released at once.
+ * Scopes nest like a stack
+ * @returns A marker to pass to `scratch_end`
+ */
+KAPI scratch_marker scratch_begin();
+
+/**
+ * Allocates temporary memory from the calling thread's scratch stack. The
+ * memory is NOT zeroed and must not be passed to another thread or kfree
+ * @param size The number of bytes to allocate
+ * @returns A pointer to the block, or 0/NULL if the stack is exhausted
+ */
+KAPI void *scratch_allocate(u64 size);
+
+/**
+ * Grows a scratch allocation. The block is extended in place when it is the
+ * most recent allocation on the stack; otherwise a new block is allocated and
+ * the contents copied
+ * @param block The block to grow, from `scratch_allocate` on this thread
+ * @param old_size The block's current size
+ * @param new_size The size to grow to
+ * @returns A pointer to the grown block, or 0/NULL if the stack is exhausted,
+ * in which case the original block is untouched
+ */
+KAPI void *scratch_resize(void *block, u64 old_size, u64 new_size);
+
+/**
+ * Releases every scratch allocation made since `marker` was taken
+ * @param marker The marker returned by the matching `scratch_begin`
+ */
+KAPI void scratch_end(scratch_marker marker);
@@ -0,0 +1,89 @@
+#include "string_intern.h"
+
+#include "containers/darray.h"
+#include "containers/hashmap.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+typedef struct string_intern_state {
+    // Keys borrow the copies in `strings`, so each string is stored once
+    hashmap ids;
+    // Indexed by id. Slot 0 stays empty so that 0 is never a valid id
+    const char **strings;
+} string_intern_state;
+
+static b8 initialized = FALSE;
+static string_intern_state state;
+
+b8 string_intern_initialize() {
+    if (initialized) {
+        return FALSE;
+    }
+
+    if (!hashmap_create(HASHMAP_KEY_STRING_BORROWED, sizeof(string_id), 256,
+                        &state.ids)) {
+        return FALSE;
+    }
+    state.strings = darray_reserve(const char *, 256);
+    darray_push(state.strings, (const char *)0);
+
+    initialized = TRUE;
+    return TRUE;
+}
+
+void string_intern_shutdown() {
+    if (!initialized) {
+        return;
+    }
+
+    hashmap_destroy(&state.ids);
+    u64 count = darray_length(state.strings);
+    for (u64 i = 1; i < count; ++i) {
+        kfree((char *)state.strings[i], string_length(state.strings[i]) + 1,
+              MEMORY_TAG_STRING);
+    }
+    darray_destroy(state.strings);
+    state.strings = 0;
+
+    initialized = FALSE;
+}
+
+string_id string_intern(const char *str) {
+    if (!initialized || !str) {
+        return INVALID_STRING_ID;
+    }
+
+    string_id *existing = hashmap_get_string(&state.ids, str);
+    if (existing) {
+        return *existing;
+    }
+
+    string_id id = (string_id)darray_length(state.strings);
+    const char *copy = string_duplicate(str);
+    if (!hashmap_set_string(&state.ids, copy, &id)) {
+        KERROR("string_intern - failed to intern '%s'.", str);
+        kfree((char *)copy, string_length(copy) + 1, MEMORY_TAG_STRING);
+        return INVALID_STRING_ID;
+    }
+    darray_push(state.strings, copy);
+
+    return id;
+}
+
+string_id string_intern_find(const char *str) {
+    if (!initialized || !str) {
+        return INVALID_STRING_ID;
+    }
+
+    string_id *existing = hashmap_get_string(&state.ids, str);
+    return existing ? *existing : INVALID_STRING_ID;
+}
+
+const char *string_intern_get(string_id id) {
+    if (!initialized || id == INVALID_STRING_ID ||
+        id >= darray_length(state.strings)) {
+        return 0;
+    }
+    return state.strings[id];
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * A stable id for an interned string. Two strings with the same contents
+ * always intern to the same id, so interned strings compare with `==`.
+ * 0 is never handed out.
+ */
+typedef u32 string_id;
+
+#define INVALID_STRING_ID 0
+
+b8 string_intern_initialize();
+
+/**
+ * Frees every interned string. Ids and pointers from before are invalid
+ * afterwards
+ */
+void string_intern_shutdown();
+
+/**
+ * Adds a string to the intern table, or finds it if it is already there.
+ * The table is not thread safe; only intern from the main thread
+ * @param str The string to intern. Copied, so it may be temporary
+ * @returns The string's id, or INVALID_STRING_ID on failure
+ */
+KAPI string_id string_intern(const char *str);
+
+/**
+ * Looks up a string without adding it
+ * @returns The string's id, or INVALID_STRING_ID if it was never interned
+ */
+KAPI string_id string_intern_find(const char *str);
+
+/**
+ * Gets the table's copy of an interned string. The pointer stays valid until
+ * shutdown, and is the same for every string with the same contents
+ * @returns The string, or 0/NULL for an invalid id
+ */
+KAPI const char *string_intern_get(string_id id);
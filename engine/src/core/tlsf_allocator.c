@@ -0,0 +1,415 @@
+#include "tlsf_allocator.h"
+
+#include "core/logger.h"
+#include "platform/platform.h"
+
+// Log2 of the number of second level subdivisions per first level.
+#define SL_INDEX_COUNT_LOG2 5
+#define SL_INDEX_COUNT (1 << SL_INDEX_COUNT_LOG2)
+
+#define ALIGN_SIZE_LOG2 4
+#define ALIGN_SIZE (1 << ALIGN_SIZE_LOG2)
+
+// Blocks up to 1 TiB. Blocks below SMALL_BLOCK_SIZE all share the first
+// first-level index and are split linearly in ALIGN_SIZE steps.
+#define FL_INDEX_MAX 40
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE (1ULL << FL_INDEX_SHIFT)
+
+STATIC_ASSERT(FL_INDEX_COUNT <= 32, "First level bitmap must fit in a u32.");
+STATIC_ASSERT(SL_INDEX_COUNT <= 32, "Second level bitmap must fit in a u32.");
+
+#define BLOCK_FREE_BIT 1ULL
+#define BLOCK_SIZE_MASK (~(u64)(ALIGN_SIZE - 1))
+
+typedef struct tlsf_block {
+    // Always valid; 0 for the first block in the pool
+    struct tlsf_block *prev_physical;
+    // Payload size in bytes. The low bit marks the block as free
+    u64 size;
+
+    // Only valid while the block is free; they overlap the payload otherwise
+    struct tlsf_block *next_free;
+    struct tlsf_block *prev_free;
+} tlsf_block;
+
+// The part of the header that stays in front of a used block's payload
+#define BLOCK_OVERHEAD (sizeof(tlsf_block *) + sizeof(u64))
+#define BLOCK_SIZE_MIN (sizeof(tlsf_block) - BLOCK_OVERHEAD)
+#define BLOCK_SIZE_MAX (1ULL << FL_INDEX_MAX)
+
+STATIC_ASSERT(BLOCK_OVERHEAD == ALIGN_SIZE,
+              "Block overhead must keep payloads aligned.");
+
+typedef struct tlsf_control {
+    u32 fl_bitmap;
+    u32 sl_bitmap[FL_INDEX_COUNT];
+    tlsf_block *blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+} tlsf_control;
+
+static u64 align_up(u64 value, u64 alignment) {
+    return (value + (alignment - 1)) & ~(alignment - 1);
+}
+
+static u32 fls_u64(u64 value) { return 63 - __builtin_clzll(value); }
+
+static u64 block_size(const tlsf_block *block) {
+    return block->size & BLOCK_SIZE_MASK;
+}
+
+static b8 block_is_free(const tlsf_block *block) {
+    return (block->size & BLOCK_FREE_BIT) != 0;
+}
+
+static void *block_to_ptr(tlsf_block *block) {
+    return (u8 *)block + BLOCK_OVERHEAD;
+}
+
+static tlsf_block *block_from_ptr(const void *ptr) {
+    return (tlsf_block *)((u8 *)ptr - BLOCK_OVERHEAD);
+}
+
+static tlsf_block *block_next(tlsf_block *block) {
+    return (tlsf_block *)((u8 *)block_to_ptr(block) + block_size(block));
+}
+
+static void mapping_insert(u64 size, u32 *fl, u32 *sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (u32)(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+    } else {
+        u32 f = fls_u64(size);
+        *sl = (u32)(size >> (f - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        *fl = f - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+// Rounds the request up to the next list boundary so that any block found in
+// the resulting list is guaranteed to be large enough.
+static void mapping_search(u64 size, u32 *fl, u32 *sl) {
+    if (size >= SMALL_BLOCK_SIZE) {
+        u64 round = (1ULL << (fls_u64(size) - SL_INDEX_COUNT_LOG2)) - 1;
+        size += round;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static tlsf_block *search_suitable_block(tlsf_control *control, u32 *fl,
+                                         u32 *sl) {
+    if (*fl >= FL_INDEX_COUNT) {
+        return 0;
+    }
+
+    u32 sl_map = control->sl_bitmap[*fl] & (~0U << *sl);
+    if (!sl_map) {
+        u32 fl_map =
+            (*fl + 1 < 32) ? control->fl_bitmap & (~0U << (*fl + 1)) : 0;
+        if (!fl_map) {
+            return 0;
+        }
+
+        *fl = __builtin_ctz(fl_map);
+        sl_map = control->sl_bitmap[*fl];
+    }
+
+    *sl = __builtin_ctz(sl_map);
+    return control->blocks[*fl][*sl];
+}
+
+static void remove_free_block(tlsf_control *control, tlsf_block *block,
+                              u32 fl, u32 sl) {
+    tlsf_block *prev = block->prev_free;
+    tlsf_block *next = block->next_free;
+    if (next) {
+        next->prev_free = prev;
+    }
+    if (prev) {
+        prev->next_free = next;
+    }
+
+    if (control->blocks[fl][sl] == block) {
+        control->blocks[fl][sl] = next;
+        if (!next) {
+            control->sl_bitmap[fl] &= ~(1U << sl);
+            if (!control->sl_bitmap[fl]) {
+                control->fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+}
+
+static void insert_free_block(tlsf_control *control, tlsf_block *block,
+                              u32 fl, u32 sl) {
+    tlsf_block *current = control->blocks[fl][sl];
+    block->next_free = current;
+    block->prev_free = 0;
+    if (current) {
+        current->prev_free = block;
+    }
+
+    control->blocks[fl][sl] = block;
+    control->fl_bitmap |= (1U << fl);
+    control->sl_bitmap[fl] |= (1U << sl);
+}
+
+static void block_remove(tlsf_control *control, tlsf_block *block) {
+    u32 fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    remove_free_block(control, block, fl, sl);
+}
+
+static void block_insert(tlsf_control *control, tlsf_block *block) {
+    u32 fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    insert_free_block(control, block, fl, sl);
+}
+
+// Splits `size` bytes off the front of the block and returns the remainder
+// as a new free block.
+static tlsf_block *block_split(tlsf_block *block, u64 size) {
+    tlsf_block *remaining = (tlsf_block *)((u8 *)block_to_ptr(block) + size);
+    u64 remaining_size = block_size(block) - (size + BLOCK_OVERHEAD);
+
+    remaining->size = remaining_size | BLOCK_FREE_BIT;
+    remaining->prev_physical = block;
+    block_next(remaining)->prev_physical = remaining;
+
+    block->size = size | (block->size & BLOCK_FREE_BIT);
+    return remaining;
+}
+
+// Absorbs `block` into the physically preceding block `prev`.
+static tlsf_block *block_absorb(tlsf_block *prev, tlsf_block *block) {
+    prev->size += block_size(block) + BLOCK_OVERHEAD;
+    block_next(prev)->prev_physical = prev;
+    return prev;
+}
+
+static u64 adjust_request_size(u64 size) {
+    u64 adjusted = align_up(size, ALIGN_SIZE);
+    return adjusted < BLOCK_SIZE_MIN ? BLOCK_SIZE_MIN : adjusted;
+}
+
+static void *block_prepare_used(tlsf_allocator *allocator, tlsf_block *block,
+                                u64 size) {
+    tlsf_control *control = allocator->control;
+
+    if (block_size(block) >= size + sizeof(tlsf_block)) {
+        tlsf_block *remaining = block_split(block, size);
+        block_insert(control, remaining);
+        allocator->free_space -= BLOCK_OVERHEAD;
+    }
+
+    block->size &= ~BLOCK_FREE_BIT;
+    allocator->free_space -= block_size(block);
+    return block_to_ptr(block);
+}
+
+b8 tlsf_allocator_create(u64 total_size, void *memory,
+                         tlsf_allocator *out_allocator) {
+    if (!out_allocator) {
+        return FALSE;
+    }
+
+    platform_zero_memory(out_allocator, sizeof(tlsf_allocator));
+
+    u64 control_size = align_up(sizeof(tlsf_control), ALIGN_SIZE);
+    // Room for the control structure, the first block and the end sentinel
+    if (total_size < control_size + sizeof(tlsf_block) + BLOCK_OVERHEAD) {
+        KERROR("tlsf_allocator_create - %lluB is too small for a TLSF pool.",
+               total_size);
+        return FALSE;
+    }
+
+    out_allocator->owns_memory = memory == 0;
+    if (!memory) {
+        memory = platform_allocate(total_size, TRUE);
+        if (!memory) {
+            KERROR("tlsf_allocator_create - failed to reserve %lluB.",
+                   total_size);
+            return FALSE;
+        }
+    }
+
+    out_allocator->memory = memory;
+    out_allocator->memory_size = total_size;
+
+    // Keep the pool itself aligned even if the caller's block is not
+    u64 start = align_up((u64)memory, ALIGN_SIZE);
+    u64 end = ((u64)memory + total_size) & ~((u64)ALIGN_SIZE - 1);
+
+    tlsf_control *control = (tlsf_control *)start;
+    platform_zero_memory(control, sizeof(tlsf_control));
+    out_allocator->control = control;
+
+    u64 pool_start = start + control_size;
+    u64 pool_size = end - pool_start - BLOCK_OVERHEAD * 2;
+    if (pool_size > BLOCK_SIZE_MAX - 1) {
+        pool_size = BLOCK_SIZE_MAX - ALIGN_SIZE;
+    }
+
+    tlsf_block *block = (tlsf_block *)pool_start;
+    block->prev_physical = 0;
+    block->size = pool_size | BLOCK_FREE_BIT;
+
+    // A zero-sized, permanently used block terminates the pool so merging
+    // never has to check for the end
+    tlsf_block *sentinel = block_next(block);
+    sentinel->prev_physical = block;
+    sentinel->size = 0;
+
+    block_insert(control, block);
+
+    out_allocator->total_size = pool_size;
+    out_allocator->free_space = pool_size;
+
+    return TRUE;
+}
+
+void tlsf_allocator_destroy(tlsf_allocator *allocator) {
+    if (!allocator) {
+        return;
+    }
+
+    if (allocator->owns_memory && allocator->memory) {
+        platform_free(allocator->memory, TRUE);
+    }
+
+    platform_zero_memory(allocator, sizeof(tlsf_allocator));
+}
+
+void *tlsf_allocator_allocate(tlsf_allocator *allocator, u64 size) {
+    if (!allocator || !allocator->control || size > BLOCK_SIZE_MAX / 2) {
+        return 0;
+    }
+
+    tlsf_control *control = allocator->control;
+    u64 adjusted = adjust_request_size(size);
+
+    u32 fl, sl;
+    mapping_search(adjusted, &fl, &sl);
+    tlsf_block *block = search_suitable_block(control, &fl, &sl);
+    if (!block) {
+        return 0;
+    }
+
+    remove_free_block(control, block, fl, sl);
+    return block_prepare_used(allocator, block, adjusted);
+}
+
+void *tlsf_allocator_allocate_aligned(tlsf_allocator *allocator, u64 size,
+                                      u64 alignment) {
+    if (alignment <= ALIGN_SIZE) {
+        return tlsf_allocator_allocate(allocator, size);
+    }
+
+    if (!allocator || !allocator->control || size > BLOCK_SIZE_MAX / 2 ||
+        (alignment & (alignment - 1)) != 0) {
+        return 0;
+    }
+
+    tlsf_control *control = allocator->control;
+    u64 adjusted = adjust_request_size(size);
+
+    // Any gap left in front of the aligned address must be large enough to
+    // become a free block of its own
+    const u64 gap_minimum = sizeof(tlsf_block);
+    u64 search_size = adjusted + alignment + gap_minimum;
+
+    u32 fl, sl;
+    mapping_search(search_size, &fl, &sl);
+    tlsf_block *block = search_suitable_block(control, &fl, &sl);
+    if (!block) {
+        return 0;
+    }
+
+    remove_free_block(control, block, fl, sl);
+
+    u64 ptr = (u64)block_to_ptr(block);
+    u64 aligned = align_up(ptr, alignment);
+    u64 gap = aligned - ptr;
+    if (gap && gap < gap_minimum) {
+        aligned = align_up(ptr + gap_minimum, alignment);
+        gap = aligned - ptr;
+    }
+
+    if (gap) {
+        // Give the leading gap back as a free block. Its physical neighbour
+        // before it cannot be free, since free blocks are always merged.
+        tlsf_block *aligned_block = block_split(block, gap - BLOCK_OVERHEAD);
+        block_insert(control, block);
+        allocator->free_space -= BLOCK_OVERHEAD;
+        block = aligned_block;
+    }
+
+    return block_prepare_used(allocator, block, adjusted);
+}
+
+void tlsf_allocator_free(tlsf_allocator *allocator, void *ptr) {
+    if (!allocator || !allocator->control || !ptr) {
+        return;
+    }
+
+    tlsf_control *control = allocator->control;
+    tlsf_block *block = block_from_ptr(ptr);
+    if (block_is_free(block)) {
+        KERROR("tlsf_allocator_free - block %p freed twice.", ptr);
+        return;
+    }
+
+    allocator->free_space += block_size(block);
+    block->size |= BLOCK_FREE_BIT;
+
+    tlsf_block *prev = block->prev_physical;
+    if (prev && block_is_free(prev)) {
+        block_remove(control, prev);
+        block = block_absorb(prev, block);
+        allocator->free_space += BLOCK_OVERHEAD;
+    }
+
+    tlsf_block *next = block_next(block);
+    if (block_is_free(next)) {
+        block_remove(control, next);
+        block_absorb(block, next);
+        allocator->free_space += BLOCK_OVERHEAD;
+    }
+
+    block_insert(control, block);
+}
+
+b8 tlsf_allocator_owns(tlsf_allocator *allocator, const void *block) {
+    if (!allocator || !allocator->memory) {
+        return FALSE;
+    }
+
+    u64 address = (u64)block;
+    u64 start = (u64)allocator->memory;
+    return address >= start && address < start + allocator->memory_size;
+}
+
+u64 tlsf_allocator_largest_free_block(tlsf_allocator *allocator) {
+    if (!allocator || !allocator->control) {
+        return 0;
+    }
+
+    tlsf_control *control = allocator->control;
+    if (!control->fl_bitmap) {
+        return 0;
+    }
+
+    // Blocks in the highest non-empty list are the largest; sizes within one
+    // list still differ, so walk it.
+    u32 fl = 31 - __builtin_clz(control->fl_bitmap);
+    u32 sl = 31 - __builtin_clz(control->sl_bitmap[fl]);
+
+    u64 largest = 0;
+    for (tlsf_block *block = control->blocks[fl][sl]; block;
+         block = block->next_free) {
+        if (block_size(block) > largest) {
+            largest = block_size(block);
+        }
+    }
+
+    return largest;
+}
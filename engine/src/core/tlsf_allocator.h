@@ -0,0 +1,71 @@
+#pragma once
+
+#include "defines.h"
+
+// Every block handed out by the TLSF allocator is at least aligned to this
+// boundary
+#define TLSF_ALLOCATOR_ALIGNMENT 16
+
+/**
+ * A two-level segregated fit allocator. Free blocks are binned by size into
+ * a first level (power of two) and a second level (linear subdivision of
+ * that power of two), with a bitmap per level, so both allocation and free
+ * run in constant time regardless of how many blocks are live.
+ */
+typedef struct tlsf_allocator {
+    // Usable bytes in the pool, after the allocator's own bookkeeping
+    u64 total_size;
+    // Bytes currently available for allocation, block headers excluded
+    u64 free_space;
+
+    void *memory;
+    u64 memory_size;
+    b8 owns_memory;
+
+    // Internal bookkeeping, kept at the front of `memory`
+    void *control;
+} tlsf_allocator;
+
+/**
+ * Creates a TLSF allocator over a block of memory
+ * @param total_size The size of the block in bytes
+ * @param memory The block to allocate from. If 0/NULL, the allocator reserves
+ * and owns its own block
+ * @param out_allocator A pointer to hold the created allocator
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 tlsf_allocator_create(u64 total_size, void *memory,
+                              tlsf_allocator *out_allocator);
+
+KAPI void tlsf_allocator_destroy(tlsf_allocator *allocator);
+
+/**
+ * Allocates a block from the allocator. The memory is NOT zeroed
+ * @param allocator The allocator to allocate from
+ * @param size The number of bytes to allocate
+ * @returns A pointer to the block, or 0/NULL if no free block is large enough
+ */
+KAPI void *tlsf_allocator_allocate(tlsf_allocator *allocator, u64 size);
+
+/**
+ * Allocates a block whose address is a multiple of the given alignment
+ * @param allocator The allocator to allocate from
+ * @param size The number of bytes to allocate
+ * @param alignment The required alignment. Must be a power of two
+ * @returns A pointer to the block, or 0/NULL if no free block is large enough
+ */
+KAPI void *tlsf_allocator_allocate_aligned(tlsf_allocator *allocator, u64 size,
+                                           u64 alignment);
+
+KAPI void tlsf_allocator_free(tlsf_allocator *allocator, void *block);
+
+/**
+ * @returns TRUE if the block was allocated from this allocator's pool
+ */
+KAPI b8 tlsf_allocator_owns(tlsf_allocator *allocator, const void *block);
+
+/**
+ * @returns The size of the largest block that could currently be allocated.
+ * Together with `free_space` this gives a measure of fragmentation
+ */
+KAPI u64 tlsf_allocator_largest_free_block(tlsf_allocator *allocator);
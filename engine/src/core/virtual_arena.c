@@ -0,0 +1,91 @@
+#include "virtual_arena.h"
+
+#include "core/logger.h"
+#include "platform/platform.h"
+
+static u64 page_round(u64 size) {
+    u64 page_size = platform_page_size();
+    return (size + page_size - 1) & ~(page_size - 1);
+}
+
+b8 virtual_arena_create(u64 reserve_size, memory_tag tag,
+                        virtual_arena *out_arena) {
+    if (!out_arena) {
+        return FALSE;
+    }
+
+    u64 size = page_round(reserve_size);
+    u8 *base = platform_reserve_memory(size);
+    if (!base) {
+        return FALSE;
+    }
+
+    out_arena->base = base;
+    out_arena->reserved_size = size;
+    out_arena->committed_size = 0;
+    out_arena->tag = tag;
+
+    // The reservation counts as one allocation; its bytes are counted as
+    // pages are committed
+    memory_track_allocation(0, 1, tag);
+
+    return TRUE;
+}
+
+void virtual_arena_destroy(virtual_arena *arena) {
+    if (!arena || !arena->base) {
+        return;
+    }
+
+    memory_track_free(arena->committed_size, 1, arena->tag);
+
+    // The arena may live inside its own reservation, so read everything
+    // needed before releasing it
+    u8 *base = arena->base;
+    u64 reserved_size = arena->reserved_size;
+    b8 arena_is_inside =
+        (u8 *)arena >= base && (u8 *)arena < base + reserved_size;
+
+    platform_release_memory(base, reserved_size);
+
+    if (!arena_is_inside) {
+        kzero_memory(arena, sizeof(virtual_arena));
+    }
+}
+
+b8 virtual_arena_commit(virtual_arena *arena, u64 size) {
+    if (size <= arena->committed_size) {
+        return TRUE;
+    }
+
+    u64 new_committed = page_round(size);
+    if (new_committed > arena->reserved_size) {
+        KERROR("virtual_arena_commit - %lluB exceeds the %lluB reservation.",
+               size, arena->reserved_size);
+        return FALSE;
+    }
+
+    u64 delta = new_committed - arena->committed_size;
+    if (!platform_commit_memory(arena->base + arena->committed_size, delta)) {
+        KERROR("virtual_arena_commit - failed to commit %lluB.", delta);
+        return FALSE;
+    }
+
+    arena->committed_size = new_committed;
+    memory_track_allocation(delta, 0, arena->tag);
+
+    return TRUE;
+}
+
+void virtual_arena_decommit(virtual_arena *arena, u64 size) {
+    u64 keep = page_round(size);
+    if (keep >= arena->committed_size) {
+        return;
+    }
+
+    u64 delta = arena->committed_size - keep;
+    platform_decommit_memory(arena->base + keep, delta);
+
+    arena->committed_size = keep;
+    memory_track_free(delta, 0, arena->tag);
+}
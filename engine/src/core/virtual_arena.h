@@ -0,0 +1,47 @@
+#pragma once
+
+#include "core/kmemory.h"
+#include "defines.h"
+
+/**
+ * A contiguous range of address space reserved up front and backed with
+ * memory one page at a time as it is committed. Growing an arena never moves
+ * it, so pointers into it stay valid for its whole lifetime.
+ */
+typedef struct virtual_arena {
+    u8 *base;
+    u64 reserved_size;
+    u64 committed_size;
+    memory_tag tag;
+} virtual_arena;
+
+/**
+ * Reserves address space for an arena. Nothing is committed yet
+ * @param reserve_size The most bytes the arena can ever grow to. Rounded up
+ * to the page size
+ * @param tag The memory tag committed pages are accounted under
+ * @param out_arena A pointer to hold the created arena
+ * @returns TRUE on success; otherwise FALSE
+ */
+KAPI b8 virtual_arena_create(u64 reserve_size, memory_tag tag,
+                             virtual_arena *out_arena);
+
+KAPI void virtual_arena_destroy(virtual_arena *arena);
+
+/**
+ * Makes sure at least the first `size` bytes of the arena are committed
+ * @param arena The arena to grow
+ * @param size The number of bytes from the start of the arena that must be
+ * usable. Rounded up to the page size
+ * @returns TRUE on success; FALSE if `size` exceeds the reservation or the OS
+ * refuses to commit more memory
+ */
+KAPI b8 virtual_arena_commit(virtual_arena *arena, u64 size);
+
+/**
+ * Returns committed pages past the first `size` bytes to the OS. Their
+ * contents are lost
+ * @param arena The arena to shrink
+ * @param size The number of bytes from the start of the arena to keep
+ */
+KAPI void virtual_arena_decommit(virtual_arena *arena, u64 size);
@@ -98,9 +98,16 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 #endif
 #endif
 
+// Size of a CPU cache line. Data written by different threads should not
+// share one, or every write invalidates the line for the other threads.
+#define KCACHE_LINE_SIZE 64
+
 #define KCLAMP(value, min, max)                                                \
     (value <= min) ? min : (value >= max) ? max : value;
 
+#define KMIN(x, y) ((x) < (y) ? (x) : (y))
+#define KMAX(x, y) ((x) > (y) ? (x) : (y))
+
 // Inlining
 #ifdef _MSC_VER
 #define KINLINE __forceinline
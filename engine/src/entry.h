@@ -2,6 +2,7 @@
 
 #include "core/application.h"
 #include "core/kmemory.h"
+#include "core/kstring.h"
 #include "core/logger.h"
 #include "game_types.h"
 
@@ -10,15 +11,27 @@ extern b8 create_game(game *out_game);
 /**
  * The main entry point of the application
  */
-int main(void) {
+int main(int argc, char **argv) {
     initialize_memory();
 
-    game game_inst;
+    game game_inst = {0};
     if (!create_game(&game_inst)) {
         KFATAL("Could not create game!");
         return -1;
     }
 
+    // `--record <file>`, `--replay <file>` and `--heap-profile <file>`
+    // override the game's config
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strings_equal(argv[i], "--record")) {
+            game_inst.app_config.record_path = argv[++i];
+        } else if (strings_equal(argv[i], "--replay")) {
+            game_inst.app_config.replay_path = argv[++i];
+        } else if (strings_equal(argv[i], "--heap-profile")) {
+            game_inst.app_config.heap_profile_path = argv[++i];
+        }
+    }
+
     if (!game_inst.render || !game_inst.update || !game_inst.initialize ||
         !game_inst.on_resize) {
         KFATAL("The game's function pointers must be assigned!");
@@ -13,15 +13,85 @@ void platform_shutdown(platform_state *plat_state);
 
 b8 platform_pump_messages(platform_state *plat_state);
 
+// Aligned allocations are aligned to PLATFORM_DEFAULT_ALIGNMENT bytes
+#define PLATFORM_DEFAULT_ALIGNMENT 16
+
 void *platform_allocate(u64 size, b8 aligned);
 void platform_free(void *block, b8 aligned);
+
+// Allocates a block aligned to `alignment`, which must be a power of two
+void *platform_allocate_aligned(u64 size, u64 alignment);
+void platform_free_aligned(void *block);
+
+// Maps fresh, zero-filled pages straight from the OS, backed by huge pages
+// when the system allows it. Meant for blocks of several megabytes; the
+// result is aligned to at least PLATFORM_HUGE_PAGE_SIZE
+#define PLATFORM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+void *platform_allocate_large(u64 size);
+void platform_free_large(void *block, u64 size);
+
+// The bytes `platform_allocate_large` maps for a request of `size`, which is
+// what the request really costs
+u64 platform_large_allocation_size(u64 size);
+
+// Virtual memory. Reserving claims an address range without backing it with
+// memory; pages only cost memory once committed. All sizes and addresses
+// passed to these must be multiples of the page size
+u64 platform_page_size();
+void *platform_reserve_memory(u64 size);
+b8 platform_commit_memory(void *block, u64 size);
+void platform_decommit_memory(void *block, u64 size);
+void platform_release_memory(void *block, u64 size);
 void *platform_zero_memory(void *block, u64 size);
 void *platform_copy_memory(void *dest, const void *source, u64 size);
+void *platform_move_memory(void *dest, const void *source, u64 size);
 void *platform_set_memory(void *block, i32 value, u64 size);
 
 void platform_console_write(const char *message, u8 colour);
 void platform_console_write_error(const char *message, u8 colour);
 
+typedef struct platform_mutex {
+    void *internal_data;
+} platform_mutex;
+
+b8 platform_mutex_create(platform_mutex *out_mutex);
+void platform_mutex_destroy(platform_mutex *mutex);
+void platform_mutex_lock(platform_mutex *mutex);
+void platform_mutex_unlock(platform_mutex *mutex);
+
+// A per-thread value slot. When a thread that stored a non-zero value exits,
+// `on_thread_exit` is invoked with that value
+typedef struct platform_thread_key {
+    u64 handle;
+} platform_thread_key;
+
+b8 platform_thread_key_create(void (*on_thread_exit)(void *value),
+                              platform_thread_key *out_key);
+void platform_thread_key_destroy(platform_thread_key *key);
+void platform_thread_key_set(platform_thread_key *key, void *value);
+
+// Fills `out_frames` with the return addresses on the calling thread's stack,
+// innermost first, after skipping `skip` frames above the caller. Returns the
+// number of frames captured
+u32 platform_capture_backtrace(u32 skip, void **out_frames, u32 max_frames);
+
+// Copies the process's module map, in /proc/self/maps format, into `buffer`
+// so captured addresses can be symbolized offline. Returns the number of
+// bytes written
+u64 platform_get_module_map(char *buffer, u64 capacity);
+
+b8 platform_write_file(const char *path, const void *data, u64 size);
+
+// Appends to the end of a file, which must already exist
+b8 platform_append_file(const char *path, const void *data, u64 size);
+
+// Gets the size of a file in bytes, failing if it cannot be opened
+b8 platform_get_file_size(const char *path, u64 *out_size);
+
+// Reads the first `size` bytes of a file into `buffer`
+b8 platform_read_file(const char *path, void *buffer, u64 size);
+
 f64 platform_get_absolute_time();
 
 // Sleep on the thread for the provided ms. This blocks the main thread
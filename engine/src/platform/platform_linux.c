@@ -3,6 +3,7 @@
 #include "renderer/vulkan/vulkan_platform.h"
 
 #include "core/input.h"
+#include "core/recorder.h"
 #include "defines.h"
 #include "platform.h"
 #include "vulkan/vulkan_core.h"
@@ -17,6 +18,7 @@
 #include <X11/Xlib-xcb.h> // sudo pacman -S libxkbcommon-x11-dev
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <xcb/xcb.h>
 
@@ -26,9 +28,12 @@
 #include <unistd.h>
 #endif
 
+#include <execinfo.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define VK_USE_PLATFORM_XCB_KHR
 #include "renderer/vulkan/vulkan_types.inl"
@@ -194,10 +199,13 @@ b8 platform_pump_messages(platform_state *plat_state) {
             xcb_configure_notify_event_t *configure_event =
                 (xcb_configure_notify_event_t *)event;
 
+            recorder_record(RECORDER_ENTRY_RESIZE, 0, 0, configure_event->width,
+                            configure_event->height);
+
             event_context context;
             context.data.u16[0] = configure_event->width;
             context.data.u16[1] = configure_event->height;
-            event_fire(EVENT_CODE_RESIZED, 0, context);
+            event_post(EVENT_CODE_RESIZED, 0, context);
         } break;
         case XCB_CLIENT_MESSAGE: {
             cm = (xcb_client_message_event_t *)event;
@@ -216,10 +224,122 @@ b8 platform_pump_messages(platform_state *plat_state) {
     return !quit_flagged;
 }
 
-void *platform_allocate(u64 size, b8 aligned) { return malloc(size); }
+void *platform_allocate(u64 size, b8 aligned) {
+    if (aligned) {
+        return platform_allocate_aligned(size, PLATFORM_DEFAULT_ALIGNMENT);
+    }
+    return malloc(size);
+}
 
 void platform_free(void *block, b8 aligned) { free(block); }
 
+void *platform_allocate_aligned(u64 size, u64 alignment) {
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+
+    void *block = 0;
+    if (posix_memalign(&block, alignment, size) != 0) {
+        return 0;
+    }
+    return block;
+}
+
+void platform_free_aligned(void *block) { free(block); }
+
+// Older headers lack the flag selecting the huge page size. Without it the
+// system default is used, which need not be the 2 MiB the mapping is sized
+// and unmapped in
+#ifndef MAP_HUGE_2MB
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+static u64 huge_page_round(u64 size) {
+    return (size + PLATFORM_HUGE_PAGE_SIZE - 1) &
+           ~((u64)PLATFORM_HUGE_PAGE_SIZE - 1);
+}
+
+u64 platform_large_allocation_size(u64 size) { return huge_page_round(size); }
+
+void *platform_allocate_large(u64 size) {
+    u64 mapped_size = huge_page_round(size);
+
+    // Explicit huge pages only exist if the administrator reserved some
+    void *block = mmap(0, mapped_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB,
+                       -1, 0);
+    if (block != MAP_FAILED) {
+        return block;
+    }
+
+    // Otherwise ask for transparent huge pages. The kernel can only use them
+    // for 2 MiB aligned ranges, so over-map and trim to an aligned window
+    u64 reserve_size = mapped_size + PLATFORM_HUGE_PAGE_SIZE;
+    u8 *reserved = mmap(0, reserve_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        KERROR("platform_allocate_large - failed to map %lluB.", size);
+        return 0;
+    }
+
+    u8 *aligned = (u8 *)huge_page_round((u64)reserved);
+    u64 head = aligned - reserved;
+    u64 tail = reserve_size - head - mapped_size;
+    if (head) {
+        munmap(reserved, head);
+    }
+    if (tail) {
+        munmap(aligned + mapped_size, tail);
+    }
+
+    madvise(aligned, mapped_size, MADV_HUGEPAGE);
+    return aligned;
+}
+
+void platform_free_large(void *block, u64 size) {
+    if (block) {
+        munmap(block, huge_page_round(size));
+    }
+}
+
+u64 platform_page_size() {
+    static u64 page_size = 0;
+    if (!page_size) {
+        page_size = (u64)sysconf(_SC_PAGESIZE);
+    }
+    return page_size;
+}
+
+void *platform_reserve_memory(u64 size) {
+    void *block = mmap(0, size, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (block == MAP_FAILED) {
+        KERROR("platform_reserve_memory - failed to reserve %lluB.", size);
+        return 0;
+    }
+    return block;
+}
+
+b8 platform_commit_memory(void *block, u64 size) {
+    return mprotect(block, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void platform_decommit_memory(void *block, u64 size) {
+    // Drop the pages first so the memory goes back to the OS, then make the
+    // range inaccessible again
+    madvise(block, size, MADV_DONTNEED);
+    mprotect(block, size, PROT_NONE);
+}
+
+void platform_release_memory(void *block, u64 size) {
+    if (block) {
+        munmap(block, size);
+    }
+}
+
 void *platform_zero_memory(void *block, u64 size) {
     return memset(block, 0, size);
 }
@@ -228,6 +348,10 @@ void *platform_copy_memory(void *dest, const void *source, u64 size) {
     return memcpy(dest, source, size);
 }
 
+void *platform_move_memory(void *dest, const void *source, u64 size) {
+    return memmove(dest, source, size);
+}
+
 void *platform_set_memory(void *block, i32 value, u64 size) {
     return memset(block, value, size);
 }
@@ -244,6 +368,148 @@ void platform_console_write_error(const char *message, u8 colour) {
     printf("\033[%sm%s\033[0m", color_strings[colour], message);
 }
 
+b8 platform_mutex_create(platform_mutex *out_mutex) {
+    // Mutexes guard the memory system itself, so they cannot use kallocate
+    pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
+    if (!mutex || pthread_mutex_init(mutex, 0) != 0) {
+        free(mutex);
+        out_mutex->internal_data = 0;
+        KERROR("Failed to create mutex.");
+        return FALSE;
+    }
+
+    out_mutex->internal_data = mutex;
+    return TRUE;
+}
+
+void platform_mutex_destroy(platform_mutex *mutex) {
+    if (mutex->internal_data) {
+        pthread_mutex_destroy(mutex->internal_data);
+        free(mutex->internal_data);
+        mutex->internal_data = 0;
+    }
+}
+
+void platform_mutex_lock(platform_mutex *mutex) {
+    pthread_mutex_lock(mutex->internal_data);
+}
+
+void platform_mutex_unlock(platform_mutex *mutex) {
+    pthread_mutex_unlock(mutex->internal_data);
+}
+
+b8 platform_thread_key_create(void (*on_thread_exit)(void *value),
+                              platform_thread_key *out_key) {
+    pthread_key_t key;
+    if (pthread_key_create(&key, on_thread_exit) != 0) {
+        KERROR("Failed to create thread key.");
+        return FALSE;
+    }
+
+    out_key->handle = key;
+    return TRUE;
+}
+
+void platform_thread_key_destroy(platform_thread_key *key) {
+    pthread_key_delete((pthread_key_t)key->handle);
+}
+
+void platform_thread_key_set(platform_thread_key *key, void *value) {
+    pthread_setspecific((pthread_key_t)key->handle, value);
+}
+
+#define PLATFORM_MAX_BACKTRACE_FRAMES 64
+
+u32 platform_capture_backtrace(u32 skip, void **out_frames, u32 max_frames) {
+    void *frames[PLATFORM_MAX_BACKTRACE_FRAMES];
+
+    // Skip this function's own frame as well
+    skip++;
+    i32 count = backtrace(frames, PLATFORM_MAX_BACKTRACE_FRAMES);
+    if (count <= (i32)skip) {
+        return 0;
+    }
+
+    u32 captured = count - skip;
+    if (captured > max_frames) {
+        captured = max_frames;
+    }
+    memcpy(out_frames, frames + skip, captured * sizeof(void *));
+
+    return captured;
+}
+
+u64 platform_get_module_map(char *buffer, u64 capacity) {
+    FILE *file = fopen("/proc/self/maps", "r");
+    if (!file) {
+        return 0;
+    }
+
+    u64 size = fread(buffer, 1, capacity, file);
+    fclose(file);
+
+    return size;
+}
+
+b8 platform_write_file(const char *path, const void *data, u64 size) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        KERROR("platform_write_file - could not open '%s'.", path);
+        return FALSE;
+    }
+
+    b8 written = fwrite(data, 1, size, file) == size;
+    fclose(file);
+
+    return written;
+}
+
+b8 platform_append_file(const char *path, const void *data, u64 size) {
+    // "r+b" rather than "ab" so that a missing file is an error
+    FILE *file = fopen(path, "r+b");
+    if (!file) {
+        KERROR("platform_append_file - could not open '%s'.", path);
+        return FALSE;
+    }
+
+    b8 written = fseek(file, 0, SEEK_END) == 0 &&
+                 fwrite(data, 1, size, file) == size;
+    written = fclose(file) == 0 && written;
+
+    return written;
+}
+
+b8 platform_get_file_size(const char *path, u64 *out_size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        KERROR("platform_get_file_size - could not open '%s'.", path);
+        return FALSE;
+    }
+
+    b8 result = fseek(file, 0, SEEK_END) == 0;
+    long size = ftell(file);
+    fclose(file);
+    if (!result || size < 0) {
+        return FALSE;
+    }
+
+    *out_size = (u64)size;
+    return TRUE;
+}
+
+b8 platform_read_file(const char *path, void *buffer, u64 size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        KERROR("platform_read_file - could not open '%s'.", path);
+        return FALSE;
+    }
+
+    b8 read = fread(buffer, 1, size, file) == size;
+    fclose(file);
+
+    return read;
+}
+
 f64 platform_get_absolute_time() {
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
@@ -265,8 +531,8 @@ void platform_sleep(u64 ms) {
 #endif
 }
 
-void platform_get_required_extension_names(const char ***names_darray) {
-    darray_push(*names_darray, &"VK_KHR_xcb_surface");
+void platform_get_required_extension_names(vulkan_name_array *names) {
+    vulkan_name_array_push(names, "VK_KHR_xcb_surface");
 }
 
 b8 platform_create_vulkan_surface(struct platform_state *plat_state,
@@ -66,37 +66,38 @@ b8 vulkan_renderer_backend_initialize(renderer_backend *backend,
     VkInstanceCreateInfo create_info = {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
     create_info.pApplicationInfo = &app_info;
 
-    const char **required_extensions = darray_create(const char *);
+    vulkan_name_array required_extensions = {0};
 
     // Generic surface extension
-    darray_push(required_extensions, &VK_KHR_SURFACE_EXTENSION_NAME);
+    vulkan_name_array_push(&required_extensions, VK_KHR_SURFACE_EXTENSION_NAME);
 
     platform_get_required_extension_names(&required_extensions);
 
 #if defined(_DEBUG)
-    darray_push(required_extensions, &VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    vulkan_name_array_push(&required_extensions,
+                           VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
     KDEBUG("Required extensions:");
-    u32 length = darray_length(required_extensions);
-    for (u32 i = 0; i < length; i++) {
-        KDEBUG(required_extensions[i]);
+    const char **extension_names = vulkan_name_array_data(&required_extensions);
+    for (u32 i = 0; i < required_extensions.length; i++) {
+        KDEBUG(extension_names[i]);
     }
 #endif
 
-    create_info.enabledExtensionCount = darray_length(required_extensions);
-    create_info.ppEnabledExtensionNames = required_extensions;
+    create_info.enabledExtensionCount = required_extensions.length;
+    create_info.ppEnabledExtensionNames =
+        vulkan_name_array_data(&required_extensions);
 
-    const char **required_validation_layer_names = 0;
-    u32 required_validation_layers_count = 0;
+    vulkan_name_array required_validation_layers = {0};
 
 #if defined(_DEBUG)
     KINFO("Validation layers enabled. Enumerating...");
 
-    required_validation_layer_names = darray_create(const char *);
-    darray_push(required_validation_layer_names,
-                &"VK_LAYER_KHRONOS_validation");
-    required_validation_layers_count =
-        darray_length(required_validation_layer_names);
+    vulkan_name_array_push(&required_validation_layers,
+                           "VK_LAYER_KHRONOS_validation");
+    const char **required_validation_layer_names =
+        vulkan_name_array_data(&required_validation_layers);
+    u32 required_validation_layers_count = required_validation_layers.length;
 
     u32 available_layer_count = 0;
     VK_CHECK(vkEnumerateInstanceLayerProperties(&available_layer_count, 0));
@@ -105,35 +106,29 @@ b8 vulkan_renderer_backend_initialize(renderer_backend *backend,
     VK_CHECK(vkEnumerateInstanceLayerProperties(&available_layer_count,
                                                 available_layers));
 
-    for (u32 i = 0; i < required_validation_layers_count; ++i) {
-        KINFO("Searching for layer: %s...", required_validation_layer_names[i]);
-        b8 found = FALSE;
-        for (u32 j = 0; j < available_layer_count; ++j) {
-            if (strings_equal(required_validation_layer_names[i],
-                              available_layers[j].layerName)) {
-                found = TRUE;
-                KINFO("Found.");
-                break;
-            }
-        }
-
-        if (!found) {
-            KFATAL("Required validation layer is missing: %s",
-                   required_validation_layer_names[i]);
-            return FALSE;
-        }
+    const char *missing_layer = vulkan_find_missing_name(
+        available_layers[0].layerName, sizeof(VkLayerProperties),
+        available_layer_count, required_validation_layer_names,
+        required_validation_layers_count);
+    if (missing_layer) {
+        KFATAL("Required validation layer is missing: %s", missing_layer);
+        return FALSE;
     }
 
     KINFO("All required validation layers are present.");
 #endif
 
-    create_info.enabledLayerCount = required_validation_layers_count;
-    create_info.ppEnabledLayerNames = required_validation_layer_names;
+    create_info.enabledLayerCount = required_validation_layers.length;
+    create_info.ppEnabledLayerNames =
+        vulkan_name_array_data(&required_validation_layers);
 
     VK_CHECK(
         vkCreateInstance(&create_info, context.allocator, &context.instance));
     KINFO("Vulkan Instance created.");
 
+    vulkan_name_array_destroy(&required_extensions);
+    vulkan_name_array_destroy(&required_validation_layers);
+
 #if defined(_DEBUG)
     KDEBUG("Creating Vulkan debugger...");
     u32 log_severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT |
@@ -7,6 +7,7 @@
 #include "containers/darray.h"
 #include "core/logger.h"
 #include "renderer/vulkan/vulkan_types.inl"
+#include "renderer/vulkan/vulkan_utils.h"
 #include "vulkan/vulkan_core.h"
 
 typedef struct vulkan_physical_device_requirements {
@@ -213,7 +214,7 @@ void vulkan_device_query_swapchain_support(
 
     if (out_support_info->format_count != 0) {
         if (!out_support_info->formats) {
-            out_support_info->formats = kallocate(
+            out_support_info->formats = kallocate_uninitialized(
                 sizeof(VkSurfaceFormatKHR) * out_support_info->format_count,
                 MEMORY_TAG_RENDERER);
         }
@@ -227,7 +228,7 @@ void vulkan_device_query_swapchain_support(
 
     if (out_support_info->present_mode_count != 0) {
         if (!out_support_info->present_modes) {
-            out_support_info->present_modes = kallocate(
+            out_support_info->present_modes = kallocate_uninitialized(
                 sizeof(VkPresentModeKHR) * out_support_info->present_mode_count,
                 MEMORY_TAG_RENDERER);
         }
@@ -456,36 +457,27 @@ b8 physical_device_meets_requirements(
                 device, 0, &available_extensions_count, 0));
 
             if (available_extensions_count != 0) {
-                available_extensions = kallocate(sizeof(VkExtensionProperties) *
-                                                     available_extensions_count,
-                                                 MEMORY_TAG_RENDERER);
+                available_extensions = kallocate_uninitialized(
+                    sizeof(VkExtensionProperties) * available_extensions_count,
+                    MEMORY_TAG_RENDERER);
                 VK_CHECK(vkEnumerateDeviceExtensionProperties(
                     device, 0, &available_extensions_count,
                     available_extensions));
 
-                u32 required_extension_count =
-                    darray_length(requirements->device_extension_names);
-                for (u32 i = 0; i < required_extension_count; ++i) {
-                    b8 found = FALSE;
-                    for (u32 j = 0; j < available_extensions_count; ++j) {
-                        if (strings_equal(
-                                requirements->device_extension_names[i],
-                                available_extensions[j].extensionName)) {
-                            found = TRUE;
-                            break;
-                        }
-                    }
-
-                    if (!found) {
-                        KINFO("Required extension not found: '%s', skipping "
-                              "device.",
-                              requirements->device_extension_names[i]);
-                        kfree(available_extensions,
-                              sizeof(VkExtensionProperties) *
-                                  available_extensions_count,
-                              MEMORY_TAG_RENDERER);
-                        return FALSE;
-                    }
+                const char *missing = vulkan_find_missing_name(
+                    available_extensions[0].extensionName,
+                    sizeof(VkExtensionProperties), available_extensions_count,
+                    requirements->device_extension_names,
+                    (u32)darray_length(requirements->device_extension_names));
+                if (missing) {
+                    KINFO("Required extension not found: '%s', skipping "
+                          "device.",
+                          missing);
+                    kfree(available_extensions,
+                          sizeof(VkExtensionProperties) *
+                              available_extensions_count,
+                          MEMORY_TAG_RENDERER);
+                    return FALSE;
                 }
             }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "containers/small_array.h"
 #include "defines.h"
 
 struct platform_state;
@@ -8,4 +9,8 @@ struct vulkan_context;
 b8 platform_create_vulkan_surface(struct platform_state *plat_state,
                                   struct vulkan_context *context);
 
-void platform_get_required_extension_names(const char ***names_darray);
+// Extension and layer name lists are short and only live through renderer
+// startup, so they stay inline
+SMALL_ARRAY_DEFINE(vulkan_name_array, const char *, 8)
+
+void platform_get_required_extension_names(vulkan_name_array *names);
@@ -1,5 +1,9 @@
 #include "vulkan_utils.h"
 
+#include "containers/bitset.h"
+#include "core/logger.h"
+#include "core/string_intern.h"
+
 const char *vulkan_result_string(VkResult result, b8 get_extended) {
     // From:
     // https://www.khronos.org/registry/vulkan/specs/1.2-extensions/man/html/VkResult.html
@@ -245,3 +249,37 @@ b8 vulkan_result_is_success(VkResult result) {
         return FALSE;
     }
 }
+
+const char *vulkan_find_missing_name(const char *available, u64 stride,
+                                     u32 available_count, const char **required,
+                                     u32 required_count) {
+    if (!required_count) {
+        return 0;
+    }
+
+    // Ids are handed out in order, so the largest one sizes the set
+    string_id max_id = INVALID_STRING_ID;
+    for (u32 i = 0; i < available_count; ++i) {
+        max_id = KMAX(max_id, string_intern(available + i * stride));
+    }
+    bitset available_ids;
+    if (!bitset_create(max_id + 1, &available_ids)) {
+        KERROR("vulkan_find_missing_name - failed to create the name set.");
+        return required[0];
+    }
+    for (u32 i = 0; i < available_count; ++i) {
+        bitset_set(&available_ids,
+                   string_intern_find(available + i * stride));
+    }
+
+    const char *missing = 0;
+    for (u32 i = 0; i < required_count && !missing; ++i) {
+        string_id id = string_intern_find(required[i]);
+        if (id == INVALID_STRING_ID || id > max_id ||
+            !bitset_test(&available_ids, id)) {
+            missing = required[i];
+        }
+    }
+    bitset_destroy(&available_ids);
+    return missing;
+}
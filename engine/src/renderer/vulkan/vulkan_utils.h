@@ -5,3 +5,20 @@
 const char *vulkan_result_string(VkResult result, b8 get_extended);
 
 b8 vulkan_result_is_success(VkResult result);
+
+/**
+ * Checks that every required layer or extension name is available. Names are
+ * interned, so each check is a lookup and a bit test rather than a string
+ * comparison against every available name
+ * @param available The first available name
+ * @param stride The distance in bytes from one available name to the next,
+ * e.g. sizeof(VkLayerProperties)
+ * @param available_count The number of available names
+ * @param required The required names
+ * @param required_count The number of required names
+ * @returns The first required name that is not available, or 0/NULL if they
+ * all are
+ */
+const char *vulkan_find_missing_name(const char *available, u64 stride,
+                                     u32 available_count, const char **required,
+                                     u32 required_count);
@@ -0,0 +1,191 @@
+#include "bitset_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/bitset.h>
+#include <core/kmemory.h>
+
+static b8 bitset_find_next_set_across_words() {
+    bitset256 set = {0};
+    expect_should_be(-1, bitset256_find_next_set(&set, 0));
+
+    // Bits either side of each word boundary, and the very last one
+    u32 bits[] = {0, 63, 64, 127, 128, 200, 255};
+    u32 count = sizeof(bits) / sizeof(bits[0]);
+    for (u32 i = 0; i < count; ++i) {
+        bitset256_set(&set, bits[i]);
+    }
+
+    u32 found = 0;
+    for (i32 bit = bitset256_find_next_set(&set, 0); bit >= 0;
+         bit = bitset256_find_next_set(&set, bit + 1)) {
+        expect_true(found < count);
+        expect_should_be((i32)bits[found], bit);
+        found++;
+    }
+    expect_should_be(count, found);
+
+    // Starting inside a word skips its lower bits, and a run of empty words
+    // is skipped to the next set bit
+    expect_should_be(63, bitset256_find_next_set(&set, 1));
+    expect_should_be(128, bitset256_find_next_set(&set, 128));
+    expect_should_be(200, bitset256_find_next_set(&set, 129));
+    expect_should_be(-1, bitset256_find_next_set(&set, 256));
+    expect_should_be(-1, bitset256_find_next_set(&set, 1000));
+
+    // Across a heap set longer than one SSE2 pair of words
+    bitset large;
+    expect_true(bitset_create(1000, &large));
+    bitset_set(&large, 999);
+    expect_should_be(999, bitset_find_next_set(&large, 0));
+    expect_should_be(999, bitset_find_next_set(&large, 999));
+    bitset_clear(&large, 999);
+    expect_should_be(-1, bitset_find_next_set(&large, 0));
+    bitset_destroy(&large);
+    return TRUE;
+}
+
+static b8 bitset_popcount_counts() {
+    bitset256 set = {0};
+    expect_should_be(0, bitset256_popcount(&set));
+    for (u32 bit = 0; bit < 256; bit += 3) {
+        bitset256_set(&set, bit);
+    }
+    expect_should_be(86, bitset256_popcount(&set));
+    set.words[0] = set.words[1] = set.words[2] = set.words[3] = ~0ull;
+    expect_should_be(256, bitset256_popcount(&set));
+
+    bitset large;
+    expect_true(bitset_create(130, &large));
+    bitset_set(&large, 0);
+    bitset_set(&large, 64);
+    bitset_set(&large, 129);
+    expect_should_be(3, bitset_popcount(&large));
+    bitset_clear_all(&large);
+    expect_should_be(0, bitset_popcount(&large));
+    expect_true(!bitset_any(&large));
+    bitset_destroy(&large);
+    return TRUE;
+}
+
+#define KERNEL_WORDS 9
+#define KERNEL_ROUNDS 2000
+
+static u64 rng_state = 0x9E3779B97F4A7C15ull;
+
+static u64 next_random() {
+    // xorshift64, so runs are repeatable
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Mostly sparse words, often empty, so the predicates come out both ways
+static u64 random_word() {
+    switch (next_random() % 4) {
+    case 0:
+        return 0;
+    case 1:
+        return 1ull << (next_random() % 64);
+    case 2:
+        return next_random() & next_random() & next_random();
+    default:
+        return next_random();
+    }
+}
+
+static u32 count_bits(u64 word) {
+    u32 count = 0;
+    for (; word; word &= word - 1) {
+        count++;
+    }
+    return count;
+}
+
+// The kernels handle two words at a time with SSE2 and any word left over on
+// its own. Over an odd number of words both paths run, and each result must
+// match the same kernel run one word at a time, which only ever takes the
+// scalar path, and a plain loop
+static b8 bitset_kernels_agree(u32 word_count) {
+    u64 a[KERNEL_WORDS], b[KERNEL_WORDS], out[KERNEL_WORDS];
+    for (u32 i = 0; i < word_count; ++i) {
+        a[i] = random_word();
+        b[i] = random_word();
+    }
+    // Some rounds only differ in one word, on either path
+    if (next_random() % 2) {
+        kcopy_memory(b, a, word_count * sizeof(u64));
+        b[next_random() % word_count] ^= 1ull << (next_random() % 64);
+    }
+
+    b8 differ = FALSE, intersects = FALSE, contains = TRUE, any = FALSE;
+    u32 popcount = 0;
+    for (u32 i = 0; i < word_count; ++i) {
+        u64 one;
+        _bitset_and(&one, &a[i], &b[i], 1);
+        expect_should_be(a[i] & b[i], one);
+        differ |= _bitset_differ(&a[i], &b[i], 1);
+        intersects |= _bitset_intersects(&a[i], &b[i], 1);
+        contains &= _bitset_contains(&a[i], &b[i], 1);
+        any |= _bitset_any(&a[i], 1);
+        popcount += _bitset_popcount(&a[i], 1);
+
+        expect_should_be((a[i] ^ b[i]) != 0, _bitset_differ(&a[i], &b[i], 1));
+        expect_should_be((a[i] & b[i]) != 0,
+                         _bitset_intersects(&a[i], &b[i], 1));
+        expect_should_be((b[i] & ~a[i]) == 0,
+                         _bitset_contains(&a[i], &b[i], 1));
+        expect_should_be(count_bits(a[i]), _bitset_popcount(&a[i], 1));
+    }
+
+    _bitset_and(out, a, b, word_count);
+    for (u32 i = 0; i < word_count; ++i) {
+        expect_should_be(a[i] & b[i], out[i]);
+    }
+    _bitset_or(out, a, b, word_count);
+    for (u32 i = 0; i < word_count; ++i) {
+        expect_should_be(a[i] | b[i], out[i]);
+    }
+    _bitset_andnot(out, a, b, word_count);
+    for (u32 i = 0; i < word_count; ++i) {
+        expect_should_be(a[i] & ~b[i], out[i]);
+    }
+    _bitset_xor(out, a, b, word_count);
+    for (u32 i = 0; i < word_count; ++i) {
+        expect_should_be(a[i] ^ b[i], out[i]);
+    }
+
+    expect_should_be(differ, _bitset_differ(a, b, word_count));
+    expect_should_be(intersects, _bitset_intersects(a, b, word_count));
+    expect_should_be(contains, _bitset_contains(a, b, word_count));
+    expect_should_be(any, _bitset_any(a, word_count));
+    expect_should_be(popcount, _bitset_popcount(a, word_count));
+    return TRUE;
+}
+
+static b8 bitset_sse2_and_scalar_kernels_agree() {
+    for (u32 round = 0; round < KERNEL_ROUNDS; ++round) {
+        u32 word_count = 1 + round % KERNEL_WORDS;
+        expect_true(bitset_kernels_agree(word_count));
+    }
+
+    // Writing over one of the inputs, as `a &= b` does
+    u64 a[3] = {0xF0F0, 0xFF00, 0x1};
+    u64 b[3] = {0xFF00, 0x0FF0, 0x3};
+    _bitset_and(a, a, b, 3);
+    expect_should_be(0xF000, a[0]);
+    expect_should_be(0x0F00, a[1]);
+    expect_should_be(0x1, a[2]);
+    return TRUE;
+}
+
+void bitset_register_tests() {
+    test_manager_register_test(bitset_find_next_set_across_words,
+                               "bitset: find_next_set across word boundaries");
+    test_manager_register_test(bitset_popcount_counts,
+                               "bitset: popcount counts set bits");
+    test_manager_register_test(bitset_sse2_and_scalar_kernels_agree,
+                               "bitset: SSE2 and scalar kernels agree");
+}
@@ -0,0 +1,566 @@
+#include "darray_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/darray.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+
+// Big enough that the array is mapped straight from the OS
+#define LARGE_DARRAY_BYTES (8 * 1024 * 1024)
+
+static b8 all_zero(const u8 *bytes, u64 count) {
+    for (u64 i = 0; i < count; ++i) {
+        if (bytes[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static b8 darray_large_arrays_start_zeroed() {
+    u8 *array = darray_reserve(u8, LARGE_DARRAY_BYTES);
+    expect_true(array != 0);
+    expect_should_be(0, darray_length(array));
+    expect_should_be(LARGE_DARRAY_BYTES, darray_capacity(array));
+    expect_true(all_zero(array, LARGE_DARRAY_BYTES));
+    darray_destroy(array);
+
+    // Growing a small array into a large one keeps the live elements and
+    // leaves the rest zeroed
+    u64 *values = darray_create(u64);
+    for (u64 i = 0; i < 1000; ++i) {
+        darray_push(values, i);
+    }
+    darray_reserve_more(values, LARGE_DARRAY_BYTES / sizeof(u64));
+    for (u64 i = 0; i < 1000; ++i) {
+        expect_should_be(i, values[i]);
+    }
+    u64 capacity = darray_capacity(values);
+    expect_true(capacity * sizeof(u64) >= LARGE_DARRAY_BYTES);
+    expect_true(all_zero((u8 *)(values + 1000),
+                         (capacity - 1000) * sizeof(u64)));
+    darray_destroy(values);
+    return TRUE;
+}
+
+// Checks an array holds exactly the given values, in order
+static b8 holds(u32 *array, const u32 *expected, u64 count) {
+    expect_should_be(count, darray_length(array));
+    for (u64 i = 0; i < count; ++i) {
+        expect_should_be(expected[i], array[i]);
+    }
+    return TRUE;
+}
+
+static b8 darray_push_n_and_insert_range() {
+    u32 values[] = {1, 2, 3, 4, 5, 6};
+    u32 *array = darray_create(u32);
+
+    // One append far past the capacity grows just once, to fit
+    darray_push_n(array, values, 6);
+    expect_true(holds(array, values, 6));
+    expect_true(darray_capacity(array) >= 6);
+    darray_push_n(array, values, 0);
+    expect_should_be(6, darray_length(array));
+
+    // At the front, in the middle and at the end, keeping the order
+    u32 inserted[] = {90, 91};
+    darray_insert_range(array, 0, inserted, 2);
+    darray_insert_range(array, 4, inserted, 1);
+    darray_insert_range(array, darray_length(array), inserted + 1, 1);
+    u32 expected[] = {90, 91, 1, 2, 90, 3, 4, 5, 6, 91};
+    expect_true(holds(array, expected, 10));
+
+    // Out of range does nothing
+    darray_insert_range(array, 11, inserted, 2);
+    expect_true(holds(array, expected, 10));
+
+    darray_destroy(array);
+    return TRUE;
+}
+
+static b8 darray_erase_range_and_swap_remove() {
+    u32 values[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    u32 *array = darray_create(u32);
+    darray_push_n(array, values, 10);
+
+    darray_erase_range(array, 2, 3);
+    u32 erased[] = {0, 1, 5, 6, 7, 8, 9};
+    expect_true(holds(array, erased, 7));
+    darray_erase_range(array, 5, 2);
+    darray_erase_range(array, 0, 0);
+    u32 tail_erased[] = {0, 1, 5, 6, 7};
+    expect_true(holds(array, tail_erased, 5));
+    // Out of range does nothing
+    darray_erase_range(array, 3, 3);
+    expect_true(holds(array, tail_erased, 5));
+
+    // The last element takes the removed one's place
+    u32 removed = 0;
+    darray_swap_remove(array, 1, &removed);
+    expect_should_be(1, removed);
+    u32 swapped[] = {0, 7, 5, 6};
+    expect_true(holds(array, swapped, 4));
+    darray_swap_remove(array, 3, &removed);
+    expect_should_be(6, removed);
+    darray_swap_remove(array, 0, 0);
+    u32 left[] = {5, 7};
+    expect_true(holds(array, left, 2));
+    darray_swap_remove(array, 2, &removed);
+    expect_true(holds(array, left, 2));
+
+    darray_erase_range(array, 0, 2);
+    expect_should_be(0, darray_length(array));
+    darray_destroy(array);
+    return TRUE;
+}
+
+static b8 darray_reserve_more_and_shrink_to_fit() {
+    u32 *array = darray_create(u32);
+    for (u32 i = 0; i < 5; ++i) {
+        darray_push(array, i);
+    }
+
+    // Reserving exactly enough means the pushes that follow never move it
+    darray_reserve_more(array, 100);
+    expect_true(darray_capacity(array) >= 105);
+    u32 *reserved = array;
+    for (u32 i = 5; i < 105; ++i) {
+        darray_push(array, i);
+    }
+    expect_true(array == reserved);
+    // Already enough room
+    darray_reserve_more(array, 0);
+    expect_true(array == reserved);
+
+    darray_erase_range(array, 10, 95);
+    darray_shrink_to_fit(array);
+    expect_should_be(10, darray_capacity(array));
+    for (u32 i = 0; i < 10; ++i) {
+        expect_should_be(i, array[i]);
+    }
+    // Fitting arrays are left alone, and still grow
+    u32 *fitted = array;
+    darray_shrink_to_fit(array);
+    expect_true(array == fitted);
+    darray_push(array, 10);
+    expect_should_be(11, darray_length(array));
+    expect_should_be(10, array[10]);
+
+    darray_destroy(array);
+    return TRUE;
+}
+
+typedef struct test_point {
+    i32 x;
+    i32 y;
+} test_point;
+
+DARRAY_DEFINE(u32_array, u32)
+DARRAY_DEFINE(point_array, test_point)
+
+static b8 darray_define_push_pop_and_grow() {
+    u32 *array = u32_array_create(2);
+    expect_should_be(0, u32_array_length(array));
+    expect_should_be(2, u32_array_capacity(array));
+
+    for (u32 i = 0; i < 100; ++i) {
+        array = u32_array_push(array, i * 3);
+    }
+    expect_should_be(100, u32_array_length(array));
+    expect_true(u32_array_capacity(array) >= 100);
+    for (u32 i = 0; i < 100; ++i) {
+        expect_should_be(i * 3, array[i]);
+    }
+
+    expect_should_be(297, u32_array_pop(array));
+    expect_should_be(294, u32_array_pop(array));
+    expect_should_be(98, u32_array_length(array));
+
+    // Inserting and removing keep the order of the rest
+    array = u32_array_insert(array, 0, 1000);
+    array = u32_array_insert(array, 50, 1001);
+    expect_should_be(100, u32_array_length(array));
+    expect_should_be(1000, array[0]);
+    expect_should_be(0, array[1]);
+    expect_should_be(1001, array[50]);
+    expect_should_be(147, array[51]);
+    expect_should_be(1001, u32_array_remove(array, 50));
+    expect_should_be(1000, u32_array_remove(array, 0));
+    expect_should_be(98, u32_array_length(array));
+    for (u32 i = 0; i < 98; ++i) {
+        expect_should_be(i * 3, array[i]);
+    }
+
+    u64 capacity = u32_array_capacity(array);
+    u32_array_clear(array);
+    expect_should_be(0, u32_array_length(array));
+    expect_should_be(capacity, u32_array_capacity(array));
+    u32_array_destroy(array);
+    return TRUE;
+}
+
+static b8 darray_define_resize_and_generic_macros() {
+    test_point *points = point_array_create(1);
+    points = point_array_push(points, (test_point){1, 2});
+
+    // Growing zero-fills the new elements and keeps the old ones
+    points = point_array_resize(points, 20);
+    expect_should_be(20, point_array_length(points));
+    expect_true(point_array_capacity(points) >= 20);
+    expect_should_be(1, points[0].x);
+    expect_should_be(2, points[0].y);
+    for (u64 i = 1; i < 20; ++i) {
+        expect_should_be(0, points[i].x);
+        expect_should_be(0, points[i].y);
+    }
+
+    // Shrinking only drops the tail
+    points[3] = (test_point){7, 8};
+    points = point_array_resize(points, 4);
+    expect_should_be(4, point_array_length(points));
+    expect_should_be(7, points[3].x);
+
+    // They are plain darrays, so the generic macros work on them
+    expect_should_be(4, darray_length(points));
+    expect_should_be(sizeof(test_point), darray_stride(points));
+    test_point pushed = {9, 10};
+    darray_push(points, pushed);
+    expect_should_be(5, point_array_length(points));
+    test_point popped = point_array_pop(points);
+    expect_should_be(9, popped.x);
+    expect_should_be(10, popped.y);
+    point_array_destroy(points);
+
+    // And darrays from the generic macros work with the defined functions
+    u32 *values = darray_create(u32);
+    darray_push(values, 5u);
+    values = u32_array_push(values, 6);
+    expect_should_be(2, darray_length(values));
+    expect_should_be(6, values[1]);
+    darray_destroy(values);
+    return TRUE;
+}
+
+#define VIRTUAL_MAX_LENGTH 100000
+
+static u64 darray_tag_bytes() {
+    memory_tag_stats stats[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(stats);
+    return stats[MEMORY_TAG_DARRAY].current_bytes;
+}
+
+static b8 darray_virtual_grows_in_place() {
+    u64 bytes_before = darray_tag_bytes();
+    u64 *array = darray_create_virtual(u64, VIRTUAL_MAX_LENGTH);
+    expect_true(array != 0);
+    expect_should_be(VIRTUAL_MAX_LENGTH,
+                     _darray_field_get(array, DARRAY_RESERVED_CAPACITY));
+    // Only the first page is committed, and its room is the capacity
+    u64 first_capacity = darray_capacity(array);
+    expect_true(first_capacity > 0);
+    expect_true(first_capacity < VIRTUAL_MAX_LENGTH);
+
+    // Pushing commits more pages without ever moving the elements
+    u64 *start = array;
+    for (u64 i = 0; i < VIRTUAL_MAX_LENGTH / 2; ++i) {
+        darray_push(array, i);
+    }
+    expect_true(array == start);
+    expect_true(darray_capacity(array) >= VIRTUAL_MAX_LENGTH / 2);
+    expect_true(darray_capacity(array) <= VIRTUAL_MAX_LENGTH);
+    expect_true(darray_tag_bytes() - bytes_before >=
+                VIRTUAL_MAX_LENGTH / 2 * sizeof(u64));
+
+    // Reserving up to the limit commits the rest, still in place
+    darray_reserve_more(array, VIRTUAL_MAX_LENGTH / 2);
+    expect_true(array == start);
+    expect_should_be(VIRTUAL_MAX_LENGTH, darray_capacity(array));
+    for (u64 i = VIRTUAL_MAX_LENGTH / 2; i < VIRTUAL_MAX_LENGTH; ++i) {
+        darray_push(array, i);
+    }
+    expect_true(array == start);
+    for (u64 i = 0; i < VIRTUAL_MAX_LENGTH; ++i) {
+        expect_should_be(i, array[i]);
+    }
+
+    // Shrinking decommits the unused pages and never moves the array
+    u64 bytes_full = darray_tag_bytes();
+    darray_length_set(array, 10);
+    darray_shrink_to_fit(array);
+    expect_true(array == start);
+    expect_should_be(first_capacity, darray_capacity(array));
+    expect_true(darray_tag_bytes() < bytes_full);
+    for (u64 i = 0; i < 10; ++i) {
+        expect_should_be(i, array[i]);
+    }
+    // Pages committed again after a decommit come back usable
+    for (u64 i = 10; i < 2 * first_capacity; ++i) {
+        darray_push(array, i);
+    }
+    expect_true(array == start);
+    expect_should_be(2 * first_capacity - 1, array[2 * first_capacity - 1]);
+
+    darray_destroy(array);
+    expect_should_be(bytes_before, darray_tag_bytes());
+    return TRUE;
+}
+
+static b8 darray_virtual_falls_back_to_heap() {
+    u64 *array = darray_create_virtual(u64, VIRTUAL_MAX_LENGTH);
+    for (u64 i = 0; i < VIRTUAL_MAX_LENGTH; ++i) {
+        darray_push(array, i);
+    }
+    u64 *start = array;
+
+    // One element past the reservation moves the array to the heap, where it
+    // keeps growing like any other darray
+    darray_push(array, (u64)VIRTUAL_MAX_LENGTH);
+    expect_true(array != start);
+    expect_should_be(0, _darray_field_get(array, DARRAY_RESERVED_CAPACITY));
+    expect_should_be(VIRTUAL_MAX_LENGTH + 1, darray_length(array));
+    expect_true(darray_capacity(array) > VIRTUAL_MAX_LENGTH);
+    for (u64 i = 0; i <= VIRTUAL_MAX_LENGTH; ++i) {
+        expect_should_be(i, array[i]);
+    }
+    darray_push(array, (u64)7);
+    expect_should_be(VIRTUAL_MAX_LENGTH + 2, darray_length(array));
+    darray_destroy(array);
+
+    // Reserving past the limit falls back too
+    u32 *small = darray_create_virtual(u32, 16);
+    darray_push(small, 1u);
+    darray_reserve_more(small, 1000);
+    expect_should_be(0, _darray_field_get(small, DARRAY_RESERVED_CAPACITY));
+    expect_true(darray_capacity(small) >= 1001);
+    expect_should_be(1, small[0]);
+    darray_destroy(small);
+    return TRUE;
+}
+
+void darray_register_tests() {
+    test_manager_register_test(darray_large_arrays_start_zeroed,
+                               "darray: large arrays start zeroed");
+    test_manager_register_test(darray_push_n_and_insert_range,
+                               "darray: push_n and insert_range");
+    test_manager_register_test(darray_erase_range_and_swap_remove,
+                               "darray: erase_range and swap_remove");
+    test_manager_register_test(darray_reserve_more_and_shrink_to_fit,
+                               "darray: reserve_more and shrink_to_fit");
+    test_manager_register_test(darray_define_push_pop_and_grow,
+                               "darray: DARRAY_DEFINE push, pop and growth");
+    test_manager_register_test(darray_define_resize_and_generic_macros,
+                               "darray: DARRAY_DEFINE resize and interop with "
+                               "the generic macros");
+    test_manager_register_test(darray_virtual_grows_in_place,
+                               "darray: virtual arrays grow and shrink in "
+                               "place");
+    test_manager_register_test(darray_virtual_falls_back_to_heap,
+                               "darray: virtual arrays move to the heap past "
+                               "their reservation");
+}
+
+#define CREATE_ITERATIONS 200
+
+// Creating a large darray takes fresh, already zeroed pages from the OS. The
+// baseline clears the block by hand, as creating one used to
+static b8 darray_benchmark_large_create() {
+    u64 sizes[] = {64 * 1024, LARGE_DARRAY_BYTES, 4 * LARGE_DARRAY_BYTES};
+    for (u32 s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        u64 size = sizes[s];
+
+        clock timer;
+        clock_start(&timer);
+        for (u32 i = 0; i < CREATE_ITERATIONS; ++i) {
+            u8 *block = kallocate_uninitialized(size, MEMORY_TAG_DARRAY);
+            expect_true(block != 0);
+            kzero_memory(block, size);
+            kfree(block, size, MEMORY_TAG_DARRAY);
+        }
+        clock_update(&timer);
+        f64 memset_time = timer.elapsed;
+
+        clock_start(&timer);
+        for (u32 i = 0; i < CREATE_ITERATIONS; ++i) {
+            u8 *array = darray_reserve(u8, size);
+            expect_true(array != 0);
+            darray_destroy(array);
+        }
+        clock_update(&timer);
+
+        KINFO("darray create, %llu KiB: %.2f us with memset, %.2f us as "
+              "darray",
+              size / 1024, memset_time * 1e6 / CREATE_ITERATIONS,
+              timer.elapsed * 1e6 / CREATE_ITERATIONS);
+    }
+    return TRUE;
+}
+
+#define BULK_ELEMENTS 4096
+#define BULK_ROUNDS 200
+
+static u64 rng_state = 0x9E3779B97F4A7C15ull;
+
+static u64 next_random() {
+    // xorshift64, so runs are repeatable
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void report_bulk(const char *operation, f64 single, const char *name,
+                        f64 bulk) {
+    KINFO("%s, %u u32s: %.2f us one at a time, %.2f us %s (%.1fx)",
+          operation, BULK_ELEMENTS, single * 1e6 / BULK_ROUNDS,
+          bulk * 1e6 / BULK_ROUNDS, name, single / bulk);
+}
+
+// Each bulk operation against doing the same work through the
+// single-element calls
+static b8 darray_benchmark_bulk_ops() {
+    u32 *values = darray_reserve(u32, BULK_ELEMENTS);
+    for (u32 i = 0; i < BULK_ELEMENTS; ++i) {
+        darray_push(values, i);
+    }
+    u64 checksum = 0;
+    u32 removed = 0;
+    clock timer;
+
+    // Appending to a fresh array
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        u32 *array = darray_create(u32);
+        for (u32 i = 0; i < BULK_ELEMENTS; ++i) {
+            darray_push(array, values[i]);
+        }
+        checksum += darray_length(array);
+        darray_destroy(array);
+    }
+    clock_update(&timer);
+    f64 single = timer.elapsed;
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        u32 *array = darray_create(u32);
+        darray_push_n(array, values, BULK_ELEMENTS);
+        checksum += darray_length(array);
+        darray_destroy(array);
+    }
+    clock_update(&timer);
+    report_bulk("append", single, "with push_n", timer.elapsed);
+
+    // Pushing one at a time, after reserving up front
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        u32 *array = darray_create(u32);
+        darray_reserve_more(array, BULK_ELEMENTS);
+        for (u32 i = 0; i < BULK_ELEMENTS; ++i) {
+            darray_push(array, values[i]);
+        }
+        checksum += darray_length(array);
+        darray_destroy(array);
+    }
+    clock_update(&timer);
+    report_bulk("append", single, "reserving first", timer.elapsed);
+
+    // Inserting a block at the front of an array as long as the block
+    u32 *base = darray_reserve(u32, 2 * BULK_ELEMENTS);
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        darray_clear(base);
+        darray_push_n(base, values, BULK_ELEMENTS);
+        for (u32 i = 0; i < BULK_ELEMENTS; ++i) {
+            darray_insert_at(base, i, values[i]);
+        }
+        checksum += base[BULK_ELEMENTS];
+    }
+    clock_update(&timer);
+    single = timer.elapsed;
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        darray_clear(base);
+        darray_push_n(base, values, BULK_ELEMENTS);
+        darray_insert_range(base, 0, values, BULK_ELEMENTS);
+        checksum += base[BULK_ELEMENTS];
+    }
+    clock_update(&timer);
+    report_bulk("insert at the front", single, "with insert_range",
+                timer.elapsed);
+
+    // Removing the first half
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        darray_clear(base);
+        darray_push_n(base, values, BULK_ELEMENTS);
+        for (u32 i = 0; i < BULK_ELEMENTS / 2; ++i) {
+            darray_pop_at(base, 0, &removed);
+        }
+        checksum += base[0];
+    }
+    clock_update(&timer);
+    single = timer.elapsed;
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        darray_clear(base);
+        darray_push_n(base, values, BULK_ELEMENTS);
+        darray_erase_range(base, 0, BULK_ELEMENTS / 2);
+        checksum += base[0];
+    }
+    clock_update(&timer);
+    report_bulk("erase the first half", single, "with erase_range",
+                timer.elapsed);
+
+    // Removing elements at random until half are left, when order does not
+    // matter
+    u32 *positions = darray_reserve(u32, BULK_ELEMENTS / 2);
+    for (u32 i = 0; i < BULK_ELEMENTS / 2; ++i) {
+        darray_push(positions, (u32)(next_random() % (BULK_ELEMENTS - i)));
+    }
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        darray_clear(base);
+        darray_push_n(base, values, BULK_ELEMENTS);
+        for (u32 i = 0; i < BULK_ELEMENTS / 2; ++i) {
+            darray_pop_at(base, positions[i], &removed);
+        }
+        checksum += base[0];
+    }
+    clock_update(&timer);
+    single = timer.elapsed;
+    clock_start(&timer);
+    for (u32 round = 0; round < BULK_ROUNDS; ++round) {
+        darray_clear(base);
+        darray_push_n(base, values, BULK_ELEMENTS);
+        for (u32 i = 0; i < BULK_ELEMENTS / 2; ++i) {
+            darray_swap_remove(base, positions[i], &removed);
+        }
+        checksum += base[0];
+    }
+    clock_update(&timer);
+    report_bulk("remove half at random", single, "with swap_remove",
+                timer.elapsed);
+
+    // What shrinking gives back once most of an array is gone
+    u64 before = darray_capacity(base) * sizeof(u32);
+    darray_erase_range(base, 0, darray_length(base) - 16);
+    darray_shrink_to_fit(base);
+    KINFO("shrink_to_fit after erasing all but 16: %llu bytes down to %llu "
+          "(checksum %llu)",
+          before, darray_capacity(base) * sizeof(u32), checksum + removed);
+
+    darray_destroy(positions);
+    darray_destroy(base);
+    darray_destroy(values);
+    return TRUE;
+}
+
+void darray_register_benchmarks() {
+    test_manager_register_test(darray_benchmark_large_create,
+                               "darray: creating large arrays");
+    test_manager_register_test(darray_benchmark_bulk_ops,
+                               "darray: bulk operations against single "
+                               "elements");
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+void darray_register_tests();
+void darray_register_benchmarks();
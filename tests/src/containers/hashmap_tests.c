@@ -0,0 +1,264 @@
+#include "hashmap_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/darray.h>
+#include <containers/hashmap.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+
+// Checks the layout Robin Hood hashing promises: every entry's distance is
+// how far it really sits from its home slot, and walking forward from an
+// entry, each next one is at most one slot further from home. The second
+// also means deletion left no holes inside a probe sequence
+static b8 robin_hood_invariants_hold(hashmap *map) {
+    u32 mask = map->capacity - 1;
+    u32 count = 0;
+    for (u32 i = 0; i < map->capacity; ++i) {
+        hashmap_slot *slot = &map->slots[i];
+        if (!slot->hash) {
+            expect_should_be(0, slot->distance);
+            continue;
+        }
+        count++;
+        expect_should_be((i - (slot->hash & mask)) & mask, slot->distance);
+
+        hashmap_slot *next = &map->slots[(i + 1) & mask];
+        if (next->hash) {
+            expect_true(next->distance <= slot->distance + 1);
+        }
+        if (slot->distance) {
+            // A displaced entry always has a neighbour in front of it
+            expect_true(map->slots[(i + mask) & mask].hash != 0);
+        }
+    }
+    expect_should_be(map->count, count);
+    return TRUE;
+}
+
+static b8 hashmap_insert_and_overwrite() {
+    hashmap map;
+    expect_true(hashmap_create(HASHMAP_KEY_U64, sizeof(u64), 0, &map));
+
+    for (u64 key = 0; key < 500; ++key) {
+        u64 value = key * 3;
+        expect_true(hashmap_set_u64(&map, key, &value));
+        expect_true(robin_hood_invariants_hold(&map));
+    }
+    expect_should_be(500, map.count);
+
+    // Overwriting keeps the count and replaces the value
+    for (u64 key = 0; key < 500; key += 2) {
+        u64 value = key + 1000000;
+        expect_true(hashmap_set_u64(&map, key, &value));
+    }
+    expect_should_be(500, map.count);
+    for (u64 key = 0; key < 500; ++key) {
+        u64 *value = hashmap_get_u64(&map, key);
+        expect_true(value != 0);
+        expect_should_be(key % 2 ? key * 3 : key + 1000000, *value);
+    }
+    expect_true(hashmap_get_u64(&map, 500) == 0);
+
+    hashmap_destroy(&map);
+    return TRUE;
+}
+
+static b8 hashmap_delete_shifts_back() {
+    hashmap map;
+    expect_true(hashmap_create(HASHMAP_KEY_U64, sizeof(u32), 1000, &map));
+    u32 capacity = map.capacity;
+
+    for (u64 key = 0; key < 1000; ++key) {
+        u32 value = (u32)key;
+        expect_true(hashmap_set_u64(&map, key * 7919, &value));
+    }
+
+    // Remove every third key, checking the layout after each removal
+    for (u64 key = 0; key < 1000; key += 3) {
+        u32 removed = 0;
+        expect_true(hashmap_remove_u64(&map, key * 7919, &removed));
+        expect_should_be(key, removed);
+        expect_true(robin_hood_invariants_hold(&map));
+    }
+    expect_true(!hashmap_remove_u64(&map, 0, 0));
+
+    for (u64 key = 0; key < 1000; ++key) {
+        u32 *value = hashmap_get_u64(&map, key * 7919);
+        if (key % 3 == 0) {
+            expect_true(value == 0);
+        } else {
+            expect_true(value != 0);
+            expect_should_be(key, *value);
+        }
+    }
+
+    // Refilling the freed slots needs no growth, as no tombstones are left
+    for (u64 key = 0; key < 1000; key += 3) {
+        u32 value = (u32)key;
+        expect_true(hashmap_set_u64(&map, key * 7919, &value));
+    }
+    expect_should_be(1000, map.count);
+    expect_should_be(capacity, map.capacity);
+    expect_true(robin_hood_invariants_hold(&map));
+
+    hashmap_destroy(&map);
+    return TRUE;
+}
+
+static b8 hashmap_grows() {
+    hashmap map;
+    expect_true(hashmap_create(HASHMAP_KEY_U64, sizeof(u64), 0, &map));
+    u32 capacity = map.capacity;
+
+    for (u64 key = 1; key <= 20000; ++key) {
+        expect_true(hashmap_set_u64(&map, key << 20, &key));
+        if (map.capacity != capacity) {
+            // Each growth doubles and keeps every entry
+            expect_should_be(capacity * 2, map.capacity);
+            capacity = map.capacity;
+            expect_true(robin_hood_invariants_hold(&map));
+        }
+        // The map stays at most 7/8 full
+        expect_true(map.count * 8 <= map.capacity * 7);
+    }
+
+    for (u64 key = 1; key <= 20000; ++key) {
+        u64 *value = hashmap_get_u64(&map, key << 20);
+        expect_true(value != 0);
+        expect_should_be(key, *value);
+    }
+
+    hashmap_clear(&map);
+    expect_should_be(0, map.count);
+    expect_should_be(capacity, map.capacity);
+    expect_true(hashmap_get_u64(&map, 1 << 20) == 0);
+
+    hashmap_destroy(&map);
+    return TRUE;
+}
+
+static b8 hashmap_string_keys_owned_and_borrowed() {
+    memory_tag_stats before[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(before);
+
+    // Owned keys are copied, so the caller's buffer can change afterwards
+    hashmap owned;
+    expect_true(hashmap_create(HASHMAP_KEY_STRING, sizeof(u32), 0, &owned));
+    char buffer[16] = "alpha";
+    u32 value = 1;
+    expect_true(hashmap_set_string(&owned, buffer, &value));
+    buffer[0] = 'A';
+    value = 2;
+    expect_true(hashmap_set_string(&owned, buffer, &value));
+    expect_should_be(2, owned.count);
+    expect_should_be(1, *(u32 *)hashmap_get_string(&owned, "alpha"));
+    expect_should_be(2, *(u32 *)hashmap_get_string(&owned, "Alpha"));
+    for (u32 i = 0; i < owned.capacity; ++i) {
+        expect_true(owned.slots[i].key != (u64)buffer);
+    }
+    expect_true(hashmap_remove_string(&owned, "alpha", 0));
+    expect_true(hashmap_get_string(&owned, "alpha") == 0);
+    hashmap_destroy(&owned);
+
+    // Every copied key was freed again
+    memory_tag_stats after[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(after);
+    expect_should_be(before[MEMORY_TAG_DICT].current_bytes,
+                     after[MEMORY_TAG_DICT].current_bytes);
+
+    // Borrowed keys are stored as given, and looked up by content
+    hashmap borrowed;
+    expect_true(
+        hashmap_create(HASHMAP_KEY_STRING_BORROWED, sizeof(u32), 0, &borrowed));
+    const char *key = "beta";
+    value = 3;
+    expect_true(hashmap_set_string(&borrowed, key, &value));
+    char lookup[] = "beta";
+    expect_should_be(3, *(u32 *)hashmap_get_string(&borrowed, lookup));
+    b8 stored_as_given = FALSE;
+    for (u32 i = 0; i < borrowed.capacity; ++i) {
+        stored_as_given = stored_as_given || borrowed.slots[i].key == (u64)key;
+    }
+    expect_true(stored_as_given);
+    hashmap_destroy(&borrowed);
+    return TRUE;
+}
+
+void hashmap_register_tests() {
+    test_manager_register_test(hashmap_insert_and_overwrite,
+                               "hashmap: insert and overwrite");
+    test_manager_register_test(hashmap_delete_shifts_back,
+                               "hashmap: delete shifts entries back");
+    test_manager_register_test(hashmap_grows, "hashmap: growth keeps entries");
+    test_manager_register_test(hashmap_string_keys_owned_and_borrowed,
+                               "hashmap: owned and borrowed string keys");
+}
+
+#define LOOKUPS 1000000
+
+typedef struct scan_entry {
+    u64 key;
+    u64 value;
+} scan_entry;
+
+// What lookups cost before the map: a linear scan of a darray
+static u64 *scan_find(scan_entry *entries, u64 key) {
+    u64 length = darray_length(entries);
+    for (u64 i = 0; i < length; ++i) {
+        if (entries[i].key == key) {
+            return &entries[i].value;
+        }
+    }
+    return 0;
+}
+
+static b8 hashmap_benchmark_against_scan() {
+    u32 sizes[] = {8, 64, 512, 4096};
+    for (u32 s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        u32 size = sizes[s];
+        hashmap map;
+        expect_true(hashmap_create(HASHMAP_KEY_U64, sizeof(u64), size, &map));
+        scan_entry *entries = darray_reserve(scan_entry, size);
+        for (u64 i = 0; i < size; ++i) {
+            u64 key = i * 0x9E3779B97F4A7C15ull;
+            expect_true(hashmap_set_u64(&map, key, &i));
+            scan_entry entry = {key, i};
+            darray_push(entries, entry);
+        }
+
+        // Scans get fewer lookups at large sizes, so they finish in time
+        u32 scan_lookups = LOOKUPS / KMAX(1, size / 64);
+        u64 sum = 0;
+        clock timer;
+        clock_start(&timer);
+        for (u32 i = 0; i < scan_lookups; ++i) {
+            u64 key = (u64)(i * 7919u % size) * 0x9E3779B97F4A7C15ull;
+            sum += *scan_find(entries, key);
+        }
+        clock_update(&timer);
+        f64 scan_time = timer.elapsed / scan_lookups;
+
+        clock_start(&timer);
+        for (u32 i = 0; i < LOOKUPS; ++i) {
+            u64 key = (u64)(i * 7919u % size) * 0x9E3779B97F4A7C15ull;
+            sum += *(u64 *)hashmap_get_u64(&map, key);
+        }
+        clock_update(&timer);
+        f64 map_time = timer.elapsed / LOOKUPS;
+
+        KINFO("lookup among %u u64 keys: %.1f ns scanning a darray, %.1f ns "
+              "in the hashmap (checksum %llu)",
+              size, scan_time * 1e9, map_time * 1e9, sum);
+        darray_destroy(entries);
+        hashmap_destroy(&map);
+    }
+    return TRUE;
+}
+
+void hashmap_register_benchmarks() {
+    test_manager_register_test(hashmap_benchmark_against_scan,
+                               "hashmap: lookups against a darray scan");
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+void hashmap_register_tests();
+void hashmap_register_benchmarks();
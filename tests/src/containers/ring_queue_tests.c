@@ -0,0 +1,360 @@
+#include "ring_queue_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/ring_queue.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// Small enough to keep the queues full and empty most of the time, so the
+// wrap-around and full/empty paths are hit constantly
+#define QUEUE_CAPACITY 64
+#define SPSC_ITEMS 200000
+
+#define MPMC_PRODUCERS 4
+#define MPMC_CONSUMERS 4
+#define MPMC_ITEMS_PER_PRODUCER 50000
+
+static void *spsc_producer(void *arg) {
+    spsc_queue *queue = arg;
+    for (u64 i = 0; i < SPSC_ITEMS; ++i) {
+        while (!spsc_queue_push(queue, &i)) {
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+static b8 spsc_items_arrive_in_order() {
+    spsc_queue queue;
+    expect_true(spsc_queue_create(sizeof(u64), QUEUE_CAPACITY, &queue));
+
+    pthread_t producer;
+    expect_should_be(0, pthread_create(&producer, 0, spsc_producer, &queue));
+
+    b8 in_order = TRUE;
+    for (u64 expected = 0; expected < SPSC_ITEMS; ++expected) {
+        u64 value;
+        while (!spsc_queue_pop(&queue, &value)) {
+            sched_yield();
+        }
+        in_order = in_order && value == expected;
+    }
+    pthread_join(producer, 0);
+
+    u64 extra;
+    expect_true(in_order);
+    expect_true(!spsc_queue_pop(&queue, &extra));
+    spsc_queue_destroy(&queue);
+    return TRUE;
+}
+
+typedef struct mpmc_test {
+    mpmc_queue queue;
+    _Atomic u32 next_producer;
+    _Atomic u64 consumed;
+    _Atomic u64 sum;
+    _Atomic u32 errors;
+} mpmc_test;
+
+// Items carry their producer in the high bits and a sequence number in the
+// low bits
+static void *mpmc_producer(void *arg) {
+    mpmc_test *test = arg;
+    u64 producer = atomic_fetch_add(&test->next_producer, 1);
+    for (u64 i = 0; i < MPMC_ITEMS_PER_PRODUCER; ++i) {
+        u64 item = (producer << 32) | i;
+        while (!mpmc_queue_push(&test->queue, &item)) {
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+static void *mpmc_consumer(void *arg) {
+    mpmc_test *test = arg;
+    const u64 total = (u64)MPMC_PRODUCERS * MPMC_ITEMS_PER_PRODUCER;
+
+    // Each consumer must still see any one producer's items in order
+    i64 last_seen[MPMC_PRODUCERS];
+    for (u32 i = 0; i < MPMC_PRODUCERS; ++i) {
+        last_seen[i] = -1;
+    }
+
+    while (atomic_load(&test->consumed) < total) {
+        u64 item;
+        if (!mpmc_queue_pop(&test->queue, &item)) {
+            sched_yield();
+            continue;
+        }
+
+        u64 producer = item >> 32;
+        i64 sequence = (i64)(item & 0xFFFFFFFF);
+        if (producer >= MPMC_PRODUCERS || sequence <= last_seen[producer]) {
+            atomic_fetch_add(&test->errors, 1);
+        } else {
+            last_seen[producer] = sequence;
+        }
+        atomic_fetch_add(&test->sum, item & 0xFFFFFFFF);
+        atomic_fetch_add(&test->consumed, 1);
+    }
+    return 0;
+}
+
+static b8 mpmc_every_item_arrives_once() {
+    static mpmc_test test;
+    expect_true(mpmc_queue_create(sizeof(u64), QUEUE_CAPACITY, &test.queue));
+    atomic_store(&test.next_producer, 0);
+    atomic_store(&test.consumed, 0);
+    atomic_store(&test.sum, 0);
+    atomic_store(&test.errors, 0);
+
+    pthread_t threads[MPMC_PRODUCERS + MPMC_CONSUMERS];
+    for (u32 i = 0; i < MPMC_PRODUCERS + MPMC_CONSUMERS; ++i) {
+        expect_should_be(0, pthread_create(&threads[i], 0,
+                                           i < MPMC_PRODUCERS ? mpmc_producer
+                                                              : mpmc_consumer,
+                                           &test));
+    }
+    for (u32 i = 0; i < MPMC_PRODUCERS + MPMC_CONSUMERS; ++i) {
+        pthread_join(threads[i], 0);
+    }
+
+    // Every sequence number once per producer
+    u64 expected_sum = (u64)MPMC_PRODUCERS * MPMC_ITEMS_PER_PRODUCER *
+                       (MPMC_ITEMS_PER_PRODUCER - 1) / 2;
+    expect_should_be(0, atomic_load(&test.errors));
+    expect_should_be((u64)MPMC_PRODUCERS * MPMC_ITEMS_PER_PRODUCER,
+                     atomic_load(&test.consumed));
+    expect_should_be(expected_sum, atomic_load(&test.sum));
+
+    u64 extra;
+    expect_true(!mpmc_queue_pop(&test.queue, &extra));
+    mpmc_queue_destroy(&test.queue);
+    return TRUE;
+}
+
+void ring_queue_register_tests() {
+    test_manager_register_test(spsc_items_arrive_in_order,
+                               "spsc_queue: items arrive in order across "
+                               "threads");
+    test_manager_register_test(mpmc_every_item_arrives_once,
+                               "mpmc_queue: every item arrives once, in "
+                               "order per producer");
+}
+
+// What the lock-free queues are measured against: the same bounded ring
+// behind a mutex
+typedef struct locked_queue {
+    platform_mutex mutex;
+    u64 head;
+    u64 tail;
+    u64 capacity;
+    u64 *items;
+} locked_queue;
+
+static b8 locked_queue_push(locked_queue *queue, const u64 *value) {
+    platform_mutex_lock(&queue->mutex);
+    b8 pushed = queue->tail - queue->head < queue->capacity;
+    if (pushed) {
+        queue->items[queue->tail++ & (queue->capacity - 1)] = *value;
+    }
+    platform_mutex_unlock(&queue->mutex);
+    return pushed;
+}
+
+static b8 locked_queue_pop(locked_queue *queue, u64 *out_value) {
+    platform_mutex_lock(&queue->mutex);
+    b8 popped = queue->head != queue->tail;
+    if (popped) {
+        *out_value = queue->items[queue->head++ & (queue->capacity - 1)];
+    }
+    platform_mutex_unlock(&queue->mutex);
+    return popped;
+}
+
+typedef enum bench_queue_kind {
+    BENCH_QUEUE_SPSC,
+    BENCH_QUEUE_MPMC,
+    BENCH_QUEUE_LOCKED
+} bench_queue_kind;
+
+static const char *bench_queue_names[] = {"spsc_queue", "mpmc_queue",
+                                          "mutex ring"};
+
+// The three queues behind one interface
+typedef struct bench_queue {
+    spsc_queue spsc;
+    mpmc_queue mpmc;
+    locked_queue locked;
+    bench_queue_kind kind;
+    u64 items_per_producer;
+    _Atomic u64 sum;
+} bench_queue;
+
+#define BENCH_CAPACITY 1024
+#define BENCH_SINGLE_THREAD_ITEMS 4000000
+#define BENCH_THREADED_ITEMS 2000000
+
+static b8 bench_push(bench_queue *queue, const u64 *value) {
+    switch (queue->kind) {
+    case BENCH_QUEUE_SPSC:
+        return spsc_queue_push(&queue->spsc, value);
+    case BENCH_QUEUE_MPMC:
+        return mpmc_queue_push(&queue->mpmc, value);
+    default:
+        return locked_queue_push(&queue->locked, value);
+    }
+}
+
+static b8 bench_pop(bench_queue *queue, u64 *out_value) {
+    switch (queue->kind) {
+    case BENCH_QUEUE_SPSC:
+        return spsc_queue_pop(&queue->spsc, out_value);
+    case BENCH_QUEUE_MPMC:
+        return mpmc_queue_pop(&queue->mpmc, out_value);
+    default:
+        return locked_queue_pop(&queue->locked, out_value);
+    }
+}
+
+static b8 bench_queue_create(bench_queue *queue, bench_queue_kind kind) {
+    queue->kind = kind;
+    atomic_store(&queue->sum, 0);
+    switch (kind) {
+    case BENCH_QUEUE_SPSC:
+        return spsc_queue_create(sizeof(u64), BENCH_CAPACITY, &queue->spsc);
+    case BENCH_QUEUE_MPMC:
+        return mpmc_queue_create(sizeof(u64), BENCH_CAPACITY, &queue->mpmc);
+    default:
+        queue->locked.head = queue->locked.tail = 0;
+        queue->locked.capacity = BENCH_CAPACITY;
+        queue->locked.items =
+            kallocate(BENCH_CAPACITY * sizeof(u64), MEMORY_TAG_RING_QUEUE);
+        return platform_mutex_create(&queue->locked.mutex);
+    }
+}
+
+static void bench_queue_destroy(bench_queue *queue) {
+    switch (queue->kind) {
+    case BENCH_QUEUE_SPSC:
+        spsc_queue_destroy(&queue->spsc);
+        break;
+    case BENCH_QUEUE_MPMC:
+        mpmc_queue_destroy(&queue->mpmc);
+        break;
+    default:
+        platform_mutex_destroy(&queue->locked.mutex);
+        kfree(queue->locked.items, BENCH_CAPACITY * sizeof(u64),
+              MEMORY_TAG_RING_QUEUE);
+        break;
+    }
+}
+
+static void *bench_producer(void *arg) {
+    bench_queue *queue = arg;
+    for (u64 i = 0; i < queue->items_per_producer; ++i) {
+        while (!bench_push(queue, &i)) {
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+static void *bench_consumer(void *arg) {
+    bench_queue *queue = arg;
+    u64 sum = 0;
+    for (u64 i = 0; i < queue->items_per_producer; ++i) {
+        u64 value;
+        while (!bench_pop(queue, &value)) {
+            sched_yield();
+        }
+        sum += value;
+    }
+    atomic_fetch_add(&queue->sum, sum);
+    return 0;
+}
+
+// Pushes and pops on one thread, in bursts, so only the cost of the
+// operations themselves shows
+static f64 bench_single_thread(bench_queue *queue) {
+    u64 sum = 0;
+    f64 start = platform_get_absolute_time();
+    for (u64 i = 0; i < BENCH_SINGLE_THREAD_ITEMS; i += 64) {
+        for (u64 j = i; j < i + 64; ++j) {
+            bench_push(queue, &j);
+        }
+        for (u64 j = 0; j < 64; ++j) {
+            u64 value;
+            bench_pop(queue, &value);
+            sum += value;
+        }
+    }
+    f64 elapsed = platform_get_absolute_time() - start;
+    atomic_store(&queue->sum, sum);
+    return elapsed / BENCH_SINGLE_THREAD_ITEMS;
+}
+
+// Pairs of producer and consumer threads, each pair moving its share of the
+// items
+static f64 bench_threads(bench_queue *queue, u32 pairs) {
+    pthread_t threads[2 * MPMC_PRODUCERS];
+    queue->items_per_producer = BENCH_THREADED_ITEMS / pairs;
+    atomic_store(&queue->sum, 0);
+    f64 start = platform_get_absolute_time();
+    for (u32 i = 0; i < pairs; ++i) {
+        pthread_create(&threads[2 * i], 0, bench_producer, queue);
+        pthread_create(&threads[2 * i + 1], 0, bench_consumer, queue);
+    }
+    for (u32 i = 0; i < 2 * pairs; ++i) {
+        pthread_join(threads[i], 0);
+    }
+    f64 elapsed = platform_get_absolute_time() - start;
+    u64 n = queue->items_per_producer;
+    if (atomic_load(&queue->sum) != pairs * (n * (n - 1) / 2)) {
+        KERROR("%s lost or duplicated items", bench_queue_names[queue->kind]);
+        return 0;
+    }
+    return BENCH_THREADED_ITEMS / elapsed;
+}
+
+static b8 ring_queue_benchmark_throughput() {
+    static bench_queue queue;
+    KINFO("queue throughput, capacity %u, on %u cores:", BENCH_CAPACITY,
+          (u32)sysconf(_SC_NPROCESSORS_ONLN));
+    for (u32 kind = 0; kind <= BENCH_QUEUE_LOCKED; ++kind) {
+        expect_true(bench_queue_create(&queue, kind));
+        f64 single = bench_single_thread(&queue);
+        u64 single_sum = atomic_load(&queue.sum);
+        expect_should_be((u64)BENCH_SINGLE_THREAD_ITEMS *
+                             (BENCH_SINGLE_THREAD_ITEMS - 1) / 2,
+                         single_sum);
+
+        f64 one_pair = bench_threads(&queue, 1);
+        expect_true(one_pair > 0);
+        KINFO("  %s: %.1f ns per push and pop on one thread; %.2f M items/s "
+              "with 1 producer and 1 consumer",
+              bench_queue_names[kind], single * 1e9, one_pair / 1e6);
+        // Only the mpmc and locked queues take several of each side
+        if (kind != BENCH_QUEUE_SPSC) {
+            f64 four_pairs = bench_threads(&queue, MPMC_PRODUCERS);
+            expect_true(four_pairs > 0);
+            KINFO("  %s: %.2f M items/s with %u producers and %u consumers",
+                  bench_queue_names[kind], four_pairs / 1e6, MPMC_PRODUCERS,
+                  MPMC_CONSUMERS);
+        }
+        bench_queue_destroy(&queue);
+    }
+    return TRUE;
+}
+
+void ring_queue_register_benchmarks() {
+    test_manager_register_test(ring_queue_benchmark_throughput,
+                               "ring_queue: throughput against a mutex");
+}
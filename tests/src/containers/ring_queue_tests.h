@@ -0,0 +1,4 @@
+#pragma once
+
+void ring_queue_register_tests();
+void ring_queue_register_benchmarks();
@@ -0,0 +1,241 @@
+#include "slot_map_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/slot_map.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+
+static b8 slot_map_rejects_stale_handles() {
+    slot_map map;
+    expect_true(slot_map_create(sizeof(u64), 0, &map));
+    slot_handle none = {0};
+    expect_true(!slot_map_is_valid(&map, none));
+
+    u64 value = 7;
+    slot_handle first;
+    expect_true(slot_map_insert(&map, &value, &first));
+    expect_should_be(7, *(u64 *)slot_map_get(&map, first));
+
+    // Erasing makes the handle stale, and reusing its slot does not bring it
+    // back
+    expect_true(slot_map_erase(&map, first));
+    expect_true(!slot_map_is_valid(&map, first));
+    expect_true(!slot_map_get(&map, first));
+    expect_true(!slot_map_erase(&map, first));
+
+    value = 8;
+    slot_handle second;
+    expect_true(slot_map_insert(&map, &value, &second));
+    expect_should_be(first.index, second.index);
+    expect_true(first.generation != second.generation);
+    expect_true(!slot_map_get(&map, first));
+    expect_should_be(8, *(u64 *)slot_map_get(&map, second));
+
+    // Clearing makes every handle stale
+    slot_map_clear(&map);
+    expect_should_be(0, map.count);
+    expect_true(!slot_map_is_valid(&map, second));
+    slot_handle out_of_range = {map.capacity, 1};
+    expect_true(!slot_map_is_valid(&map, out_of_range));
+
+    slot_map_destroy(&map);
+    return TRUE;
+}
+
+static b8 slot_map_generation_wraps() {
+    slot_map map;
+    expect_true(slot_map_create(sizeof(u64), 0, &map));
+
+    // Take the first free slot to the last even generation, as if it had
+    // been reused 2^31 - 1 times
+    u32 index = map.free_head;
+    map.slots[index].generation = 0xFFFFFFFEu;
+
+    u64 value = 1;
+    slot_handle last;
+    expect_true(slot_map_insert(&map, &value, &last));
+    expect_should_be(index, last.index);
+    expect_should_be(0xFFFFFFFFu, last.generation);
+    expect_true(slot_map_is_valid(&map, last));
+
+    // Wrapping to 0 leaves the slot free, and the next value in it is
+    // generation 1. Neither matches the old handle
+    expect_true(slot_map_erase(&map, last));
+    expect_should_be(0, map.slots[index].generation);
+    slot_handle zero = {index, 0};
+    expect_true(!slot_map_is_valid(&map, zero));
+
+    slot_handle wrapped;
+    expect_true(slot_map_insert(&map, &value, &wrapped));
+    expect_should_be(index, wrapped.index);
+    expect_should_be(1, wrapped.generation);
+    expect_true(!slot_map_is_valid(&map, last));
+    expect_true(slot_map_is_valid(&map, wrapped));
+
+    slot_map_destroy(&map);
+    return TRUE;
+}
+
+#define DENSE_VALUES 100
+
+static b8 slot_map_dense_after_removals() {
+    slot_map map;
+    expect_true(slot_map_create(sizeof(u64), 0, &map));
+    slot_handle handles[DENSE_VALUES];
+    for (u64 i = 0; i < DENSE_VALUES; ++i) {
+        expect_true(slot_map_insert(&map, &i, &handles[i]));
+    }
+
+    // Erase every third value
+    u32 remaining = DENSE_VALUES;
+    for (u32 i = 0; i < DENSE_VALUES; i += 3) {
+        expect_true(slot_map_erase(&map, handles[i]));
+        remaining--;
+    }
+    expect_should_be(remaining, map.count);
+
+    // The values left are packed at the front, each once, and each maps
+    // back to the handle it was inserted with
+    b8 seen[DENSE_VALUES] = {0};
+    u64 *values = slot_map_values(&map);
+    for (u32 i = 0; i < map.count; ++i) {
+        u64 value = values[i];
+        expect_true(value < DENSE_VALUES);
+        expect_true(value % 3 != 0);
+        expect_true(!seen[value]);
+        seen[value] = TRUE;
+
+        slot_handle handle = slot_map_handle_at(&map, i);
+        expect_should_be(handles[value].index, handle.index);
+        expect_should_be(handles[value].generation, handle.generation);
+        expect_true(slot_map_get(&map, handle) == &values[i]);
+    }
+
+    // Values inserted later fill the free slots without disturbing the rest
+    for (u32 i = 0; i < DENSE_VALUES; i += 3) {
+        u64 value = i;
+        expect_true(slot_map_insert(&map, &value, &handles[i]));
+    }
+    expect_should_be(DENSE_VALUES, map.count);
+    for (u64 i = 0; i < DENSE_VALUES; ++i) {
+        expect_should_be(i, *(u64 *)slot_map_get(&map, handles[i]));
+    }
+
+    slot_map_destroy(&map);
+    return TRUE;
+}
+
+void slot_map_register_tests() {
+    test_manager_register_test(slot_map_rejects_stale_handles,
+                               "slot_map: stale handles are rejected");
+    test_manager_register_test(slot_map_generation_wraps,
+                               "slot_map: generations wrap safely");
+    test_manager_register_test(slot_map_dense_after_removals,
+                               "slot_map: values stay packed after "
+                               "removals");
+}
+
+// Roughly what a game object holds, one cache line
+typedef struct bench_object {
+    f32 position[4];
+    f32 velocity[4];
+    u64 padding[3];
+    struct bench_object *next;
+} bench_object;
+
+#define ITERATION_PASSES 8
+
+static u64 rng_state = 0x9E3779B97F4A7C15ull;
+
+static u64 next_random() {
+    // xorshift64, so runs are repeatable
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void update(bench_object *object) {
+    for (u32 i = 0; i < 4; ++i) {
+        object->position[i] += object->velocity[i];
+    }
+}
+
+static b8 slot_map_benchmark_iteration() {
+    u32 counts[] = {1024, 16384, 262144};
+    for (u32 c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        u32 count = counts[c];
+        bench_object object = {0};
+        object.velocity[0] = 1.0f;
+
+        slot_map map;
+        expect_true(slot_map_create(sizeof(bench_object), count, &map));
+        for (u32 i = 0; i < count; ++i) {
+            slot_handle handle;
+            expect_true(slot_map_insert(&map, &object, &handle));
+        }
+
+        // The layout the slot map replaces: each object allocated on its
+        // own and reached through the one before it, linked in a shuffled
+        // order as long-lived objects end up
+        bench_object **nodes =
+            kallocate(count * sizeof(bench_object *), MEMORY_TAG_ARRAY);
+        for (u32 i = 0; i < count; ++i) {
+            nodes[i] = kallocate(sizeof(bench_object), MEMORY_TAG_ARRAY);
+            *nodes[i] = object;
+        }
+        for (u32 i = count - 1; i > 0; --i) {
+            u32 j = (u32)(next_random() % (i + 1));
+            bench_object *swapped = nodes[i];
+            nodes[i] = nodes[j];
+            nodes[j] = swapped;
+        }
+        for (u32 i = 0; i + 1 < count; ++i) {
+            nodes[i]->next = nodes[i + 1];
+        }
+        nodes[count - 1]->next = 0;
+
+        clock timer;
+        clock_start(&timer);
+        for (u32 pass = 0; pass < ITERATION_PASSES; ++pass) {
+            bench_object *values = slot_map_values(&map);
+            for (u32 i = 0; i < map.count; ++i) {
+                update(&values[i]);
+            }
+        }
+        clock_update(&timer);
+        f64 dense_time = timer.elapsed / ((f64)count * ITERATION_PASSES);
+
+        clock_start(&timer);
+        for (u32 pass = 0; pass < ITERATION_PASSES; ++pass) {
+            for (bench_object *node = nodes[0]; node; node = node->next) {
+                update(node);
+            }
+        }
+        clock_update(&timer);
+        f64 chase_time = timer.elapsed / ((f64)count * ITERATION_PASSES);
+
+        // Both layouts moved every object the same distance
+        bench_object *first = slot_map_values(&map);
+        f32 dense_position = first->position[0];
+        KINFO("updating %u objects: %.2f ns each in a slot map, %.2f ns "
+              "chasing pointers (moved %.0f)",
+              count, dense_time * 1e9, chase_time * 1e9, dense_position);
+        expect_true(dense_position == nodes[0]->position[0]);
+
+        for (u32 i = 0; i < count; ++i) {
+            kfree(nodes[i], sizeof(bench_object), MEMORY_TAG_ARRAY);
+        }
+        kfree(nodes, count * sizeof(bench_object *), MEMORY_TAG_ARRAY);
+        slot_map_destroy(&map);
+    }
+    return TRUE;
+}
+
+void slot_map_register_benchmarks() {
+    test_manager_register_test(slot_map_benchmark_iteration,
+                               "slot_map: iteration against pointer chasing");
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+void slot_map_register_tests();
+void slot_map_register_benchmarks();
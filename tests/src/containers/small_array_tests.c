@@ -0,0 +1,111 @@
+#include "small_array_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/small_array.h>
+#include <core/kmemory.h>
+
+SMALL_ARRAY_DEFINE(test_small_array, u32, 4)
+
+static u64 array_tag_allocations() {
+    memory_tag_stats stats[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(stats);
+    return stats[MEMORY_TAG_ARRAY].allocation_count;
+}
+
+static u64 array_tag_bytes() {
+    memory_tag_stats stats[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(stats);
+    return stats[MEMORY_TAG_ARRAY].current_bytes;
+}
+
+static b8 small_array_stays_inline() {
+    u64 allocations_before = array_tag_allocations();
+
+    // A zeroed struct is an empty array
+    test_small_array array = {0};
+    expect_should_be(0, array.length);
+    expect_should_be(4, test_small_array_capacity(&array));
+
+    for (u32 i = 0; i < 4; ++i) {
+        test_small_array_push(&array, i * 10);
+    }
+    expect_should_be(4, array.length);
+    expect_true(array.heap == 0);
+    expect_true(test_small_array_data(&array) == array.inline_data);
+    for (u32 i = 0; i < 4; ++i) {
+        expect_should_be(i * 10, test_small_array_data(&array)[i]);
+    }
+
+    test_small_array_remove_at(&array, 1);
+    expect_should_be(3, array.length);
+    expect_should_be(0, array.inline_data[0]);
+    expect_should_be(20, array.inline_data[1]);
+    expect_should_be(30, array.inline_data[2]);
+
+    test_small_array_clear(&array);
+    expect_should_be(0, array.length);
+    test_small_array_destroy(&array);
+
+    // Filling the inline buffer never touched the allocator
+    expect_should_be(allocations_before, array_tag_allocations());
+    return TRUE;
+}
+
+static b8 small_array_spills_to_heap() {
+    u64 bytes_before = array_tag_bytes();
+
+    test_small_array array = {0};
+    for (u32 i = 0; i < 5; ++i) {
+        test_small_array_push(&array, i);
+    }
+    // The fifth element moves everything into a heap block of twice the size
+    expect_true(array.heap != 0);
+    expect_should_be(8, test_small_array_capacity(&array));
+    expect_should_be(5, array.length);
+    expect_should_be(bytes_before + 8 * sizeof(u32), array_tag_bytes());
+
+    for (u32 i = 5; i < 100; ++i) {
+        test_small_array_push(&array, i);
+    }
+    expect_should_be(100, array.length);
+    expect_should_be(128, test_small_array_capacity(&array));
+    for (u32 i = 0; i < 100; ++i) {
+        expect_should_be(i, test_small_array_data(&array)[i]);
+    }
+
+    // Removing keeps the order of the rest
+    test_small_array_remove_at(&array, 0);
+    test_small_array_remove_at(&array, 50);
+    expect_should_be(98, array.length);
+    u32 *data = test_small_array_data(&array);
+    expect_should_be(1, data[0]);
+    expect_should_be(50, data[49]);
+    expect_should_be(52, data[50]);
+    expect_should_be(99, data[97]);
+
+    // Clearing keeps the heap block for reuse; destroying frees it
+    test_small_array_clear(&array);
+    expect_should_be(128, test_small_array_capacity(&array));
+    test_small_array_destroy(&array);
+    expect_true(array.heap == 0);
+    expect_should_be(0, array.length);
+    expect_should_be(4, test_small_array_capacity(&array));
+    expect_should_be(bytes_before, array_tag_bytes());
+
+    // A destroyed array is empty and usable again
+    test_small_array_push(&array, 7);
+    expect_true(array.heap == 0);
+    expect_should_be(7, array.inline_data[0]);
+    test_small_array_destroy(&array);
+    return TRUE;
+}
+
+void small_array_register_tests() {
+    test_manager_register_test(small_array_stays_inline,
+                               "small_array: stays inline without allocating");
+    test_manager_register_test(small_array_spills_to_heap,
+                               "small_array: spills to the heap past its "
+                               "inline capacity");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void small_array_register_tests();
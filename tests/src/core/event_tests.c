@@ -0,0 +1,630 @@
+#include "event_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <core/event.h>
+#include <core/kmemory.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define POSTERS 3
+#define EVENTS_PER_POSTER 20000
+// Codes the posters spread their events over. The churning thread registers
+// on the first, so that code's listener run keeps growing and shrinking
+#define FIRST_CODE 400
+#define CODE_COUNT 3
+#define CHURN_LISTENERS 20
+
+typedef struct event_test {
+    _Atomic u64 sum;
+    _Atomic u64 churn_calls;
+    _Atomic u32 churn_rounds;
+    _Atomic u32 posters_done;
+    _Atomic u32 errors;
+    _Atomic u32 next_poster;
+} event_test;
+
+static event_test test;
+
+static b8 on_counted(u16 code, void *sender, void *listener,
+                     event_context context) {
+    atomic_fetch_add(&test.sum, context.data.u64[0]);
+    return FALSE;
+}
+
+static b8 on_churn(u16 code, void *sender, void *listener,
+                   event_context context) {
+    atomic_fetch_add(&test.churn_calls, 1);
+    return FALSE;
+}
+
+// Each poster sends the numbers 1 to EVENTS_PER_POSTER, offset so that every
+// event carries a different value
+static void *poster(void *arg) {
+    u64 base = atomic_fetch_add(&test.next_poster, 1) * EVENTS_PER_POSTER;
+    // Only start once the registry is churning
+    while (!atomic_load(&test.churn_rounds)) {
+        sched_yield();
+    }
+    for (u64 i = 1; i <= EVENTS_PER_POSTER; ++i) {
+        if (i % 64 == 0) {
+            sched_yield();
+        }
+        event_context context = {0};
+        context.data.u64[0] = base + i;
+        while (!event_post(FIRST_CODE + i % CODE_COUNT, 0, context)) {
+            sched_yield();
+        }
+    }
+    atomic_fetch_add(&test.posters_done, 1);
+    return 0;
+}
+
+// Registers and unregisters listeners, with mixed priorities, for as long as
+// events are being posted
+static void *churner(void *arg) {
+    while (atomic_load(&test.posters_done) < POSTERS) {
+        for (u64 i = 1; i <= CHURN_LISTENERS; ++i) {
+            if (!event_register_priority(FIRST_CODE, (void *)(i * 16),
+                                         on_churn, (i32)(i % 5) - 2)) {
+                atomic_fetch_add(&test.errors, 1);
+            }
+        }
+        sched_yield();
+        for (u64 i = 1; i <= CHURN_LISTENERS; ++i) {
+            if (!event_unregister(FIRST_CODE, (void *)(i * 16), on_churn)) {
+                atomic_fetch_add(&test.errors, 1);
+            }
+        }
+        atomic_fetch_add(&test.churn_rounds, 1);
+        sched_yield();
+    }
+    return 0;
+}
+
+static b8 event_post_survives_registry_churn() {
+    atomic_store(&test.sum, 0);
+    atomic_store(&test.churn_calls, 0);
+    atomic_store(&test.churn_rounds, 0);
+    atomic_store(&test.posters_done, 0);
+    atomic_store(&test.errors, 0);
+    atomic_store(&test.next_poster, 0);
+
+    expect_true(event_initialize());
+    for (u16 code = FIRST_CODE; code < FIRST_CODE + CODE_COUNT; ++code) {
+        expect_true(event_register(code, 0, on_counted));
+    }
+
+    pthread_t threads[POSTERS + 1];
+    for (u32 i = 0; i < POSTERS; ++i) {
+        expect_should_be(0, pthread_create(&threads[i], 0, poster, 0));
+    }
+    expect_should_be(0, pthread_create(&threads[POSTERS], 0, churner, 0));
+
+    // The main thread dispatches, as it does in the game loop
+    while (atomic_load(&test.posters_done) < POSTERS) {
+        event_dispatch_posted();
+        sched_yield();
+    }
+    for (u32 i = 0; i <= POSTERS; ++i) {
+        pthread_join(threads[i], 0);
+    }
+    // Events posted during the last dispatch wait for the next one
+    event_dispatch_posted();
+    event_dispatch_posted();
+
+    u64 events = (u64)POSTERS * EVENTS_PER_POSTER;
+    u64 expected_sum = events * (events + 1) / 2;
+    expect_should_be(0, atomic_load(&test.errors));
+    expect_should_be(expected_sum, atomic_load(&test.sum));
+    expect_true(atomic_load(&test.churn_rounds) > 1);
+
+    // Every churned listener is gone, and the counted ones are still there
+    u64 churn_calls = atomic_load(&test.churn_calls);
+    event_context context = {0};
+    context.data.u64[0] = 1;
+    expect_true(event_post(FIRST_CODE, 0, context));
+    event_dispatch_posted();
+    expect_should_be(expected_sum + 1, atomic_load(&test.sum));
+    expect_should_be(churn_calls, atomic_load(&test.churn_calls));
+
+    event_shutdown();
+    return TRUE;
+}
+
+// Registry tests record the order listeners are called in. Listeners are
+// small integers cast to pointers
+#define MAX_CALLS 64
+#define REGISTRY_CODE 500
+
+static u64 calls[MAX_CALLS];
+static u32 call_count;
+
+static b8 on_record(u16 code, void *sender, void *listener,
+                    event_context context) {
+    if (call_count < MAX_CALLS) {
+        calls[call_count++] = (u64)listener;
+    }
+    return FALSE;
+}
+
+// Unregisters the next listener up, then records itself
+static b8 on_unregister_next(u16 code, void *sender, void *listener,
+                             event_context context) {
+    event_unregister(code, (void *)((u64)listener + 1), on_record);
+    return on_record(code, sender, listener, context);
+}
+
+// Unregisters itself after its first event
+static b8 on_once(u16 code, void *sender, void *listener,
+                  event_context context) {
+    event_unregister(code, listener, on_once);
+    return on_record(code, sender, listener, context);
+}
+
+// Fires a code and checks which listeners were called, in order
+static b8 fire_calls(u16 code, const u64 *expected, u32 count) {
+    call_count = 0;
+    event_context context = {0};
+    event_fire(code, 0, context);
+    expect_should_be(count, call_count);
+    for (u32 i = 0; i < count; ++i) {
+        expect_should_be(expected[i], calls[i]);
+    }
+    return TRUE;
+}
+
+static b8 event_priority_order() {
+    expect_true(event_initialize());
+    // Higher priorities first, equal ones in registration order
+    expect_true(event_register(REGISTRY_CODE, (void *)1, on_record));
+    expect_true(
+        event_register_priority(REGISTRY_CODE, (void *)2, on_record, 5));
+    expect_true(event_register(REGISTRY_CODE, (void *)3, on_record));
+    expect_true(
+        event_register_priority(REGISTRY_CODE, (void *)4, on_record, -3));
+    expect_true(
+        event_register_priority(REGISTRY_CODE, (void *)5, on_record, 5));
+    // A listener is registered once per code
+    expect_true(!event_register(REGISTRY_CODE, (void *)3, on_record));
+
+    u64 expected[] = {2, 5, 1, 3, 4};
+    expect_true(fire_calls(REGISTRY_CODE, expected, 5));
+    event_shutdown();
+    return TRUE;
+}
+
+static b8 event_unregister_during_dispatch() {
+    expect_true(event_initialize());
+    expect_true(event_register_priority(REGISTRY_CODE, (void *)1,
+                                        on_unregister_next, 10));
+    expect_true(
+        event_register_priority(REGISTRY_CODE, (void *)2, on_record, 5));
+    expect_true(event_register(REGISTRY_CODE, (void *)3, on_record));
+
+    // Listener 2 is unregistered by 1 before its turn comes
+    u64 fired[] = {1, 3};
+    expect_true(fire_calls(REGISTRY_CODE, fired, 2));
+    expect_true(fire_calls(REGISTRY_CODE, fired, 2));
+
+    // Posted events reach each listener in turn; one that unregisters
+    // itself gets none of the batch's later events
+    expect_true(
+        event_register_priority(REGISTRY_CODE, (void *)4, on_once, -1));
+    event_context context = {0};
+    for (u32 i = 0; i < 3; ++i) {
+        expect_true(event_post(REGISTRY_CODE, 0, context));
+    }
+    call_count = 0;
+    event_dispatch_posted();
+    u64 posted[] = {1, 1, 1, 3, 3, 3, 4};
+    expect_should_be(7, call_count);
+    for (u32 i = 0; i < 7; ++i) {
+        expect_should_be(posted[i], calls[i]);
+    }
+    expect_true(fire_calls(REGISTRY_CODE, fired, 2));
+
+    event_shutdown();
+    return TRUE;
+}
+
+static b8 event_reregister_after_compaction() {
+    expect_true(event_initialize());
+    for (u64 i = 1; i <= 3; ++i) {
+        expect_true(event_register(REGISTRY_CODE, (void *)i, on_record));
+    }
+
+    // Unregistering leaves a tombstone, which the next registration on the
+    // code compacts away. The listener comes back last among its equals
+    expect_true(event_unregister(REGISTRY_CODE, (void *)2, on_record));
+    expect_true(!event_unregister(REGISTRY_CODE, (void *)2, on_record));
+    u64 without[] = {1, 3};
+    expect_true(fire_calls(REGISTRY_CODE, without, 2));
+    expect_true(event_register(REGISTRY_CODE, (void *)2, on_record));
+    u64 again[] = {1, 3, 2};
+    expect_true(fire_calls(REGISTRY_CODE, again, 3));
+
+    // Emptying the run and filling it again
+    for (u64 i = 1; i <= 3; ++i) {
+        expect_true(event_unregister(REGISTRY_CODE, (void *)i, on_record));
+    }
+    expect_true(fire_calls(REGISTRY_CODE, 0, 0));
+    expect_true(event_register(REGISTRY_CODE, (void *)3, on_record));
+    expect_true(
+        event_register_priority(REGISTRY_CODE, (void *)1, on_record, 1));
+    u64 refilled[] = {1, 3};
+    expect_true(fire_calls(REGISTRY_CODE, refilled, 2));
+
+    event_shutdown();
+    return TRUE;
+}
+
+static b8 event_runs_shift_when_earlier_code_grows() {
+    expect_true(event_initialize());
+    // Three runs, packed one after another in registration order
+    u16 a = REGISTRY_CODE, b = REGISTRY_CODE + 1, c = REGISTRY_CODE + 2;
+    expect_true(event_register(a, (void *)1, on_record));
+    expect_true(event_register(a, (void *)2, on_record));
+    expect_true(event_register(b, (void *)10, on_record));
+    expect_true(event_register(b, (void *)11, on_record));
+    expect_true(event_register(c, (void *)20, on_record));
+
+    // Growing the first run moves the two after it
+    expect_true(event_register_priority(a, (void *)3, on_record, 2));
+    expect_true(event_register_priority(a, (void *)4, on_record, -2));
+    expect_true(event_register(a, (void *)5, on_record));
+    u64 a_grown[] = {3, 1, 2, 5, 4};
+    u64 b_runs[] = {10, 11};
+    u64 c_runs[] = {20};
+    expect_true(fire_calls(a, a_grown, 5));
+    expect_true(fire_calls(b, b_runs, 2));
+    expect_true(fire_calls(c, c_runs, 1));
+
+    // Compacting it moves them back
+    expect_true(event_unregister(a, (void *)1, on_record));
+    expect_true(event_unregister(a, (void *)2, on_record));
+    expect_true(event_register(a, (void *)6, on_record));
+    u64 a_compacted[] = {3, 5, 6, 4};
+    expect_true(fire_calls(a, a_compacted, 4));
+    expect_true(fire_calls(b, b_runs, 2));
+    expect_true(fire_calls(c, c_runs, 1));
+
+    // Growing the middle run moves only the last one
+    expect_true(event_register_priority(b, (void *)12, on_record, 9));
+    u64 b_grown[] = {12, 10, 11};
+    expect_true(fire_calls(a, a_compacted, 4));
+    expect_true(fire_calls(b, b_grown, 3));
+    expect_true(fire_calls(c, c_runs, 1));
+
+    event_shutdown();
+    return TRUE;
+}
+
+// Coalescing tests record the values listeners receive, in calls[]
+static b8 on_value(u16 code, void *sender, void *listener,
+                   event_context context) {
+    if (call_count < MAX_CALLS) {
+        calls[call_count++] = context.data.u64[0];
+    }
+    return FALSE;
+}
+
+static void merge_sum(event_context *accumulated, event_context next) {
+    accumulated->data.u64[0] += next.data.u64[0];
+}
+
+// Posts the values 1 to count for a code
+static b8 post_values(u16 code, u64 count) {
+    for (u64 i = 1; i <= count; ++i) {
+        event_context context = {0};
+        context.data.u64[0] = i;
+        expect_true(event_post(code, 0, context));
+    }
+    return TRUE;
+}
+
+static b8 event_coalesce_last_value() {
+    expect_true(event_initialize());
+    expect_true(event_register(REGISTRY_CODE, 0, on_value));
+    expect_true(
+        event_set_coalescing(REGISTRY_CODE, EVENT_COALESCE_LAST_VALUE, 0));
+
+    call_count = 0;
+    expect_true(post_values(REGISTRY_CODE, 5));
+    event_dispatch_posted();
+    expect_should_be(1, call_count);
+    expect_should_be(5, calls[0]);
+    event_frame_stats stats = event_get_frame_stats();
+    expect_should_be(5, stats.posted);
+    expect_should_be(1, stats.dispatched);
+    expect_should_be(4, stats.coalesced);
+
+    // A lone event has nothing to coalesce with
+    call_count = 0;
+    expect_true(post_values(REGISTRY_CODE, 1));
+    event_dispatch_posted();
+    expect_should_be(1, call_count);
+    stats = event_get_frame_stats();
+    expect_should_be(1, stats.dispatched);
+    expect_should_be(0, stats.coalesced);
+
+    // Fired events are never coalesced
+    call_count = 0;
+    event_context context = {0};
+    event_fire(REGISTRY_CODE, 0, context);
+    event_fire(REGISTRY_CODE, 0, context);
+    expect_should_be(2, call_count);
+
+    event_shutdown();
+    return TRUE;
+}
+
+static b8 event_coalesce_accumulate() {
+    expect_true(event_initialize());
+    u16 summed = REGISTRY_CODE, each = REGISTRY_CODE + 1;
+    expect_true(event_register(summed, 0, on_value));
+    expect_true(event_register(each, 0, on_value));
+    // Accumulating needs something to merge with
+    expect_true(!event_set_coalescing(summed, EVENT_COALESCE_ACCUMULATE, 0));
+    expect_true(
+        event_set_coalescing(summed, EVENT_COALESCE_ACCUMULATE, merge_sum));
+
+    // Only the accumulating code is folded; the other is dispatched as is
+    call_count = 0;
+    expect_true(post_values(summed, 4));
+    expect_true(post_values(each, 3));
+    event_dispatch_posted();
+    u64 expected[] = {10, 1, 2, 3};
+    expect_should_be(4, call_count);
+    for (u32 i = 0; i < 4; ++i) {
+        expect_should_be(expected[i], calls[i]);
+    }
+    event_frame_stats stats = event_get_frame_stats();
+    expect_should_be(7, stats.posted);
+    expect_should_be(4, stats.dispatched);
+    expect_should_be(3, stats.coalesced);
+
+    // Turning it off again dispatches every event
+    expect_true(event_set_coalescing(summed, EVENT_COALESCE_NONE, 0));
+    call_count = 0;
+    expect_true(post_values(summed, 4));
+    event_dispatch_posted();
+    expect_should_be(4, call_count);
+    expect_should_be(0, event_get_frame_stats().coalesced);
+
+    event_shutdown();
+    return TRUE;
+}
+
+// Payload tests record where each payload landed and its first byte
+#define PAYLOAD_CODE 600
+#define MAX_PAYLOADS 64
+
+typedef struct received_payload {
+    u32 buffer;
+    u32 offset;
+    u32 size;
+    u8 first;
+} received_payload;
+
+static received_payload payloads[MAX_PAYLOADS];
+static u32 payload_count;
+
+static b8 on_payload(u16 code, void *sender, void *listener,
+                     event_context context) {
+    u32 size = 0;
+    const u8 *payload = event_payload(context, &size);
+    if (payload_count < MAX_PAYLOADS && payload) {
+        received_payload *received = &payloads[payload_count++];
+        received->buffer = context.data.u32[0];
+        received->offset = context.data.u32[1];
+        received->size = size;
+        received->first = payload[0];
+    }
+    return FALSE;
+}
+
+// Posts `size` bytes of `value` from the main thread
+static b8 post_filled(u8 value, u32 size) {
+    u8 payload[256];
+    kset_memory(payload, value, size);
+    return event_post_payload(PAYLOAD_CODE, 0, payload, size);
+}
+
+static b8 expect_payload(u32 index, u32 buffer, u32 offset, u8 first) {
+    expect_true(index < payload_count);
+    expect_should_be(buffer, payloads[index].buffer);
+    expect_should_be(offset, payloads[index].offset);
+    expect_should_be(first, payloads[index].first);
+    return TRUE;
+}
+
+static b8 event_payload_buffers_rotate() {
+    expect_true(event_initialize());
+    expect_true(event_register(PAYLOAD_CODE, 0, on_payload));
+
+    // Each dispatch moves posting on to the next buffer, which starts over
+    // from its beginning. Payloads are 16-byte aligned
+    payload_count = 0;
+    for (u8 frame = 0; frame < 2 * EVENT_PAYLOAD_BUFFER_COUNT; ++frame) {
+        expect_true(post_filled(frame, 20));
+        expect_true(post_filled(frame + 100, 1));
+        event_dispatch_posted();
+    }
+    expect_should_be(4 * EVENT_PAYLOAD_BUFFER_COUNT, payload_count);
+    for (u8 frame = 0; frame < 2 * EVENT_PAYLOAD_BUFFER_COUNT; ++frame) {
+        u32 buffer = frame % EVENT_PAYLOAD_BUFFER_COUNT;
+        expect_true(expect_payload(frame * 2, buffer, 0, frame));
+        expect_true(expect_payload(frame * 2 + 1, buffer, 32, frame + 100));
+        expect_should_be(20, payloads[frame * 2].size);
+        expect_should_be(1, payloads[frame * 2 + 1].size);
+    }
+
+    event_shutdown();
+    return TRUE;
+}
+
+static b8 event_payload_buffer_full() {
+    expect_true(event_initialize());
+    expect_true(event_register(PAYLOAD_CODE, 0, on_payload));
+
+    // Too big for any buffer
+    u8 *large = kallocate(EVENT_PAYLOAD_BUFFER_SIZE + 1, MEMORY_TAG_ARRAY);
+    expect_true(!event_post_payload(PAYLOAD_CODE, 0, large,
+                                    EVENT_PAYLOAD_BUFFER_SIZE + 1));
+
+    // Fills this frame's buffer exactly, after which even a byte is dropped
+    // and leaves the buffer as it was
+    u32 fill = EVENT_PAYLOAD_BUFFER_SIZE / 4;
+    for (u32 i = 0; i < 4; ++i) {
+        large[0] = (u8)i;
+        expect_true(event_post_payload(PAYLOAD_CODE, 0, large, fill));
+    }
+    expect_true(!post_filled(9, 1));
+    expect_true(!post_filled(9, 1));
+
+    payload_count = 0;
+    event_dispatch_posted();
+    expect_should_be(4, payload_count);
+    for (u32 i = 0; i < 4; ++i) {
+        expect_true(expect_payload(i, 0, i * fill, (u8)i));
+    }
+
+    // The next frame has a buffer of its own
+    expect_true(post_filled(9, 1));
+    payload_count = 0;
+    event_dispatch_posted();
+    expect_true(expect_payload(0, 1, 0, 9));
+
+    kfree(large, EVENT_PAYLOAD_BUFFER_SIZE + 1, MEMORY_TAG_ARRAY);
+    event_shutdown();
+    return TRUE;
+}
+
+// A payload post from another thread is held part way, after it has claimed
+// its place in a buffer, by copying from a page it cannot yet read. The fault
+// handler waits to be let go, then makes the page readable so the copy can
+// carry on
+typedef struct payload_stall {
+    u8 *page;
+    u64 page_size;
+    _Atomic u32 stalled;
+    _Atomic u32 resume;
+    _Atomic u32 posted;
+} payload_stall;
+
+static payload_stall stall;
+
+static void on_stall_fault(int signal, siginfo_t *info, void *context) {
+    u8 *address = info->si_addr;
+    if (address < stall.page || address >= stall.page + stall.page_size) {
+        // A genuine crash
+        sigaction(SIGSEGV, &(struct sigaction){.sa_handler = SIG_DFL}, 0);
+        return;
+    }
+    atomic_store(&stall.stalled, 1);
+    while (!atomic_load(&stall.resume)) {
+        sched_yield();
+    }
+    mprotect(stall.page, stall.page_size, PROT_READ);
+}
+
+static void *stalled_poster(void *arg) {
+    atomic_store(&stall.posted,
+                 event_post_payload(PAYLOAD_CODE, 0, stall.page, 32));
+    return 0;
+}
+
+static b8 event_payload_skips_pending_buffer() {
+    stall.page_size = (u64)sysconf(_SC_PAGESIZE);
+    stall.page = mmap(0, stall.page_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    expect_true(stall.page != MAP_FAILED);
+    kset_memory(stall.page, 0xAA, 32);
+    expect_should_be(0, mprotect(stall.page, stall.page_size, PROT_NONE));
+    atomic_store(&stall.stalled, 0);
+    atomic_store(&stall.resume, 0);
+    atomic_store(&stall.posted, 0);
+
+    struct sigaction handler = {0};
+    struct sigaction previous;
+    handler.sa_sigaction = on_stall_fault;
+    handler.sa_flags = SA_SIGINFO;
+    sigemptyset(&handler.sa_mask);
+    expect_should_be(0, sigaction(SIGSEGV, &handler, &previous));
+
+    expect_true(event_initialize());
+    expect_true(event_register(PAYLOAD_CODE, 0, on_payload));
+
+    // The stalled post holds the first 32 bytes of buffer 0
+    pthread_t thread;
+    expect_should_be(0, pthread_create(&thread, 0, stalled_poster, 0));
+    while (!atomic_load(&stall.stalled)) {
+        sched_yield();
+    }
+
+    // Posting moves on through buffers 1 and 2, then stays in 2 for as long
+    // as buffer 0 is referenced, carrying on where it left off
+    payload_count = 0;
+    for (u8 frame = 0; frame < 4; ++frame) {
+        expect_true(post_filled(frame, 16));
+        event_dispatch_posted();
+    }
+    expect_true(expect_payload(0, 0, 32, 0));
+    expect_true(expect_payload(1, 1, 0, 1));
+    expect_true(expect_payload(2, 2, 0, 2));
+    expect_true(expect_payload(3, 2, 16, 3));
+
+    // Once dispatched, the stalled payload frees buffer 0 for the frame after
+    atomic_store(&stall.resume, 1);
+    pthread_join(thread, 0);
+    expect_true(atomic_load(&stall.posted));
+    expect_true(post_filled(4, 16));
+    event_dispatch_posted();
+    expect_true(expect_payload(4, 2, 32, 4));
+    expect_true(expect_payload(5, 0, 0, 0xAA));
+    for (u8 frame = 5; frame < 7; ++frame) {
+        expect_true(post_filled(frame, 16));
+        event_dispatch_posted();
+    }
+    expect_true(expect_payload(6, 2, 48, 5));
+    expect_true(expect_payload(7, 0, 0, 6));
+    expect_should_be(8, payload_count);
+
+    event_shutdown();
+    sigaction(SIGSEGV, &previous, 0);
+    munmap(stall.page, stall.page_size);
+    return TRUE;
+}
+
+void event_register_tests() {
+    test_manager_register_test(event_post_survives_registry_churn,
+                               "event: posting from threads while another "
+                               "registers and unregisters");
+    test_manager_register_test(event_priority_order,
+                               "event: listeners are called by priority");
+    test_manager_register_test(event_unregister_during_dispatch,
+                               "event: unregistering during dispatch");
+    test_manager_register_test(event_reregister_after_compaction,
+                               "event: registering again after compaction");
+    test_manager_register_test(event_runs_shift_when_earlier_code_grows,
+                               "event: runs shift when an earlier code "
+                               "grows");
+    test_manager_register_test(event_coalesce_last_value,
+                               "event: coalescing keeps the last value");
+    test_manager_register_test(event_coalesce_accumulate,
+                               "event: coalescing accumulates values");
+    test_manager_register_test(event_payload_buffers_rotate,
+                               "event: payload buffers rotate each dispatch");
+    test_manager_register_test(event_payload_buffer_full,
+                               "event: payloads are dropped when the buffer "
+                               "is full");
+    test_manager_register_test(event_payload_skips_pending_buffer,
+                               "event: payload buffers still referenced are "
+                               "skipped");
+}
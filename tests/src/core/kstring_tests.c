@@ -0,0 +1,264 @@
+#include "kstring_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <core/clock.h>
+#include <core/kstring.h>
+#include <core/scratch_allocator.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#define SANITY_BUFFER_SIZE 222
+#define XXH_PRIME32 2654435761ull
+
+typedef struct hash_vector {
+    const char *text;
+    // Bytes of the sanity buffer, when there is no text
+    u32 length;
+    u64 seed;
+    u64 expected;
+} hash_vector;
+
+// Reference values from the xxHash project: its sanity checks, which hash
+// the start of a generated buffer, and a few well known strings
+static const hash_vector hash_vectors[] = {
+    {"", 0, 0, 0xEF46DB3751D8E999ull},
+    {"", 0, XXH_PRIME32, 0xAC75FDA2929B17EFull},
+    {"a", 0, 0, 0xD24EC4F1A98C6E5Bull},
+    {"abc", 0, 0, 0x44BC2CF5AD770999ull},
+    {"xxhash", 0, 20141025, 0xB559B98D844E0635ull},
+    {"Nobody inspects the spammish repetition", 0, 0, 0xFBCEA83C8A378BF1ull},
+    {0, 1, 0, 0xE934A84ADB052768ull},
+    {0, 1, XXH_PRIME32, 0x5014607643A9B4C3ull},
+    {0, 14, 0, 0x8282DCC4994E35C8ull},
+    {0, 14, XXH_PRIME32, 0xC3BD6BF63DEB6DF0ull},
+    {0, 222, 0, 0xB641AE8CB691C174ull},
+    {0, 222, XXH_PRIME32, 0x20CB8AB7AE10C14Aull},
+};
+
+static b8 hash_bytes_matches_xxhash64() {
+    // Filled the way xxHash's own sanity checks fill theirs
+    u8 sanity[SANITY_BUFFER_SIZE];
+    u64 generator = XXH_PRIME32;
+    for (u32 i = 0; i < SANITY_BUFFER_SIZE; ++i) {
+        sanity[i] = (u8)(generator >> 56);
+        generator *= 11400714785074694797ull;
+    }
+
+    u32 count = sizeof(hash_vectors) / sizeof(hash_vectors[0]);
+    for (u32 i = 0; i < count; ++i) {
+        const hash_vector *vector = &hash_vectors[i];
+        const void *data = vector->text ? (const void *)vector->text : sanity;
+        u64 length =
+            vector->text ? string_length(vector->text) : vector->length;
+        u64 hash = hash_bytes(data, length, vector->seed);
+        if (hash != vector->expected) {
+            KERROR("--> Vector %u: expected %016llx, but got %016llx.", i,
+                   vector->expected, hash);
+            return FALSE;
+        }
+    }
+
+    expect_should_be(hash_bytes("abc", 3, 0), string_hash("abc"));
+    expect_should_be(hash_bytes(0, 0, 0), string_hash(""));
+    return TRUE;
+}
+
+#define FORMAT_BUFFER_SIZE 256
+
+// Formats with both the builder and libc, which must agree
+static b8 expect_formats(const char *format, ...) {
+    char expected[FORMAT_BUFFER_SIZE];
+    char buffer[FORMAT_BUFFER_SIZE];
+    string_builder builder;
+    string_builder_init(&builder, buffer, FORMAT_BUFFER_SIZE);
+
+    va_list args;
+    va_start(args, format);
+    va_list libc_args;
+    va_copy(libc_args, args);
+    vsnprintf(expected, FORMAT_BUFFER_SIZE, format, libc_args);
+    va_end(libc_args);
+    string_builder_appendfv(&builder, format, args);
+    va_end(args);
+
+    const char *actual = string_builder_cstr(&builder);
+    if (!strings_equal(expected, actual)) {
+        KERROR("--> '%s': expected '%s', but got '%s'.", format, expected,
+               actual);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static b8 format_fixed_rounds_like_libc() {
+    // Exact ties round half to even; values a hair either side of a tie,
+    // such as 2.675, round the way they really fall
+    expect_true(expect_formats("%.0f %.0f %.0f %.0f", 0.5, 1.5, 2.5, -2.5));
+    expect_true(expect_formats("%.2f %.2f %.2f", 0.125, 0.375, -0.625));
+    expect_true(expect_formats("%.2f %.2f %.2f", 2.675, 1.005, 0.045));
+    expect_true(expect_formats("%.1f %.3f", 0.15, 1.0005));
+    // Rounding up carries into the integer part
+    expect_true(expect_formats("%.3f %.2f %.0f", 0.9999999, 99.995, 9.5));
+    expect_true(expect_formats("%+.4f % .4f %010.3f %-10.1f|", 3.14159,
+                               2.71828, -1.5, 0.25));
+
+    // Every tie a double holds exactly with up to 9 decimals, and the values
+    // between them
+    for (u32 precision = 0; precision <= 9; ++precision) {
+        for (u32 i = 0; i < 2048; ++i) {
+            f64 value = i / 1024.0 + (i & 1 ? 1e-7 : 0);
+            expect_true(expect_formats("%.*f", (i32)precision, value));
+            expect_true(expect_formats("%.*f", (i32)precision, i / 3.0));
+        }
+    }
+    return TRUE;
+}
+
+static b8 format_width_and_precision_arguments() {
+    // A precision reads no further than it allows, so the string need not
+    // be terminated
+    char unterminated[3] = {'a', 'b', 'c'};
+    expect_true(expect_formats("[%.*s]", 3, unterminated));
+    expect_true(expect_formats("[%.*s] [%.0s] [%.10s]", 2, "hello", "gone",
+                               "short"));
+    expect_true(expect_formats("[%8.3s] [%-8.3s]", "abcdef", "abcdef"));
+
+    // A negative `*` width left-aligns, and a negative `*` precision counts
+    // as none at all
+    expect_true(expect_formats("[%*d] [%*d]", -6, 42, 6, 42));
+    expect_true(expect_formats("[%*s] [%-*s]", -5, "ab", -5, "ab"));
+    expect_true(expect_formats("[%.*d] [%.*f] [%.*s]", -1, 7, -3, 1.5, -1,
+                               "all"));
+    expect_true(expect_formats("[%0*d] [%*.*f]", 5, -12, 8, 2, 3.14159));
+    return TRUE;
+}
+
+static b8 format_n_counts_this_call() {
+    char buffer[FORMAT_BUFFER_SIZE];
+    string_builder builder;
+    string_builder_init(&builder, buffer, FORMAT_BUFFER_SIZE);
+    string_builder_append(&builder, "before ");
+
+    // Counts what this call has appended, not what the builder holds
+    int at_start = -1, after_number = -1;
+    signed char narrow = -1;
+    long long wide = -1;
+    string_builder_appendf(&builder, "%nvalue %5d%n;%hhn %s%lln", &at_start,
+                           42, &after_number, &narrow, "end", &wide);
+    expect_should_be(0, at_start);
+    expect_should_be(11, after_number);
+    expect_should_be(12, narrow);
+    expect_should_be(16, wide);
+    expect_true(strings_equal("before value    42; end",
+                              string_builder_cstr(&builder)));
+    return TRUE;
+}
+
+static b8 format_hands_the_rest_to_libc() {
+    expect_true(expect_formats("%o %#o %#x %#X %#.3x", 8u, 8u, 255u, 255u,
+                               1u));
+    expect_true(expect_formats("%-8o| %08o %llo", 64u, 64u, 1ull << 40));
+    expect_true(expect_formats("%e %.3e %E %+12.2e|%-12e|", 12345.678,
+                               0.000123, 1e300, -2.5, 1.0));
+    expect_true(expect_formats("%g %g %g %G %10.4g|%#g", 100000.0, 1e6,
+                               0.0001, 1e-10, 3.14159, 2.0));
+    expect_true(expect_formats("%a %#.0f %Lf", 1.0, 3.0, (long double)2.5));
+    // Beyond fixed formatting: large values and high precisions
+    expect_true(expect_formats("%f %.12f %f", 1e20, 1.0 / 3.0, -1e18));
+    return TRUE;
+}
+
+static b8 format_pointers_like_libc() {
+    int local = 0;
+    expect_true(expect_formats("%p %p", (void *)0, (void *)&local));
+    expect_true(expect_formats("[%10p] [%-10p] [%010p]", (void *)0,
+                               (void *)0, (void *)0));
+    expect_true(expect_formats("[%20p] [%-20p]", (void *)&local,
+                               (void *)&local));
+    return TRUE;
+}
+
+void kstring_register_tests() {
+    test_manager_register_test(hash_bytes_matches_xxhash64,
+                               "kstring: hash_bytes matches xxHash64");
+    test_manager_register_test(format_fixed_rounds_like_libc,
+                               "kstring: fixed-point rounding matches libc");
+    test_manager_register_test(format_width_and_precision_arguments,
+                               "kstring: width and precision arguments");
+    test_manager_register_test(format_n_counts_this_call,
+                               "kstring: %n counts what the call appended");
+    test_manager_register_test(format_hands_the_rest_to_libc,
+                               "kstring: conversions handed to libc");
+    test_manager_register_test(format_pointers_like_libc,
+                               "kstring: %p matches libc, null included");
+}
+
+#define FORMAT_CALLS 1000000
+
+// A typical log line: a string, integers, a float and a pointer
+#define BENCH_FORMAT "%s: frame %u took %.3f ms (%d draws, %llu bytes, %p)"
+
+static b8 kstring_benchmark_builder_vs_snprintf() {
+    char buffer[FORMAT_BUFFER_SIZE];
+    u64 checksum = 0;
+    int local = 0;
+
+    clock timer;
+    clock_start(&timer);
+    for (u32 i = 0; i < FORMAT_CALLS; ++i) {
+        i32 length = snprintf(buffer, FORMAT_BUFFER_SIZE, BENCH_FORMAT,
+                              "renderer", i, i * 0.0167, (i32)(i % 977),
+                              (u64)i * 4096, (void *)&local);
+        checksum += length;
+    }
+    clock_update(&timer);
+    f64 snprintf_time = timer.elapsed / FORMAT_CALLS;
+
+    clock_start(&timer);
+    for (u32 i = 0; i < FORMAT_CALLS; ++i) {
+        string_builder builder;
+        string_builder_init(&builder, buffer, FORMAT_BUFFER_SIZE);
+        string_builder_appendf(&builder, BENCH_FORMAT, "renderer", i,
+                               i * 0.0167, (i32)(i % 977), (u64)i * 4096,
+                               (void *)&local);
+        checksum += builder.length;
+    }
+    clock_update(&timer);
+    f64 builder_time = timer.elapsed / FORMAT_CALLS;
+
+    // The same line built from appends, on the scratch stack
+    clock_start(&timer);
+    for (u32 i = 0; i < FORMAT_CALLS; ++i) {
+        scratch_marker marker = scratch_begin();
+        string_builder builder;
+        string_builder_init_scratch(&builder, 64);
+        string_builder_append(&builder, "renderer: frame ");
+        string_builder_append_u64(&builder, i);
+        string_builder_append(&builder, " took ");
+        string_builder_append_f64(&builder, i * 0.0167, 3);
+        string_builder_append(&builder, " ms (");
+        string_builder_append_i64(&builder, i % 977);
+        string_builder_append(&builder, " draws, ");
+        string_builder_append_u64(&builder, (u64)i * 4096);
+        string_builder_append(&builder, " bytes, 0x");
+        string_builder_append_hex(&builder, (u64)&local, 0);
+        string_builder_append_char(&builder, ')');
+        checksum += builder.length;
+        scratch_end(marker);
+    }
+    clock_update(&timer);
+    f64 append_time = timer.elapsed / FORMAT_CALLS;
+
+    KINFO("formatting a log line: %.1f ns with snprintf, %.1f ns with "
+          "string_builder_appendf, %.1f ns with appends (checksum %llu)",
+          snprintf_time * 1e9, builder_time * 1e9, append_time * 1e9,
+          checksum);
+    return TRUE;
+}
+
+void kstring_register_benchmarks() {
+    test_manager_register_test(kstring_benchmark_builder_vs_snprintf,
+                               "kstring: string builder against snprintf");
+}
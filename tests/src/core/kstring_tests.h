@@ -0,0 +1,4 @@
+#pragma once
+
+void kstring_register_tests();
+void kstring_register_benchmarks();
@@ -0,0 +1,168 @@
+#include "recorder_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <core/event.h>
+#include <core/input.h>
+#include <core/kmemory.h>
+#include <core/recorder.h>
+#include <math.h>
+#include <platform/platform.h>
+#include <stdio.h>
+
+#define LOG_PATH "recorder_test.krec"
+
+// Mirrors the header recorder.c writes ahead of the entries
+typedef struct test_log_header {
+    u32 magic;
+    u16 version;
+    u16 entry_size;
+} test_log_header;
+
+#define TEST_LOG_MAGIC 0x4345524Bu
+#define TEST_LOG_VERSION 2
+#define MAX_TEST_ENTRIES 4
+
+// Writes a log by hand: a header, then the entries, then `trailing` bytes of
+// a partly written entry
+static b8 write_log(u16 version, const recorder_entry *entries, u32 count,
+                    u32 trailing) {
+    u8 log[sizeof(test_log_header) +
+           (MAX_TEST_ENTRIES + 1) * sizeof(recorder_entry)] = {0};
+    test_log_header header = {TEST_LOG_MAGIC, version, sizeof(recorder_entry)};
+    kcopy_memory(log, &header, sizeof(header));
+    kcopy_memory(log + sizeof(header), entries,
+                 count * sizeof(recorder_entry));
+    u64 size = sizeof(header) + count * sizeof(recorder_entry) + trailing;
+    return platform_write_file(LOG_PATH, log, size);
+}
+
+static recorder_entry frame_entry(f32 delta_time) {
+    recorder_entry entry = {0};
+    entry.type = RECORDER_ENTRY_FRAME;
+    entry.delta_time = delta_time;
+    return entry;
+}
+
+static b8 recorder_round_trip() {
+    expect_true(event_initialize());
+    input_initialize();
+
+    expect_true(recorder_start_recording(LOG_PATH));
+    // Already in use
+    expect_true(!recorder_start_replay(LOG_PATH));
+    input_process_key(KEY_A, TRUE);
+    input_process_button(BUTTON_RIGHT, TRUE);
+    input_process_mouse_move(120, -40);
+    recorder_end_frame(0.016f);
+    // A suspended frame with nothing in it is not recorded
+    recorder_end_suspended_frame();
+    input_process_key(KEY_A, FALSE);
+    input_process_mouse_wheel(-3);
+    recorder_end_frame(0.02f);
+    // Input from a frame that never ended is dropped
+    input_process_key(KEY_B, TRUE);
+    recorder_shutdown();
+    event_dispatch_posted();
+
+    // Replay into fresh input state
+    input_initialize();
+    expect_true(recorder_start_replay(LOG_PATH));
+    expect_true(recorder_is_replaying());
+    f32 delta_time = 0;
+    expect_true(recorder_replay_frame(&delta_time));
+    expect_true(delta_time == 0.016f);
+    expect_true(input_is_key_down(KEY_A));
+    expect_true(input_is_button_down(BUTTON_RIGHT));
+    i32 x = 0, y = 0;
+    input_get_mouse_position(&x, &y);
+    expect_should_be(120, x);
+    expect_should_be(-40, y);
+
+    expect_true(recorder_replay_frame(&delta_time));
+    expect_true(delta_time == 0.02f);
+    expect_true(input_is_key_up(KEY_A));
+    expect_true(!recorder_replay_frame(&delta_time));
+    expect_true(input_is_key_up(KEY_B));
+    recorder_shutdown();
+    expect_true(!recorder_is_replaying());
+
+    input_shutdown();
+    event_shutdown();
+    remove(LOG_PATH);
+    return TRUE;
+}
+
+static b8 recorder_rejects_bad_logs() {
+    recorder_entry entries[MAX_TEST_ENTRIES];
+    entries[0] = frame_entry(0.016f);
+    entries[1] = frame_entry(0.016f);
+
+    // The hand written log itself replays
+    expect_true(write_log(TEST_LOG_VERSION, entries, 2, 0));
+    expect_true(recorder_start_replay(LOG_PATH));
+    recorder_shutdown();
+
+    expect_true(write_log(TEST_LOG_VERSION + 1, entries, 2, 0));
+    expect_true(!recorder_start_replay(LOG_PATH));
+
+    // Any bad entry rejects the whole log, wherever it is
+    entries[1].type = RECORDER_ENTRY_RESIZE + 1;
+    expect_true(write_log(TEST_LOG_VERSION, entries, 2, 0));
+    expect_true(!recorder_start_replay(LOG_PATH));
+
+    entries[1] = frame_entry(-0.016f);
+    expect_true(write_log(TEST_LOG_VERSION, entries, 2, 0));
+    expect_true(!recorder_start_replay(LOG_PATH));
+
+    entries[1] = frame_entry(NAN);
+    expect_true(write_log(TEST_LOG_VERSION, entries, 2, 0));
+    expect_true(!recorder_start_replay(LOG_PATH));
+
+    entries[1] = frame_entry(0.016f);
+    entries[1].type = RECORDER_ENTRY_KEY;
+    entries[1].code = KEYS_MAX_KEYS;
+    expect_true(write_log(TEST_LOG_VERSION, entries, 2, 0));
+    expect_true(!recorder_start_replay(LOG_PATH));
+
+    // Too short to hold a header
+    test_log_header header = {TEST_LOG_MAGIC, TEST_LOG_VERSION,
+                              sizeof(recorder_entry)};
+    expect_true(platform_write_file(LOG_PATH, &header, sizeof(header) - 1));
+    expect_true(!recorder_start_replay(LOG_PATH));
+    expect_true(!recorder_is_replaying());
+
+    remove(LOG_PATH);
+    return TRUE;
+}
+
+// A log cut short by a crash loses its partly written last entry, and
+// replays up to it
+static b8 recorder_replays_truncated_log() {
+    recorder_entry entries[MAX_TEST_ENTRIES];
+    entries[0] = frame_entry(0.016f);
+    entries[1] = frame_entry(0.02f);
+    expect_true(write_log(TEST_LOG_VERSION, entries, 2, 7));
+
+    expect_true(recorder_start_replay(LOG_PATH));
+    f32 delta_time = 0;
+    expect_true(recorder_replay_frame(&delta_time));
+    expect_true(recorder_replay_frame(&delta_time));
+    expect_true(delta_time == 0.02f);
+    expect_true(!recorder_replay_frame(&delta_time));
+    recorder_shutdown();
+
+    remove(LOG_PATH);
+    return TRUE;
+}
+
+void recorder_register_tests() {
+    test_manager_register_test(recorder_round_trip,
+                               "recorder: a recording replays the same input");
+    test_manager_register_test(recorder_rejects_bad_logs,
+                               "recorder: invalid logs are rejected");
+    test_manager_register_test(recorder_replays_truncated_log,
+                               "recorder: a truncated log replays up to its "
+                               "last whole entry");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void recorder_register_tests();
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <core/logger.h>
+
+// Each test returns TRUE on success. These log the failed check along with
+// where it is and end the test
+
+#define expect_true(expr)                                                      \
+    if (!(expr)) {                                                             \
+        KERROR("--> Expected '%s' to be true, at %s:%d.", #expr, __FILE__,     \
+               __LINE__);                                                      \
+        return FALSE;                                                          \
+    }
+
+#define expect_should_be(expected, actual)                                     \
+    if ((expected) != (actual)) {                                              \
+        KERROR("--> Expected %lld, but got %lld, at %s:%d.",                   \
+               (long long)(expected), (long long)(actual), __FILE__,           \
+               __LINE__);                                                      \
+        return FALSE;                                                          \
+    }
@@ -0,0 +1,53 @@
+#include "test_manager.h"
+
+#include "containers/bitset_tests.h"
+#include "containers/darray_tests.h"
+#include "containers/hashmap_tests.h"
+#include "containers/ring_queue_tests.h"
+#include "containers/slot_map_tests.h"
+#include "containers/small_array_tests.h"
+#include "core/event_tests.h"
+#include "core/kstring_tests.h"
+#include "core/recorder_tests.h"
+#include "memory/kmemory_tests.h"
+#include "memory/memory_profiler_tests.h"
+#include "memory/scratch_tests.h"
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+
+int main(int argc, char **argv) {
+    initialize_memory();
+    test_manager_init();
+
+    // Benchmarks only report timings and take a while, so they run instead
+    // of the tests when asked for with --bench
+    if (argc > 1 && strings_equal(argv[1], "--bench")) {
+        kmemory_register_benchmarks();
+        darray_register_benchmarks();
+        hashmap_register_benchmarks();
+        slot_map_register_benchmarks();
+        ring_queue_register_benchmarks();
+        kstring_register_benchmarks();
+    } else {
+        kmemory_register_tests();
+        scratch_register_tests();
+        memory_profiler_register_tests();
+        ring_queue_register_tests();
+        event_register_tests();
+        recorder_register_tests();
+        kstring_register_tests();
+        darray_register_tests();
+        hashmap_register_tests();
+        bitset_register_tests();
+        slot_map_register_tests();
+        small_array_register_tests();
+    }
+
+    KDEBUG("Starting tests...");
+    u32 failed = test_manager_run_tests();
+
+    shutdown_memory();
+    return failed ? 1 : 0;
+}
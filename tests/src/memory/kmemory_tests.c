@@ -0,0 +1,615 @@
+#include "kmemory_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <core/pool_allocator.h>
+#include <core/scratch_allocator.h>
+#include <core/tlsf_allocator.h>
+#include <linux/perf_event.h>
+#include <malloc.h>
+#include <platform/platform.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+typedef struct test_block {
+    u8 *memory;
+    u64 size;
+    u64 alignment;
+    u8 pattern;
+} test_block;
+
+#define MAX_BLOCKS 512
+
+static u64 rng_state = 0x9E3779B97F4A7C15ull;
+
+static u64 next_random() {
+    // xorshift64, so runs are repeatable
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Fills a block with its own pattern. Any overlap between live blocks shows
+// up as a wrong byte when the other block is checked
+static void fill_block(test_block *block) {
+    kset_memory(block->memory, block->pattern, block->size);
+}
+
+static b8 block_intact(const test_block *block) {
+    for (u64 i = 0; i < block->size; ++i) {
+        if (block->memory[i] != block->pattern) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static b8 is_aligned(const void *memory, u64 alignment) {
+    return ((u64)memory & (alignment - 1)) == 0;
+}
+
+static b8 kmemory_random_aligned_blocks() {
+    test_block blocks[MAX_BLOCKS] = {0};
+
+    for (u32 i = 0; i < 20000; ++i) {
+        test_block *block = &blocks[next_random() % MAX_BLOCKS];
+        if (block->memory) {
+            expect_true(block_intact(block));
+            kfree_aligned(block->memory, block->size, block->alignment,
+                          MEMORY_TAG_ARRAY);
+            block->memory = 0;
+            continue;
+        }
+
+        block->size = 1 + next_random() % (64 * 1024);
+        block->alignment = 1ull << (next_random() % 13);
+        block->pattern = (u8)(1 + i % 255);
+        block->memory =
+            kallocate_aligned(block->size, block->alignment, MEMORY_TAG_ARRAY);
+        expect_true(block->memory != 0);
+        expect_true(is_aligned(block->memory, block->alignment));
+        // kallocate_aligned zeroes the block
+        expect_should_be(0, block->memory[0]);
+        expect_should_be(0, block->memory[block->size - 1]);
+        fill_block(block);
+    }
+
+    for (u32 i = 0; i < MAX_BLOCKS; ++i) {
+        if (blocks[i].memory) {
+            expect_true(block_intact(&blocks[i]));
+            kfree_aligned(blocks[i].memory, blocks[i].size,
+                          blocks[i].alignment, MEMORY_TAG_ARRAY);
+        }
+    }
+    return TRUE;
+}
+
+static b8 kmemory_heap_exhaustion_falls_back() {
+    // Enough blocks just under the large allocation size to fill the heap,
+    // so the rest come from the platform, both plain and over-aligned
+    u64 size = KMEMORY_LARGE_ALLOCATION_SIZE - 4096;
+    u32 count = (u32)(KMEMORY_HEAP_SIZE / size) + 8;
+    expect_true(count <= MAX_BLOCKS);
+
+    test_block blocks[MAX_BLOCKS] = {0};
+    for (u32 i = 0; i < count; ++i) {
+        test_block *block = &blocks[i];
+        block->size = size;
+        block->alignment = i % 2 ? 256 : 1;
+        block->pattern = (u8)(1 + i);
+        block->memory =
+            kallocate_aligned(block->size, block->alignment, MEMORY_TAG_ARRAY);
+        expect_true(block->memory != 0);
+        expect_true(is_aligned(block->memory, block->alignment));
+        fill_block(block);
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        expect_true(block_intact(&blocks[i]));
+        kfree_aligned(blocks[i].memory, blocks[i].size, blocks[i].alignment,
+                      MEMORY_TAG_ARRAY);
+    }
+    return TRUE;
+}
+
+static b8 tlsf_fragmentation_and_coalescing() {
+    tlsf_allocator allocator;
+    expect_true(tlsf_allocator_create(1024 * 1024, 0, &allocator));
+    u64 initial_largest = tlsf_allocator_largest_free_block(&allocator);
+
+    test_block blocks[MAX_BLOCKS] = {0};
+    u32 failures = 0;
+    for (u32 i = 0; i < 50000; ++i) {
+        test_block *block = &blocks[next_random() % MAX_BLOCKS];
+        if (block->memory) {
+            expect_true(block_intact(block));
+            tlsf_allocator_free(&allocator, block->memory);
+            block->memory = 0;
+            continue;
+        }
+
+        // Mostly small blocks with the odd large one, at alignments that
+        // force the aligned path to split off a leading gap
+        block->size = next_random() % 8 ? 1 + next_random() % 512
+                                        : 1 + next_random() % (32 * 1024);
+        block->alignment = 1ull << (next_random() % 12);
+        block->pattern = (u8)(1 + i % 255);
+        block->memory = tlsf_allocator_allocate_aligned(
+            &allocator, block->size, block->alignment);
+        if (!block->memory) {
+            // The pool can run out; that is fine as long as it recovers
+            failures++;
+            continue;
+        }
+        expect_true(tlsf_allocator_owns(&allocator, block->memory));
+        expect_true(is_aligned(block->memory, block->alignment));
+        fill_block(block);
+    }
+
+    for (u32 i = 0; i < MAX_BLOCKS; ++i) {
+        if (blocks[i].memory) {
+            expect_true(block_intact(&blocks[i]));
+            tlsf_allocator_free(&allocator, blocks[i].memory);
+        }
+    }
+
+    // Everything freed must have merged back into one block
+    expect_should_be(initial_largest,
+                     tlsf_allocator_largest_free_block(&allocator));
+    expect_true(failures < 50000 / 2);
+    tlsf_allocator_destroy(&allocator);
+    return TRUE;
+}
+
+#define STATS_THREADS 8
+#define STATS_ITERATIONS 20000
+// Allocations each thread leaves live when it exits
+#define STATS_LIVE_BLOCKS 16
+#define STATS_LIVE_SIZE 48
+
+typedef struct stats_thread {
+    pthread_t thread;
+    u32 index;
+    void *live[STATS_LIVE_BLOCKS];
+} stats_thread;
+
+static void *stats_thread_main(void *arg) {
+    stats_thread *thread = arg;
+    for (u32 i = 0; i < STATS_ITERATIONS; ++i) {
+        u64 size = 1 + i % 200;
+        void *block = kallocate(size, MEMORY_TAG_JOB);
+        kfree(block, size, MEMORY_TAG_JOB);
+
+        // Scratch commits pages as it grows, and releases its reservation
+        // only when the thread exits, after the thread's other exit handlers
+        scratch_marker marker = scratch_begin();
+        u8 *scratch = scratch_allocate(size * 1024);
+        if (scratch) {
+            scratch[size * 1024 - 1] = 1;
+        }
+        scratch_end(marker);
+    }
+    for (u32 i = 0; i < STATS_LIVE_BLOCKS; ++i) {
+        thread->live[i] = kallocate(STATS_LIVE_SIZE, MEMORY_TAG_JOB);
+    }
+    // Logging formats into the scratch stack too
+    KDEBUG("Stats thread %u done.", thread->index);
+    return 0;
+}
+
+static b8 kmemory_threaded_stats_match() {
+    memory_tag_stats before[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(before);
+
+    stats_thread threads[STATS_THREADS];
+    for (u32 i = 0; i < STATS_THREADS; ++i) {
+        threads[i].index = i;
+        expect_should_be(0, pthread_create(&threads[i].thread, 0,
+                                           stats_thread_main, &threads[i]));
+    }
+    for (u32 i = 0; i < STATS_THREADS; ++i) {
+        pthread_join(threads[i].thread, 0);
+    }
+
+    // The threads have exited, but their shards' counts must remain
+    memory_tag_stats after[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(after);
+    memory_tag_stats *b = &before[MEMORY_TAG_JOB];
+    memory_tag_stats *a = &after[MEMORY_TAG_JOB];
+    expect_should_be(STATS_THREADS * (STATS_ITERATIONS + STATS_LIVE_BLOCKS),
+                     a->allocation_count - b->allocation_count);
+    expect_should_be(STATS_THREADS * STATS_ITERATIONS,
+                     a->free_count - b->free_count);
+    expect_should_be(STATS_THREADS * STATS_LIVE_BLOCKS * STATS_LIVE_SIZE,
+                     a->current_bytes - b->current_bytes);
+
+    // Every thread's scratch stack was released as it exited
+    memory_tag_stats *scratch_before = &before[MEMORY_TAG_SCRATCH];
+    memory_tag_stats *scratch_after = &after[MEMORY_TAG_SCRATCH];
+    expect_should_be(scratch_before->current_bytes,
+                     scratch_after->current_bytes);
+    expect_should_be(
+        scratch_after->allocation_count - scratch_before->allocation_count,
+        scratch_after->free_count - scratch_before->free_count);
+
+    // Freed from another thread than the one that allocated them
+    for (u32 i = 0; i < STATS_THREADS; ++i) {
+        for (u32 j = 0; j < STATS_LIVE_BLOCKS; ++j) {
+            kfree(threads[i].live[j], STATS_LIVE_SIZE, MEMORY_TAG_JOB);
+        }
+    }
+    memory_get_tag_stats(after);
+    expect_should_be(b->current_bytes, a->current_bytes);
+    expect_should_be(a->allocation_count - b->allocation_count,
+                     a->free_count - b->free_count);
+    return TRUE;
+}
+
+#define POOL_THREADS 4
+#define POOL_REPORTS 200
+
+static atomic_bool pools_stop;
+
+// Creates and destroys pools while another thread builds the report. A
+// pool's own counters belong to the thread using it, so these stay unused
+static void *pool_thread_main(void *arg) {
+    (void)arg;
+    while (!atomic_load(&pools_stop)) {
+        pool_allocator pool;
+        pool_allocator_create("churn", 32, 8, MEMORY_TAG_JOB, &pool);
+        sched_yield();
+        pool_allocator_destroy(&pool);
+    }
+    return 0;
+}
+
+static b8 kmemory_pools_register_during_report() {
+    pool_allocator kept;
+    pool_allocator_create("kept", 64, 4, MEMORY_TAG_JOB, &kept);
+
+    pthread_t threads[POOL_THREADS];
+    atomic_store(&pools_stop, FALSE);
+    for (u32 i = 0; i < POOL_THREADS; ++i) {
+        expect_should_be(
+            0, pthread_create(&threads[i], 0, pool_thread_main, 0));
+    }
+    for (u32 i = 0; i < POOL_REPORTS; ++i) {
+        scratch_marker marker = scratch_begin();
+        expect_true(strstr(get_memory_usage_str(), "Pool 'kept'") != 0);
+        scratch_end(marker);
+        sched_yield();
+    }
+    atomic_store(&pools_stop, TRUE);
+    for (u32 i = 0; i < POOL_THREADS; ++i) {
+        pthread_join(threads[i], 0);
+    }
+
+    // Every churned pool unregistered, leaving only the one still alive
+    scratch_marker marker = scratch_begin();
+    char *report = get_memory_usage_str();
+    expect_true(strstr(report, "Pool 'kept'") != 0);
+    expect_true(strstr(report, "Pool 'churn'") == 0);
+    scratch_end(marker);
+
+    pool_allocator_destroy(&kept);
+    return TRUE;
+}
+
+void kmemory_register_tests() {
+    test_manager_register_test(kmemory_random_aligned_blocks,
+                               "kmemory: random aligned allocations do not "
+                               "overlap");
+    test_manager_register_test(kmemory_heap_exhaustion_falls_back,
+                               "kmemory: a full heap falls back to the "
+                               "platform");
+    test_manager_register_test(kmemory_threaded_stats_match,
+                               "kmemory: stats merged across threads are "
+                               "exact");
+    test_manager_register_test(kmemory_pools_register_during_report,
+                               "kmemory: pools register while the report is "
+                               "read");
+    test_manager_register_test(tlsf_fragmentation_and_coalescing,
+                               "tlsf: fragmentation and coalescing");
+}
+
+#define CHURN_OPERATIONS 200000
+#define CHURN_SLOTS 4096
+#define CHURN_POOL_SIZE (64 * 1024 * 1024)
+
+// Mostly small blocks, some medium and a few large, as a game's heap sees
+static u64 churn_size() {
+    u64 kind = next_random() % 100;
+    if (kind < 75) {
+        return 16 + next_random() % 240;
+    }
+    if (kind < 95) {
+        return 256 + next_random() % 3840;
+    }
+    return 4096 + next_random() % (60 * 1024);
+}
+
+typedef struct churn_result {
+    // Seconds per operation, sorted
+    f64 *allocate_times;
+    f64 *free_times;
+    u32 allocations;
+    u32 frees;
+    u32 failures;
+    // Bytes the caller asked for that are still live at the end
+    u64 live_bytes;
+} churn_result;
+
+static int compare_f64(const void *a, const void *b) {
+    f64 x = *(const f64 *)a;
+    f64 y = *(const f64 *)b;
+    return (x > y) - (x < y);
+}
+
+// Runs the same random allocate/free sequence on either allocator, timing
+// every call. Blocks are left live at the end so the heap can be inspected
+static void churn(tlsf_allocator *tlsf, void **blocks, u64 *sizes,
+                  churn_result *result) {
+    rng_state = 0x9E3779B97F4A7C15ull;
+    for (u32 i = 0; i < CHURN_OPERATIONS; ++i) {
+        u32 slot = next_random() % CHURN_SLOTS;
+        f64 start = platform_get_absolute_time();
+        if (blocks[slot]) {
+            if (tlsf) {
+                tlsf_allocator_free(tlsf, blocks[slot]);
+            } else {
+                free(blocks[slot]);
+            }
+            result->free_times[result->frees++] =
+                platform_get_absolute_time() - start;
+            result->live_bytes -= sizes[slot];
+            blocks[slot] = 0;
+            continue;
+        }
+
+        u64 size = churn_size();
+        start = platform_get_absolute_time();
+        blocks[slot] = tlsf ? tlsf_allocator_allocate(tlsf, size)
+                            : malloc(size);
+        result->allocate_times[result->allocations++] =
+            platform_get_absolute_time() - start;
+        if (!blocks[slot]) {
+            result->failures++;
+            continue;
+        }
+        // Touch the block, as a real caller would
+        *(u8 *)blocks[slot] = 1;
+        sizes[slot] = size;
+        result->live_bytes += size;
+    }
+
+    qsort(result->allocate_times, result->allocations, sizeof(f64),
+          compare_f64);
+    qsort(result->free_times, result->frees, sizeof(f64), compare_f64);
+}
+
+static void report_latency(const char *name, const char *operation,
+                           const f64 *times, u32 count) {
+    KINFO("%s %s: p50 %.0f ns, p99 %.0f ns, max %.0f ns", name, operation,
+          times[count / 2] * 1e9, times[(u64)count * 99 / 100] * 1e9,
+          times[count - 1] * 1e9);
+}
+
+// Compares the TLSF heap with malloc on one workload. Latencies include the
+// cost of reading the clock, the same for both
+static b8 kmemory_benchmark_tlsf_vs_malloc() {
+    u64 times_size = CHURN_OPERATIONS * sizeof(f64);
+    void **blocks = kallocate(CHURN_SLOTS * sizeof(void *), MEMORY_TAG_ARRAY);
+    u64 *sizes = kallocate(CHURN_SLOTS * sizeof(u64), MEMORY_TAG_ARRAY);
+    churn_result result = {0};
+    result.allocate_times = kallocate(times_size, MEMORY_TAG_ARRAY);
+    result.free_times = kallocate(times_size, MEMORY_TAG_ARRAY);
+
+    tlsf_allocator tlsf;
+    expect_true(tlsf_allocator_create(CHURN_POOL_SIZE, 0, &tlsf));
+    churn(&tlsf, blocks, sizes, &result);
+    report_latency("tlsf", "allocate", result.allocate_times,
+                   result.allocations);
+    report_latency("tlsf", "free", result.free_times, result.frees);
+    // Overhead is what live blocks cost beyond their requested size;
+    // fragmentation is the share of free space not in the largest block
+    u64 used = tlsf.total_size - tlsf.free_space;
+    u64 largest = tlsf_allocator_largest_free_block(&tlsf);
+    KINFO("tlsf heap: %llu live bytes, %.1f%% overhead, %.2f%% of free space "
+          "fragmented, %u failed allocations",
+          result.live_bytes,
+          100.0 * (f64)(used - result.live_bytes) / (f64)result.live_bytes,
+          100.0 * (1.0 - (f64)largest / (f64)tlsf.free_space),
+          result.failures);
+    tlsf_allocator_destroy(&tlsf);
+
+    kzero_memory(blocks, CHURN_SLOTS * sizeof(void *));
+    result.allocations = 0;
+    result.frees = 0;
+    result.failures = 0;
+    result.live_bytes = 0;
+    // The rest of the process uses malloc too; only the change counts
+    struct mallinfo2 baseline = mallinfo2();
+    churn(0, blocks, sizes, &result);
+    report_latency("malloc", "allocate", result.allocate_times,
+                   result.allocations);
+    report_latency("malloc", "free", result.free_times, result.frees);
+    // malloc's view: bytes in use including its headers, and free bytes it
+    // holds on to inside its arena
+    struct mallinfo2 info = mallinfo2();
+    u64 in_use = info.uordblks + info.hblkhd - baseline.uordblks -
+                 baseline.hblkhd;
+    KINFO("malloc heap: %llu live bytes, %.1f%% overhead, %lld free bytes "
+          "held in the arena",
+          result.live_bytes,
+          100.0 * (f64)(in_use - result.live_bytes) / (f64)result.live_bytes,
+          (i64)info.fordblks - (i64)baseline.fordblks);
+    for (u32 i = 0; i < CHURN_SLOTS; ++i) {
+        free(blocks[i]);
+    }
+
+    kfree(result.allocate_times, times_size, MEMORY_TAG_ARRAY);
+    kfree(result.free_times, times_size, MEMORY_TAG_ARRAY);
+    kfree(blocks, CHURN_SLOTS * sizeof(void *), MEMORY_TAG_ARRAY);
+    kfree(sizes, CHURN_SLOTS * sizeof(u64), MEMORY_TAG_ARRAY);
+    return TRUE;
+}
+
+// The page walk touches one cache line in every 4 KiB page of the block, in
+// a random order, so with small pages nearly every access misses the TLB
+#define TLB_BLOCK_SIZE (256ull * 1024 * 1024)
+#define TLB_PAGE_SIZE 4096
+#define TLB_PAGE_COUNT (u32)(TLB_BLOCK_SIZE / TLB_PAGE_SIZE)
+#define TLB_STEPS (4u * 1024 * 1024)
+
+// Where the walk reads in a page. Spread over the lines of a page so that the
+// cache sets are used evenly
+static u32 *walk_slot(u8 *block, u32 page) {
+    return (u32 *)(block + (u64)page * TLB_PAGE_SIZE + (page % 64) * 64);
+}
+
+// Links every page into one random cycle, each page holding the next
+static void build_walk(u8 *block) {
+    u32 *next = kallocate(TLB_PAGE_COUNT * sizeof(u32), MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < TLB_PAGE_COUNT; ++i) {
+        next[i] = i;
+    }
+    // Sattolo's shuffle, which always gives a single cycle
+    for (u32 i = TLB_PAGE_COUNT - 1; i > 0; --i) {
+        u32 j = (u32)(next_random() % i);
+        u32 swapped = next[i];
+        next[i] = next[j];
+        next[j] = swapped;
+    }
+    for (u32 i = 0; i < TLB_PAGE_COUNT; ++i) {
+        *walk_slot(block, i) = next[i];
+    }
+    kfree(next, TLB_PAGE_COUNT * sizeof(u32), MEMORY_TAG_ARRAY);
+}
+
+// Data TLB read misses in user space, from the CPU's counters. Fails where
+// perf events are not allowed, e.g. in most containers
+static int open_dtlb_miss_counter() {
+    struct perf_event_attr attr = {0};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+typedef struct walk_result {
+    f64 time_per_access;
+    // -1 when the counter is unavailable
+    f64 misses_per_access;
+} walk_result;
+
+static walk_result walk(u8 *block) {
+    int counter = open_dtlb_miss_counter();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    f64 start = platform_get_absolute_time();
+    u32 page = 0;
+    for (u32 i = 0; i < TLB_STEPS; ++i) {
+        page = *walk_slot(block, page);
+    }
+    f64 elapsed = platform_get_absolute_time() - start;
+
+    walk_result result = {elapsed / TLB_STEPS, -1};
+    u64 misses = 0;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) == sizeof(misses)) {
+            result.misses_per_access = (f64)misses / TLB_STEPS;
+        }
+        close(counter);
+    }
+    // Keeps the walk from being optimized away
+    if (page >= TLB_PAGE_COUNT) {
+        result.time_per_access = 0;
+    }
+    return result;
+}
+
+// How much of the process is on transparent huge pages right now
+static u64 anonymous_huge_page_bytes() {
+    FILE *file = fopen("/proc/self/smaps_rollup", "r");
+    if (!file) {
+        return 0;
+    }
+    char line[256];
+    u64 kib = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "AnonHugePages: %llu kB", &kib) == 1) {
+            break;
+        }
+    }
+    fclose(file);
+    return kib * 1024;
+}
+
+static void report_walk(const char *name, walk_result result) {
+    if (result.misses_per_access >= 0) {
+        KINFO("  %s: %.1f ns per access, %.2f dTLB misses per access", name,
+              result.time_per_access * 1e9, result.misses_per_access);
+    } else {
+        KINFO("  %s: %.1f ns per access (dTLB counter unavailable)", name,
+              result.time_per_access * 1e9);
+    }
+}
+
+static b8 kmemory_benchmark_huge_page_tlb() {
+    // Small pages: an ordinary mapping the kernel is told not to back with
+    // huge pages
+    u8 *small = platform_reserve_memory(TLB_BLOCK_SIZE);
+    expect_true(small);
+    expect_true(platform_commit_memory(small, TLB_BLOCK_SIZE));
+    madvise(small, TLB_BLOCK_SIZE, MADV_NOHUGEPAGE);
+    build_walk(small);
+    walk_result small_result = walk(small);
+    platform_release_memory(small, TLB_BLOCK_SIZE);
+
+    // A large kallocate, which asks for huge pages
+    u64 huge_before = anonymous_huge_page_bytes();
+    u8 *large = kallocate(TLB_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_true(large);
+    build_walk(large);
+    u64 huge_bytes = anonymous_huge_page_bytes() - huge_before;
+    walk_result large_result = walk(large);
+    kfree(large, TLB_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+
+    KINFO("random page walk over %llu MiB, %u accesses:",
+          TLB_BLOCK_SIZE / (1024 * 1024), TLB_STEPS);
+    report_walk("4 KiB pages", small_result);
+    report_walk("kallocate", large_result);
+    KINFO("  %.0f%% of the kallocate block was on transparent huge pages",
+          100.0 * huge_bytes / TLB_BLOCK_SIZE);
+    return TRUE;
+}
+
+void kmemory_register_benchmarks() {
+    test_manager_register_test(kmemory_benchmark_tlsf_vs_malloc,
+                               "tlsf: latency and fragmentation against "
+                               "malloc");
+    test_manager_register_test(kmemory_benchmark_huge_page_tlb,
+                               "kmemory: TLB misses on huge-page large "
+                               "allocations");
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+void kmemory_register_tests();
+void kmemory_register_benchmarks();
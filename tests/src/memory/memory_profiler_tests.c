@@ -0,0 +1,71 @@
+#include "memory_profiler_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <core/kmemory.h>
+#include <core/memory_profiler.h>
+#include <platform/platform.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROFILE_PATH "memory_profiler_test.heap"
+
+// An odd size, so the sample's line is easy to pick out of the report
+#define PROFILED_SIZE 12347
+
+// Reads the report into a zero-terminated string allocated with kallocate
+static char *read_report(u64 *out_size) {
+    *out_size = 0;
+    if (!memory_profiler_write_report(PROFILE_PATH) ||
+        !platform_get_file_size(PROFILE_PATH, out_size)) {
+        return 0;
+    }
+
+    char *report = kallocate(*out_size + 1, MEMORY_TAG_STRING);
+    if (!platform_read_file(PROFILE_PATH, report, *out_size)) {
+        kfree(report, *out_size + 1, MEMORY_TAG_STRING);
+        return 0;
+    }
+    return report;
+}
+
+static b8 memory_profiler_reports_sampled_allocation() {
+    // A one-byte interval samples every allocation
+    expect_true(memory_profiler_start(1, 0));
+    void *block = kallocate(PROFILED_SIZE, MEMORY_TAG_GAME);
+    memory_profiler_stop();
+    expect_true(block != 0);
+
+    u64 size;
+    char *report = read_report(&size);
+    expect_true(report != 0);
+    expect_true(strncmp(report, "heap profile: ", 14) == 0);
+    expect_true(strstr(report, "@ heap_v2/1\n") != 0);
+
+    // The live sample shows up under its call site, with a backtrace
+    char expected_site[64];
+    snprintf(expected_site, sizeof(expected_site), "\n1: %d [1: %d] @ 0x",
+             PROFILED_SIZE, PROFILED_SIZE);
+    expect_true(strstr(report, expected_site) != 0);
+    expect_true(strstr(report, "\nMAPPED_LIBRARIES:\n") != 0);
+    kfree(report, size + 1, MEMORY_TAG_STRING);
+
+    // Frees are tracked after stopping, so the site has no live bytes left
+    kfree(block, PROFILED_SIZE, MEMORY_TAG_GAME);
+    report = read_report(&size);
+    expect_true(report != 0);
+    snprintf(expected_site, sizeof(expected_site), "\n0: 0 [1: %d] @ 0x",
+             PROFILED_SIZE);
+    expect_true(strstr(report, expected_site) != 0);
+    kfree(report, size + 1, MEMORY_TAG_STRING);
+
+    remove(PROFILE_PATH);
+    return TRUE;
+}
+
+void memory_profiler_register_tests() {
+    test_manager_register_test(memory_profiler_reports_sampled_allocation,
+                               "memory_profiler: a sampled allocation appears "
+                               "in the heap_v2 report");
+}
@@ -0,0 +1,78 @@
+#include "scratch_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <core/kmemory.h>
+#include <core/scratch_allocator.h>
+#include <pthread.h>
+
+#define SCRATCH_ROUNDS 16
+#define SCRATCH_THREADS 4
+#define SCRATCH_BYTES (3 * 1024 * 1024)
+
+// Leaves its allocations in place; exiting releases the whole stack
+static void *scratch_thread_main(void *arg) {
+    u8 *first = scratch_allocate(SCRATCH_BYTES);
+    u8 *second = scratch_allocate(64);
+    if (first && second) {
+        first[SCRATCH_BYTES - 1] = 1;
+        second[0] = 1;
+    }
+    return 0;
+}
+
+static b8 scratch_stacks_released_at_thread_exit() {
+    memory_tag_stats before[MEMORY_TAG_MAX_TAGS];
+    memory_get_tag_stats(before);
+    memory_tag_stats *b = &before[MEMORY_TAG_SCRATCH];
+
+    // Threads exiting together, while others start, hand back and take over
+    // stat shards at the same time as their stacks are released
+    for (u32 round = 0; round < SCRATCH_ROUNDS; ++round) {
+        pthread_t threads[SCRATCH_THREADS];
+        for (u32 i = 0; i < SCRATCH_THREADS; ++i) {
+            expect_should_be(0, pthread_create(&threads[i], 0,
+                                               scratch_thread_main, 0));
+        }
+        for (u32 i = 0; i < SCRATCH_THREADS; ++i) {
+            pthread_join(threads[i], 0);
+        }
+
+        memory_tag_stats after[MEMORY_TAG_MAX_TAGS];
+        memory_get_tag_stats(after);
+        memory_tag_stats *a = &after[MEMORY_TAG_SCRATCH];
+        expect_should_be(b->current_bytes, a->current_bytes);
+        expect_should_be((round + 1) * SCRATCH_THREADS,
+                         a->allocation_count - b->allocation_count);
+        expect_should_be(a->allocation_count - b->allocation_count,
+                         a->free_count - b->free_count);
+    }
+    return TRUE;
+}
+
+static b8 scratch_end_rewinds() {
+    scratch_marker outer = scratch_begin();
+    u8 *first = scratch_allocate(100);
+    expect_true(first != 0);
+
+    scratch_marker inner = scratch_begin();
+    u8 *second = scratch_allocate(1000);
+    expect_true(second > first);
+    scratch_end(inner);
+
+    // Memory released by the inner scope is handed out again
+    expect_true(scratch_allocate(1000) == second);
+    scratch_end(outer);
+    expect_true(scratch_allocate(100) == first);
+    scratch_end(outer);
+    return TRUE;
+}
+
+void scratch_register_tests() {
+    test_manager_register_test(scratch_stacks_released_at_thread_exit,
+                               "scratch: stacks are released and accounted "
+                               "as threads exit");
+    test_manager_register_test(scratch_end_rewinds,
+                               "scratch: ending a scope rewinds the stack");
+}
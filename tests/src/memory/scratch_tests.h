@@ -0,0 +1,3 @@
+#pragma once
+
+void scratch_register_tests();
@@ -0,0 +1,48 @@
+#include "test_manager.h"
+
+#include <containers/darray.h>
+#include <core/clock.h>
+#include <core/logger.h>
+
+typedef struct test_entry {
+    PFN_test func;
+    const char *description;
+} test_entry;
+
+static test_entry *tests;
+
+void test_manager_init() { tests = darray_create(test_entry); }
+
+void test_manager_register_test(PFN_test test, const char *description) {
+    test_entry entry;
+    entry.func = test;
+    entry.description = description;
+    darray_push(tests, entry);
+}
+
+u32 test_manager_run_tests() {
+    u32 passed = 0;
+    u32 failed = 0;
+    u32 count = (u32)darray_length(tests);
+
+    for (u32 i = 0; i < count; ++i) {
+        clock test_time;
+        clock_start(&test_time);
+        b8 result = tests[i].func();
+        clock_update(&test_time);
+
+        if (result) {
+            passed++;
+        } else {
+            KERROR("[FAILED]: %s", tests[i].description);
+            failed++;
+        }
+        KINFO("Executed %u of %u (%u failed) %.4f sec: %s", i + 1, count,
+              failed, test_time.elapsed, tests[i].description);
+    }
+
+    KINFO("Results: %u passed, %u failed.", passed, failed);
+    darray_destroy(tests);
+    tests = 0;
+    return failed;
+}
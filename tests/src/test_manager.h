@@ -0,0 +1,20 @@
+#pragma once
+
+#include <defines.h>
+
+typedef b8 (*PFN_test)();
+
+void test_manager_init();
+
+/**
+ * Adds a test to run
+ * @param test The test function. Returns TRUE if the test passed
+ * @param description What the test checks, printed with its result
+ */
+void test_manager_register_test(PFN_test test, const char *description);
+
+/**
+ * Runs every registered test in registration order
+ * @returns The number of tests that failed
+ */
+u32 test_manager_run_tests();